@@ -0,0 +1,1534 @@
+#include "AssetRegistry.h"
+#include "GlState.h"
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "ObjParser.h"
+#include <stb_image.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	double millisecondsBetween(Clock::time_point start, Clock::time_point end)
+	{
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+
+	std::string canonicalPath(const std::string& path)
+	{
+		std::error_code ec;
+		std::filesystem::path canonical = std::filesystem::weakly_canonical(path, ec);
+		return ec ? path : canonical.generic_string();
+	}
+
+	// FNV-1a de 64 bits sobre o conteúdo mapeado do arquivo (0 se não existir)
+	uint64_t hashFile(const std::string& path)
+	{
+		MappedFile file;
+		if (!file.open(path))
+		{
+			return 0;
+		}
+
+		uint64_t hash = 0xCBF29CE484222325ull;
+		const unsigned char* data = reinterpret_cast<const unsigned char*>(file.data());
+		for (size_t i = 0; i < file.size(); ++i)
+		{
+			hash = (hash ^ data[i]) * 0x100000001B3ull;
+		}
+		return hash;
+	}
+
+	// Maior distância de um vértice até o centro (posição nos 3 primeiros floats)
+	float boundingRadius(const GLfloat* vertices, GLuint vertexCount, const glm::vec3& center)
+	{
+		float radiusSquared = 0.0f;
+		for (GLuint i = 0; i < vertexCount; ++i)
+		{
+			const GLfloat* position = vertices + i * VERTEX_FLOATS;
+			glm::vec3 offset = glm::vec3(position[0], position[1], position[2]) - center;
+			radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+		}
+		return std::sqrt(radiusSquared);
+	}
+
+	// Os maiores triângulos da malha: ficam em cima da superfície real, então
+	// nunca escondem algo que a própria malha não esconderia
+	std::vector<glm::vec3> largestTriangles(const GLfloat* vertices, const GLuint* indices, GLuint indexCount, size_t count)
+	{
+		auto position = [&](GLuint i)
+			{
+				const GLfloat* p = vertices + indices[i] * VERTEX_FLOATS;
+				return glm::vec3(p[0], p[1], p[2]);
+			};
+
+		std::vector<std::pair<float, GLuint>> areas;
+		areas.reserve(indexCount / 3);
+		for (GLuint i = 0; i + 2 < indexCount; i += 3)
+		{
+			glm::vec3 a = position(i), b = position(i + 1), c = position(i + 2);
+			areas.emplace_back(glm::length(glm::cross(b - a, c - a)), i);
+		}
+		count = std::min(count, areas.size());
+		std::partial_sort(areas.begin(), areas.begin() + count, areas.end(),
+			[](const std::pair<float, GLuint>& x, const std::pair<float, GLuint>& y) { return x.first > y.first; });
+
+		std::vector<glm::vec3> triangles;
+		triangles.reserve(count * 3);
+		for (size_t t = 0; t < count; ++t)
+		{
+			for (GLuint corner = 0; corner < 3; ++corner)
+			{
+				triangles.push_back(position(areas[t].second + corner));
+			}
+		}
+		return triangles;
+	}
+
+	std::string directoryOf(const std::string& path)
+	{
+		return path.substr(0, path.find_last_of("/"));
+	}
+
+	std::string mtlPathFor(const std::string& objPath)
+	{
+		std::string filenameNoExt = objPath.substr(objPath.find_last_of("/") + 1);
+		filenameNoExt = filenameNoExt.substr(0, filenameNoExt.find_last_of("."));
+		return directoryOf(objPath) + "/" + filenameNoExt + ".mtl";
+	}
+
+	// OBJ + MTL: o mesmo modelo copiado para outro caminho tem o mesmo hash.
+	// Com um .gbmesh válido o hash vem do cabeçalho, sem ler o texto
+	uint64_t meshContentHash(const std::string& objPath)
+	{
+		uint64_t hash = 0;
+		if (MeshCache::readContentHash(MeshCache::cachePathFor(objPath), objPath, mtlPathFor(objPath), hash))
+		{
+			return hash;
+		}
+		hash = hashFile(objPath);
+		if (hash != 0)
+		{
+			hash ^= hashFile(mtlPathFor(objPath)) * 0x9E3779B97F4A7C15ull;
+		}
+		return hash;
+	}
+
+	// Faz o parsing do OBJ e solda os vértices. Roda em jobs: as mensagens
+	// vão para log/errors e são impressas no envio
+	bool buildMesh(const std::string& objPath, MeshData& mesh, std::ostream& log, std::ostream& errors)
+	{
+		ObjData obj;
+		ObjParseStats stats;
+
+		if (!ObjParser::parseFile(objPath, obj, &stats))
+		{
+			errors << "Failed to open file: " << objPath << std::endl;
+			return false;
+		}
+
+		log << "Parsed geometry: " << objPath << " (" << stats.bytes / 1024.0 << " KB in " << stats.milliseconds
+			<< " ms, " << stats.megabytesPerSecond() << " MB/s, " << stats.jobs << " jobs)" << std::endl;
+
+		MeshBuilder::build(obj, mesh);
+
+		size_t unweldedBytes = obj.corners.size() * VERTEX_FLOATS * sizeof(GLfloat);
+		size_t weldedBytes = mesh.vertices.size() * sizeof(GLfloat) + mesh.indices.size() * sizeof(GLuint);
+		log << "Welded vertices: " << obj.corners.size() << " -> " << mesh.vertexCount()
+			<< " (" << unweldedBytes << " -> " << weldedBytes << " bytes)" << std::endl;
+		return true;
+	}
+}
+
+// Parte da carga de uma malha que não precisa do contexto GL
+struct AssetRegistry::DecodedMesh
+{
+	std::string path;
+	std::string mtlPath;
+	bool valid = false;
+	// Com um .gbmesh válido os dados vêm do arquivo mapeado; senão, do OBJ
+	bool fromCache = false;
+	MeshCache::CachedMesh cached;
+	MeshData mesh;
+	GLuint vertexCount = 0;
+	GLuint indexCount = 0;
+	glm::vec3 boundsMin = glm::vec3(0.0f);
+	glm::vec3 boundsMax = glm::vec3(0.0f);
+	glm::vec3 boundsCenter = glm::vec3(0.0f);
+	float boundsRadius = 0.0f;
+	std::vector<glm::vec3> occluder;
+	// O material da malha (a primeira entrada) e o MTL inteiro para o MaterialTable
+	bool hasMaterial = false;
+	Material material;
+	bool libraryLoaded = false;
+	std::string libraryKey;
+	std::vector<std::string> libraryNames;
+	std::vector<Material> library;
+	std::string log;
+	std::string errors;
+	Clock::time_point start, end;
+
+	const void* vertexData() const { return fromCache ? cached.vertexData() : mesh.vertices.data(); }
+	const GLuint* indexData() const { return fromCache ? cached.indexData() : mesh.indices.data(); }
+	// Textura difusa pedida pelo MTL, ou vazio
+	std::string texturePath() const
+	{
+		if (!hasMaterial || !libraryLoaded || material.diffuseTexture.empty())
+		{
+			return std::string();
+		}
+		return directoryOf(path) + "/" + material.diffuseTexture;
+	}
+};
+
+struct AssetRegistry::DecodedTexture
+{
+	std::string path;
+	std::unique_ptr<unsigned char, void (*)(void*)> pixels{ nullptr, stbi_image_free };
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	uint64_t contentHash = 0;
+	Clock::time_point start, end;
+};
+
+// Um loadMeshes em andamento. Os jobs só escrevem no próprio Decoded* e
+// avisam pela fila ready; registro, GeometryPool e MaterialTable só são
+// mexidos pela thread que chama pumpBatch()
+struct AssetRegistry::Batch
+{
+	struct PendingMesh
+	{
+		std::string path;
+		std::string key;
+		uint64_t contentHash = 0;
+		std::vector<std::string> aliases;   // outros caminhos com o mesmo conteúdo
+		std::vector<size_t> requests;       // posições em objPaths
+		DecodedMesh decoded;
+		std::shared_ptr<GpuMesh> mesh;
+		bool waitingTexture = false;        // pediu uma textura que ainda está pendente
+		// Streaming: o que as entidades desenham até a malha ficar pronta, a
+		// faixa reservada no GeometryPool e quanto dela já foi enviado
+		std::shared_ptr<GpuMesh> current;
+		std::vector<size_t> followers;      // pendentes com o mesmo conteúdo em outro caminho
+		std::shared_ptr<Texture> texture;
+		MeshRange range;
+		size_t vertexBytesSent = 0;
+		size_t indicesSent = 0;
+		bool uploaded = false;
+		int reportIndex = -1;
+	};
+
+	struct PendingTexture
+	{
+		std::string path;
+		std::string key;
+		std::vector<size_t> meshes;         // malhas pendentes que usam esta textura
+		int parent = -1;                    // no relatório
+		DecodedTexture decoded;
+		bool done = false;
+		// Streaming: a textura já criada, enchida por faixas de linhas
+		std::shared_ptr<Texture> texture;
+		int rowsSent = 0;
+		int reportIndex = -1;
+	};
+
+	Clock::time_point start;
+	bool streaming = false;
+	std::vector<std::shared_ptr<GpuMesh>> result;
+	std::vector<PendingMesh> meshes;
+	// deque: os jobs guardam ponteiros para as texturas enquanto outras entram
+	std::deque<PendingTexture> textures;
+	std::unordered_map<std::string, size_t> textureByKey;
+	size_t outstanding = 0;
+	// Streaming: a primeira pendente com cada conteúdo e os assets que já
+	// chegaram e esperam a vez de enviar, na ordem de chegada
+	std::unordered_map<uint64_t, size_t> meshByHash;
+	std::deque<std::pair<bool, size_t>> uploads;
+
+	std::mutex readyMutex;
+	std::condition_variable readyCondition;
+	std::vector<std::pair<bool, size_t>> ready;   // (é textura, índice)
+	std::vector<std::pair<bool, size_t>> draining;
+
+	// Chamado pelo job no fim; avisa ainda com a trava, porque o lote pode
+	// ser destruído assim que o último resultado for enviado
+	void finished(bool texture, size_t index)
+	{
+		std::lock_guard<std::mutex> lock(readyMutex);
+		ready.emplace_back(texture, index);
+		readyCondition.notify_one();
+	}
+
+	void waitReady()
+	{
+		std::unique_lock<std::mutex> lock(readyMutex);
+		readyCondition.wait(lock, [this]() { return !ready.empty(); });
+	}
+};
+
+AssetRegistry::AssetRegistry() = default;
+AssetRegistry::~AssetRegistry() = default;
+
+std::shared_ptr<GpuMesh> AssetRegistry::loadMesh(const std::string& objPath)
+{
+	return loadMeshes({ objPath }).front();
+}
+
+std::vector<std::shared_ptr<GpuMesh>> AssetRegistry::loadMeshes(const std::vector<std::string>& objPaths)
+{
+	beginBatch(objPaths, false);
+
+	// Sem workers esta thread também decodifica; com eles ela só espera o
+	// próximo resultado, para enviar cada um assim que ele chega
+	JobSystem& jobs = JobSystem::get();
+	bool helping = jobs.getThreadCount() == 1;
+	while (!pumpBatch())
+	{
+		if (!helping)
+		{
+			m_batch->waitReady();
+		}
+		else if (!jobs.help())
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	std::vector<std::shared_ptr<GpuMesh>> result = std::move(m_batch->result);
+	m_batch.reset();
+	return result;
+}
+
+std::vector<std::shared_ptr<GpuMesh>> AssetRegistry::streamMeshes(const std::vector<std::string>& objPaths)
+{
+	// A caixa unitária, a textura e o material dos placeholders, criados uma
+	// vez. Só o termo ambiente: as caixas são cinza sob qualquer luz
+	if (!m_placeholder)
+	{
+		Material material;
+		material.ka = glm::vec3(0.7f);
+		m_placeholderMaterial = m_materials.add(material);
+		const unsigned char gray[4] = { 160, 160, 160, 255 };
+		m_placeholderTexture = std::make_shared<Texture>();
+		m_placeholderTexture->path = "placeholder";
+		m_placeholderTexture->width = m_placeholderTexture->height = 1;
+		glGenTextures(1, &m_placeholderTexture->id);
+		GlState::get().bindTexture(GL_TEXTURE_2D, m_placeholderTexture->id);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, gray);
+		GlState::get().bindTexture(GL_TEXTURE_2D, 0);
+		m_placeholder = createBox(glm::vec3(-0.5f), glm::vec3(0.5f));
+	}
+	m_staging.init(STAGING_BYTES);
+	m_streamStats = StreamStats();
+
+	beginBatch(objPaths, true);
+	Batch& batch = *m_batch;
+	m_streamStats.pending = static_cast<unsigned>(batch.outstanding);
+	return batch.result;
+}
+
+void AssetRegistry::pumpStreaming(double budgetMilliseconds)
+{
+	if (!m_batch)
+	{
+		releaseBoxes(false);
+		return;
+	}
+
+	auto start = Clock::now();
+	Batch& batch = *m_batch;
+	m_staging.retire();
+	releaseBoxes(false);
+	{
+		std::lock_guard<std::mutex> lock(batch.readyMutex);
+		batch.draining.swap(batch.ready);
+	}
+	for (auto [texture, index] : batch.draining)
+	{
+		batch.outstanding--;
+		if (texture)
+		{
+			arriveTexture(index);
+		}
+		else
+		{
+			arriveMesh(index);
+		}
+	}
+	batch.draining.clear();
+
+	// Um pedaço por vez enquanto sobra orçamento (o último pode passar um
+	// pouco, e ao menos um vai por quadro); com o anel cheio o resto fica
+	// para o próximo quadro
+	bool stalled = false;
+	for (size_t slices = 0; !batch.uploads.empty(); ++slices)
+	{
+		if (slices > 0 && millisecondsBetween(start, Clock::now()) >= budgetMilliseconds)
+		{
+			break;
+		}
+		if (!streamSlice())
+		{
+			stalled = true;
+			break;
+		}
+	}
+	m_staging.fence();
+
+	double milliseconds = millisecondsBetween(start, Clock::now());
+	m_streamStats.frames++;
+	m_streamStats.stalledFrames += stalled ? 1 : 0;
+	m_streamStats.pending = static_cast<unsigned>(batch.outstanding + batch.uploads.size());
+	m_streamStats.lastPumpMilliseconds = milliseconds;
+	m_streamStats.maxPumpMilliseconds = std::max(m_streamStats.maxPumpMilliseconds, milliseconds);
+	m_streamStats.budgetMilliseconds = budgetMilliseconds;
+
+	if (batch.outstanding == 0 && batch.uploads.empty())
+	{
+		finishReport();
+		std::cout << "Streaming: all assets resident after " << m_streamStats.frames << " frames, "
+			<< m_report.wallMilliseconds << " ms (at most " << m_streamStats.maxPumpMilliseconds << " ms per frame for a "
+			<< budgetMilliseconds << " ms budget, " << m_streamStats.stalledFrames << " frames waiting for the staging ring)" << std::endl;
+		if (m_logging)
+		{
+			printLoadReport();
+		}
+		m_batch.reset();
+	}
+}
+
+void AssetRegistry::takeSwaps(std::vector<MeshSwap>& out)
+{
+	out.clear();
+	std::lock_guard<std::mutex> lock(m_swapMutex);
+	out.swap(m_swaps);
+}
+
+void AssetRegistry::prefetchMeshes(const std::vector<std::string>& objPaths)
+{
+	std::vector<std::string> unique;
+	std::unordered_set<std::string> seen;
+	for (const std::string& path : objPaths)
+	{
+		if (m_prefetched.count(path) == 0 && seen.insert(path).second)
+		{
+			unique.push_back(path);
+		}
+	}
+
+	// Um job por arquivo; m_meshes só é lido enquanto eles rodam
+	std::vector<std::pair<std::string, uint64_t>> results(unique.size());
+	JobSystem& jobs = JobSystem::get();
+	jobs.wait(jobs.parallelFor(unique.size(), 1, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				results[i].first = canonicalPath(unique[i]);
+				results[i].second = m_meshes.count(results[i].first) ? 0 : meshContentHash(unique[i]);
+			}
+		}));
+	for (size_t i = 0; i < unique.size(); ++i)
+	{
+		m_prefetched[unique[i]] = std::move(results[i]);
+	}
+}
+
+std::shared_ptr<Texture> AssetRegistry::loadTexture(const std::string& path)
+{
+	std::string key = canonicalPath(path);
+	auto found = m_textures.find(key);
+	if (found != m_textures.end())
+	{
+		m_stats.textureHits++;
+		return found->second.asset;
+	}
+
+	uint64_t hash = hashFile(path);
+	if (hash != 0)
+	{
+		auto sameContent = m_textureByHash.find(hash);
+		if (sameContent != m_textureByHash.end())
+		{
+			m_stats.textureHits++;
+			Entry<Texture> entry = m_textures[sameContent->second];
+			m_textures[key] = entry;
+			return entry.asset;
+		}
+	}
+
+	m_stats.textureMisses++;
+	DecodedTexture decoded;
+	decodeTexture(path, decoded);
+	std::shared_ptr<Texture> texture = uploadTexture(decoded);
+	if (!texture)
+	{
+		return nullptr;
+	}
+
+	m_textures[key] = { texture, hash };
+	if (hash != 0)
+	{
+		m_textureByHash[hash] = key;
+	}
+	return texture;
+}
+
+void AssetRegistry::decodeMesh(const std::string& objPath, uint64_t contentHash, DecodedMesh& out)
+{
+	out.start = Clock::now();
+	out.path = objPath;
+	out.mtlPath = mtlPathFor(objPath);
+	std::string cachePath = MeshCache::cachePathFor(objPath);
+	std::ostringstream log, errors;
+
+	// Com um .gbmesh válido os dados vão do arquivo mapeado direto para a GPU;
+	// senão o OBJ é lido e o cache é (re)gerado
+	if (out.cached.open(cachePath, objPath, out.mtlPath))
+	{
+		const MeshCache::Header& header = out.cached.header();
+		out.fromCache = true;
+		out.vertexCount = header.vertexCount;
+		out.indexCount = header.indexCount;
+		out.boundsMin = out.cached.boundsMin();
+		out.boundsMax = out.cached.boundsMax();
+		out.boundsRadius = out.cached.boundsRadius();
+		out.cached.occluder(out.occluder);
+		// O MTL também vem do cache: nenhum arquivo de texto é lido
+		out.libraryLoaded = out.cached.hasMaterial();
+		if (out.libraryLoaded)
+		{
+			out.cached.library(out.libraryNames, out.library);
+		}
+		log << "Loaded mesh cache: " << cachePath << " (" << header.vertexCount << " vertices)" << std::endl;
+	}
+	else
+	{
+		out.libraryLoaded = MaterialTable::parseLibrary(out.mtlPath, out.libraryNames, out.library);
+		if (!buildMesh(objPath, out.mesh, log, errors))
+		{
+			out.errors = errors.str();
+			out.end = Clock::now();
+			return;
+		}
+		out.vertexCount = static_cast<GLuint>(out.mesh.vertexCount());
+		out.indexCount = static_cast<GLuint>(out.mesh.indices.size());
+		out.boundsMin = out.mesh.boundsMin;
+		out.boundsMax = out.mesh.boundsMax;
+
+		// Esfera e oclusores vão para o cache: as próximas cargas não passam
+		// pelos triângulos
+		const GLfloat* vertices = out.mesh.vertices.data();
+		out.boundsRadius = boundingRadius(vertices, out.vertexCount, (out.boundsMin + out.boundsMax) * 0.5f);
+		out.occluder = largestTriangles(vertices, out.mesh.indices.data(), out.indexCount, OCCLUDER_TRIANGLES);
+		if (!MeshCache::write(cachePath, objPath, out.mtlPath, contentHash, out.mesh, out.boundsRadius, out.occluder,
+			out.libraryLoaded, out.libraryNames, out.library))
+		{
+			errors << "Failed to write mesh cache: " << cachePath << std::endl;
+		}
+	}
+
+	// A malha usa a primeira entrada do MTL
+	out.hasMaterial = out.libraryLoaded;
+	if (!out.library.empty())
+	{
+		out.material = out.library.front();
+	}
+
+	out.boundsCenter = (out.boundsMin + out.boundsMax) * 0.5f;
+	out.libraryKey = canonicalPath(out.mtlPath);
+	out.valid = true;
+	out.log = log.str();
+	out.errors = errors.str();
+	out.end = Clock::now();
+}
+
+void AssetRegistry::decodeTexture(const std::string& path, DecodedTexture& out, int channels)
+{
+	out.start = Clock::now();
+	out.path = path;
+	out.pixels.reset(stbi_load(path.c_str(), &out.width, &out.height, &out.channels, channels));
+	if (channels != 0)
+	{
+		out.channels = channels;
+	}
+	out.end = Clock::now();
+}
+
+std::shared_ptr<GpuMesh> AssetRegistry::uploadMesh(DecodedMesh& decoded)
+{
+	if (m_logging)
+	{
+		std::cout << decoded.log;
+	}
+	std::cerr << decoded.errors;
+	if (!decoded.valid)
+	{
+		return nullptr;
+	}
+
+	// Todas as malhas dividem o mesmo VBO/EBO do GeometryPool
+	MeshRange range;
+	if (!m_geometry.allocate(decoded.vertexData(), decoded.vertexCount, decoded.indexData(), decoded.indexCount, range))
+	{
+		std::cerr << "Failed to allocate geometry for: " << decoded.path << std::endl;
+		return nullptr;
+	}
+	return createMesh(decoded, range);
+}
+
+std::shared_ptr<GpuMesh> AssetRegistry::createMesh(DecodedMesh& decoded, const MeshRange& range)
+{
+	auto gpuMesh = std::make_shared<GpuMesh>();
+	gpuMesh->path = decoded.path;
+	gpuMesh->range = range;
+	gpuMesh->boundsMin = decoded.boundsMin;
+	gpuMesh->boundsMax = decoded.boundsMax;
+	gpuMesh->boundsCenter = decoded.boundsCenter;
+	gpuMesh->boundsRadius = decoded.boundsRadius;
+	gpuMesh->occluder = std::move(decoded.occluder);
+
+	gpuMesh->hasMaterial = decoded.hasMaterial;
+	gpuMesh->material = decoded.material;
+	if (!decoded.hasMaterial || !decoded.libraryLoaded)
+	{
+		std::cerr << "Failed to open MTL file: " << decoded.mtlPath << std::endl;
+		return gpuMesh;
+	}
+	m_materials.addLibrary(decoded.libraryKey, decoded.libraryNames, decoded.library, gpuMesh->materialIndex);
+	if (decoded.material.diffuseTexture.empty())
+	{
+		std::cerr << "No diffuse texture found in MTL file: " << decoded.mtlPath << std::endl;
+	}
+	return gpuMesh;
+}
+
+std::shared_ptr<Texture> AssetRegistry::uploadTexture(DecodedTexture& decoded)
+{
+	if (!decoded.pixels)
+	{
+		std::cout << "Failed to load texture" << std::endl;
+		return nullptr;
+	}
+
+	if (m_logging)
+	{
+		std::cout << "Loaded texture: " << decoded.path << " (" << decoded.width << "x" << decoded.height << ")" << std::endl;
+	}
+
+	auto texture = std::make_shared<Texture>();
+	texture->path = decoded.path;
+	texture->width = decoded.width;
+	texture->height = decoded.height;
+
+	glGenTextures(1, &texture->id);
+	GlState::get().bindTexture(GL_TEXTURE_2D, texture->id);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	if (decoded.channels == 3)
+	{
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, decoded.width, decoded.height, 0, GL_RGB, GL_UNSIGNED_BYTE, decoded.pixels.get());
+	}
+	else
+	{
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, decoded.width, decoded.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, decoded.pixels.get());
+	}
+	glGenerateMipmap(GL_TEXTURE_2D);
+
+	decoded.pixels.reset();
+	GlState::get().bindTexture(GL_TEXTURE_2D, 0);
+	return texture;
+}
+
+void AssetRegistry::beginBatch(const std::vector<std::string>& objPaths, bool streaming)
+{
+	m_batch = std::make_unique<Batch>();
+	Batch& batch = *m_batch;
+	batch.start = Clock::now();
+	batch.streaming = streaming;
+	batch.result.resize(objPaths.size());
+	m_report = LoadReport();
+	m_report.threads = JobSystem::get().getThreadCount();
+
+	// Em streaming nada de ler os arquivos antes da primeira imagem: o hash
+	// do conteúdo sai no job, e as cópias em outros caminhos são achadas
+	// quando a decodificação chega
+	if (!streaming)
+	{
+		prefetchMeshes(objPaths);
+	}
+	m_report.prefetchMilliseconds = millisecondsBetween(batch.start, Clock::now());
+	auto keyOf = [&](const std::string& path) -> std::pair<std::string, uint64_t>
+		{
+			return streaming ? std::make_pair(canonicalPath(path), uint64_t(0)) : m_prefetched[path];
+		};
+
+	// Cada pedido é um acerto no registro ou uma malha pendente do lote; a
+	// mesma chave, ou o mesmo conteúdo em outro caminho, reaproveita a pendente
+	std::unordered_map<std::string, size_t> pendingByKey;
+	std::unordered_map<uint64_t, size_t> pendingByHash;
+	for (size_t i = 0; i < objPaths.size(); ++i)
+	{
+		const auto& [key, hash] = keyOf(objPaths[i]);
+		auto found = m_meshes.find(key);
+		if (found != m_meshes.end())
+		{
+			m_stats.meshHits++;
+			m_report.reused++;
+			batch.result[i] = found->second.asset;
+			continue;
+		}
+		auto pendingKey = pendingByKey.find(key);
+		if (pendingKey != pendingByKey.end())
+		{
+			m_stats.meshHits++;
+			m_report.reused++;
+			batch.meshes[pendingKey->second].requests.push_back(i);
+			continue;
+		}
+		if (hash != 0)
+		{
+			auto sameContent = m_meshByHash.find(hash);
+			if (sameContent != m_meshByHash.end())
+			{
+				m_stats.meshHits++;
+				m_report.reused++;
+				Entry<GpuMesh> entry = m_meshes[sameContent->second];
+				m_meshes[key] = entry;
+				batch.result[i] = entry.asset;
+				continue;
+			}
+			auto pendingHash = pendingByHash.find(hash);
+			if (pendingHash != pendingByHash.end())
+			{
+				m_stats.meshHits++;
+				m_report.reused++;
+				Batch::PendingMesh& pending = batch.meshes[pendingHash->second];
+				pending.aliases.push_back(key);
+				pending.requests.push_back(i);
+				pendingByKey[key] = pendingHash->second;
+				continue;
+			}
+		}
+
+		m_stats.meshMisses++;
+		pendingByKey[key] = batch.meshes.size();
+		if (hash != 0)
+		{
+			pendingByHash[hash] = batch.meshes.size();
+		}
+		Batch::PendingMesh pending;
+		pending.path = objPaths[i];
+		pending.key = key;
+		pending.contentHash = hash;
+		pending.requests.push_back(i);
+		batch.meshes.push_back(std::move(pending));
+	}
+
+	// Em streaming cada malha pendente começa com a sua cópia da caixa
+	// unitária: as trocas são por ponteiro, então cada uma precisa da sua
+	if (streaming)
+	{
+		for (Batch::PendingMesh& pending : batch.meshes)
+		{
+			pending.current = std::make_shared<GpuMesh>(*m_placeholder);
+			pending.current->path = pending.path;
+			for (size_t request : pending.requests)
+			{
+				batch.result[request] = pending.current;
+			}
+		}
+	}
+
+	// A lista de malhas não muda mais: cada job escreve só no seu DecodedMesh
+	// (e, em streaming, no hash do conteúdo)
+	JobSystem& jobs = JobSystem::get();
+	batch.outstanding = batch.meshes.size();
+	for (size_t m = 0; m < batch.meshes.size(); ++m)
+	{
+		jobs.schedule([&batch, m]()
+			{
+				Batch::PendingMesh& pending = batch.meshes[m];
+				if (batch.streaming)
+				{
+					pending.contentHash = meshContentHash(pending.path);
+				}
+				decodeMesh(pending.path, pending.contentHash, pending.decoded);
+				batch.finished(false, m);
+			});
+	}
+}
+
+bool AssetRegistry::pumpBatch()
+{
+	Batch& batch = *m_batch;
+	{
+		std::lock_guard<std::mutex> lock(batch.readyMutex);
+		batch.draining.swap(batch.ready);
+	}
+	for (auto [texture, index] : batch.draining)
+	{
+		batch.outstanding--;
+		if (texture)
+		{
+			finishTexture(index);
+		}
+		else
+		{
+			finishMesh(index);
+		}
+	}
+	batch.draining.clear();
+
+	if (batch.outstanding > 0)
+	{
+		return false;
+	}
+	finishReport();
+	return true;
+}
+
+std::shared_ptr<Texture> AssetRegistry::requestTexture(const std::string& path, size_t mesh, int parent)
+{
+	Batch& batch = *m_batch;
+	std::string key = canonicalPath(path);
+	auto found = m_textures.find(key);
+	if (found != m_textures.end())
+	{
+		m_stats.textureHits++;
+		return found->second.asset;
+	}
+	auto pending = batch.textureByKey.find(key);
+	if (pending != batch.textureByKey.end())
+	{
+		// Uma que já terminou e não está no registro falhou: não há o que esperar
+		m_stats.textureHits++;
+		Batch::PendingTexture& texture = batch.textures[pending->second];
+		if (!texture.done)
+		{
+			texture.meshes.push_back(mesh);
+			batch.meshes[mesh].waitingTexture = true;
+		}
+		return nullptr;
+	}
+
+	// O hash do conteúdo também é calculado no job; cópias em outros
+	// caminhos só são reconhecidas quando ela termina
+	m_stats.textureMisses++;
+	size_t index = batch.textures.size();
+	batch.textureByKey[key] = index;
+	batch.textures.emplace_back();
+	Batch::PendingTexture* texture = &batch.textures.back();
+	texture->path = path;
+	texture->key = key;
+	texture->meshes.push_back(mesh);
+	texture->parent = parent;
+	batch.meshes[mesh].waitingTexture = true;
+	batch.outstanding++;
+	// Em streaming sempre RGBA: as linhas vão do anel direto para a textura
+	int channels = batch.streaming ? 4 : 0;
+	JobSystem::get().schedule([&batch, texture, index, channels]()
+		{
+			texture->decoded.contentHash = hashFile(texture->path);
+			decodeTexture(texture->path, texture->decoded, channels);
+			batch.finished(true, index);
+		});
+	return nullptr;
+}
+
+void AssetRegistry::finishMesh(size_t index)
+{
+	Batch& batch = *m_batch;
+	Batch::PendingMesh& pending = batch.meshes[index];
+	DecodedMesh& decoded = pending.decoded;
+
+	int reportIndex = static_cast<int>(m_report.assets.size());
+	LoadReport::Asset asset;
+	asset.path = decoded.path;
+	asset.decodeStartMilliseconds = millisecondsBetween(batch.start, decoded.start);
+	asset.decodeMilliseconds = millisecondsBetween(decoded.start, decoded.end);
+
+	// A textura entra na fila antes do envio da malha, para ser decodificada
+	// enquanto esta thread envia
+	std::shared_ptr<Texture> texture;
+	std::string texturePath = decoded.texturePath();
+	if (decoded.valid && !texturePath.empty())
+	{
+		texture = requestTexture(texturePath, index, reportIndex);
+	}
+
+	auto uploadStart = Clock::now();
+	pending.mesh = uploadMesh(decoded);
+	auto uploadEnd = Clock::now();
+	asset.uploadStartMilliseconds = millisecondsBetween(batch.start, uploadStart);
+	asset.uploadMilliseconds = millisecondsBetween(uploadStart, uploadEnd);
+	m_report.assets.push_back(asset);
+	// Os vértices já estão na GPU
+	decoded = DecodedMesh();
+
+	if (!pending.mesh)
+	{
+		return;
+	}
+	pending.mesh->diffuseTexture = texture;
+	Entry<GpuMesh> entry = { pending.mesh, pending.contentHash };
+	m_meshes[pending.key] = entry;
+	for (const std::string& alias : pending.aliases)
+	{
+		m_meshes[alias] = entry;
+	}
+	if (pending.contentHash != 0)
+	{
+		m_meshByHash[pending.contentHash] = pending.key;
+	}
+	for (size_t request : pending.requests)
+	{
+		batch.result[request] = pending.mesh;
+	}
+}
+
+void AssetRegistry::finishTexture(size_t index)
+{
+	Batch& batch = *m_batch;
+	Batch::PendingTexture& pending = batch.textures[index];
+	DecodedTexture& decoded = pending.decoded;
+
+	LoadReport::Asset asset;
+	asset.path = pending.path;
+	asset.texture = true;
+	asset.parent = pending.parent;
+	asset.decodeStartMilliseconds = millisecondsBetween(batch.start, decoded.start);
+	asset.decodeMilliseconds = millisecondsBetween(decoded.start, decoded.end);
+
+	std::shared_ptr<Texture> texture;
+	uint64_t hash = decoded.contentHash;
+	auto sameContent = hash != 0 ? m_textureByHash.find(hash) : m_textureByHash.end();
+	if (sameContent != m_textureByHash.end())
+	{
+		// Outro caminho com o mesmo conteúdo: a decodificação foi desperdiçada
+		m_stats.textureMisses--;
+		m_stats.textureHits++;
+		Entry<Texture> entry = m_textures[sameContent->second];
+		m_textures[pending.key] = entry;
+		texture = entry.asset;
+	}
+	else
+	{
+		auto uploadStart = Clock::now();
+		texture = uploadTexture(decoded);
+		auto uploadEnd = Clock::now();
+		asset.uploadStartMilliseconds = millisecondsBetween(batch.start, uploadStart);
+		asset.uploadMilliseconds = millisecondsBetween(uploadStart, uploadEnd);
+		if (texture)
+		{
+			m_textures[pending.key] = { texture, hash };
+			if (hash != 0)
+			{
+				m_textureByHash[hash] = pending.key;
+			}
+		}
+	}
+	m_report.assets.push_back(asset);
+	decoded = DecodedTexture();
+	pending.done = true;
+
+	for (size_t mesh : pending.meshes)
+	{
+		if (batch.meshes[mesh].mesh)
+		{
+			batch.meshes[mesh].mesh->diffuseTexture = texture;
+		}
+	}
+}
+
+void AssetRegistry::finishReport()
+{
+	m_report.wallMilliseconds = millisecondsBetween(m_batch->start, Clock::now());
+
+	// Uma textura só pode começar depois que o MTL da malha que a pede foi
+	// lido, e todos os envios passam pela mesma thread
+	double longest = 0.0;
+	for (size_t i = 0; i < m_report.assets.size(); ++i)
+	{
+		const LoadReport::Asset& asset = m_report.assets[i];
+		m_report.decodeMilliseconds += asset.decodeMilliseconds;
+		m_report.uploadMilliseconds += asset.uploadMilliseconds;
+		double chain = asset.decodeMilliseconds + asset.uploadMilliseconds;
+		if (asset.parent >= 0)
+		{
+			chain += m_report.assets[asset.parent].decodeMilliseconds;
+		}
+		if (chain > longest)
+		{
+			longest = chain;
+			m_report.criticalAsset = static_cast<int>(i);
+		}
+	}
+	if (m_report.uploadMilliseconds > longest)
+	{
+		longest = m_report.uploadMilliseconds;
+		m_report.criticalAsset = -1;
+	}
+	m_report.criticalPathMilliseconds = m_report.prefetchMilliseconds + longest;
+}
+
+void AssetRegistry::arriveMesh(size_t index)
+{
+	Batch& batch = *m_batch;
+	Batch::PendingMesh& pending = batch.meshes[index];
+	DecodedMesh& decoded = pending.decoded;
+	if (m_logging)
+	{
+		std::cout << decoded.log;
+	}
+	std::cerr << decoded.errors;
+
+	pending.reportIndex = static_cast<int>(m_report.assets.size());
+	LoadReport::Asset asset;
+	asset.path = decoded.path;
+	asset.decodeStartMilliseconds = millisecondsBetween(batch.start, decoded.start);
+	asset.decodeMilliseconds = millisecondsBetween(decoded.start, decoded.end);
+	m_report.assets.push_back(asset);
+	if (!decoded.valid)
+	{
+		pushSwap(pending.current, nullptr);
+		decoded = DecodedMesh();
+		return;
+	}
+
+	// O mesmo conteúdo em outro caminho: já carregado, ou ainda chegando por
+	// outra pendente, que avisa esta quando ficar pronta
+	if (pending.contentHash != 0)
+	{
+		auto sameContent = m_meshByHash.find(pending.contentHash);
+		auto samePending = batch.meshByHash.find(pending.contentHash);
+		if (sameContent != m_meshByHash.end() || samePending != batch.meshByHash.end())
+		{
+			m_stats.meshMisses--;
+			m_stats.meshHits++;
+			m_report.reused++;
+			decoded = DecodedMesh();
+		}
+		if (sameContent != m_meshByHash.end())
+		{
+			Entry<GpuMesh> entry = m_meshes[sameContent->second];
+			m_meshes[pending.key] = entry;
+			for (const std::string& alias : pending.aliases)
+			{
+				m_meshes[alias] = entry;
+			}
+			pushSwap(pending.current, entry.asset);
+			return;
+		}
+		if (samePending != batch.meshByHash.end())
+		{
+			Batch::PendingMesh& first = batch.meshes[samePending->second];
+			first.aliases.push_back(pending.key);
+			first.aliases.insert(first.aliases.end(), pending.aliases.begin(), pending.aliases.end());
+			first.followers.push_back(index);
+			return;
+		}
+	}
+
+	// Até os vértices chegarem, uma caixa do tamanho da malha
+	std::shared_ptr<GpuMesh> box = createBox(decoded.boundsMin, decoded.boundsMax);
+	if (box)
+	{
+		box->path = pending.path;
+		pushSwap(pending.current, box);
+	}
+	if (!m_geometry.reserve(decoded.vertexCount, decoded.indexCount, pending.range))
+	{
+		std::cerr << "Failed to allocate geometry for: " << decoded.path << std::endl;
+		pushSwap(pending.current, nullptr);
+		decoded = DecodedMesh();
+		return;
+	}
+	// Só com o espaço garantido esta vira a pendente do conteúdo: as que
+	// chegarem depois com o mesmo hash seguem esta, e não uma que falhou
+	if (pending.contentHash != 0)
+	{
+		batch.meshByHash[pending.contentHash] = index;
+	}
+
+	std::string texturePath = decoded.texturePath();
+	if (!texturePath.empty())
+	{
+		pending.texture = requestTexture(texturePath, index, pending.reportIndex);
+	}
+	batch.uploads.emplace_back(false, index);
+}
+
+void AssetRegistry::arriveTexture(size_t index)
+{
+	Batch& batch = *m_batch;
+	Batch::PendingTexture& pending = batch.textures[index];
+	DecodedTexture& decoded = pending.decoded;
+
+	pending.reportIndex = static_cast<int>(m_report.assets.size());
+	LoadReport::Asset asset;
+	asset.path = pending.path;
+	asset.texture = true;
+	asset.parent = pending.parent;
+	asset.decodeStartMilliseconds = millisecondsBetween(batch.start, decoded.start);
+	asset.decodeMilliseconds = millisecondsBetween(decoded.start, decoded.end);
+	m_report.assets.push_back(asset);
+	if (!decoded.pixels)
+	{
+		std::cout << "Failed to load texture" << std::endl;
+		completeTexture(index, nullptr);
+		return;
+	}
+
+	uint64_t hash = decoded.contentHash;
+	auto sameContent = hash != 0 ? m_textureByHash.find(hash) : m_textureByHash.end();
+	if (sameContent != m_textureByHash.end())
+	{
+		m_stats.textureMisses--;
+		m_stats.textureHits++;
+		Entry<Texture> entry = m_textures[sameContent->second];
+		m_textures[pending.key] = entry;
+		completeTexture(index, entry.asset);
+		return;
+	}
+
+	if (m_logging)
+	{
+		std::cout << "Loaded texture: " << decoded.path << " (" << decoded.width << "x" << decoded.height << ")" << std::endl;
+	}
+	batch.uploads.emplace_back(true, index);
+}
+
+bool AssetRegistry::streamSlice()
+{
+	Batch& batch = *m_batch;
+	auto [isTexture, index] = batch.uploads.front();
+	auto sliceStart = Clock::now();
+	size_t offset = 0;
+	size_t bytes = 0;
+	bool complete = false;
+	int reportIndex = -1;
+
+	if (isTexture && !batch.textures[index].texture)
+	{
+		// O primeiro pedaço de uma textura é só o armazenamento (um nível: o
+		// filtro é GL_LINEAR, sem mipmaps), que o driver pode demorar a alocar
+		Batch::PendingTexture& pending = batch.textures[index];
+		DecodedTexture& decoded = pending.decoded;
+		pending.texture = std::make_shared<Texture>();
+		pending.texture->path = decoded.path;
+		pending.texture->width = decoded.width;
+		pending.texture->height = decoded.height;
+		glGenTextures(1, &pending.texture->id);
+		GlState::get().bindTexture(GL_TEXTURE_2D, pending.texture->id);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, decoded.width, decoded.height);
+		GlState::get().bindTexture(GL_TEXTURE_2D, 0);
+		reportIndex = pending.reportIndex;
+	}
+	else if (isTexture)
+	{
+		Batch::PendingTexture& pending = batch.textures[index];
+		DecodedTexture& decoded = pending.decoded;
+		size_t rowBytes = static_cast<size_t>(decoded.width) * 4;
+		int rows = std::min(decoded.height - pending.rowsSent, std::max(1, static_cast<int>(STREAM_SLICE_BYTES / rowBytes)));
+		bytes = rows * rowBytes;
+		char* staging = m_staging.allocate(bytes, offset);
+		if (!staging)
+		{
+			return false;
+		}
+		std::memcpy(staging, decoded.pixels.get() + pending.rowsSent * rowBytes, bytes);
+		GlState::get().bindTexture(GL_TEXTURE_2D, pending.texture->id);
+		GlState::get().bindBuffer(GL_PIXEL_UNPACK_BUFFER, m_staging.getBuffer());
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, pending.rowsSent, decoded.width, rows, GL_RGBA, GL_UNSIGNED_BYTE,
+			reinterpret_cast<const void*>(offset));
+		GlState::get().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		GlState::get().bindTexture(GL_TEXTURE_2D, 0);
+		pending.rowsSent += rows;
+		complete = pending.rowsSent == decoded.height;
+		reportIndex = pending.reportIndex;
+	}
+	else
+	{
+		Batch::PendingMesh& pending = batch.meshes[index];
+		DecodedMesh& decoded = pending.decoded;
+		size_t vertexBytes = static_cast<size_t>(decoded.vertexCount) * VERTEX_FLOATS * sizeof(GLfloat);
+		if (pending.vertexBytesSent < vertexBytes)
+		{
+			bytes = std::min(STREAM_SLICE_BYTES, vertexBytes - pending.vertexBytesSent);
+			char* staging = m_staging.allocate(bytes, offset);
+			if (!staging)
+			{
+				return false;
+			}
+			std::memcpy(staging, static_cast<const char*>(decoded.vertexData()) + pending.vertexBytesSent, bytes);
+			m_geometry.copyVertices(m_staging.getBuffer(), offset, pending.range, pending.vertexBytesSent, bytes);
+			pending.vertexBytesSent += bytes;
+		}
+		else
+		{
+			size_t count = std::min(STREAM_SLICE_BYTES / sizeof(GLuint), decoded.indexCount - pending.indicesSent);
+			bytes = count * sizeof(GLuint);
+			GLuint* staging = reinterpret_cast<GLuint*>(m_staging.allocate(bytes, offset));
+			if (!staging)
+			{
+				return false;
+			}
+			std::memcpy(staging, decoded.indexData() + pending.indicesSent, bytes);
+			m_geometry.copyIndices(m_staging.getBuffer(), offset, pending.range, pending.indicesSent * sizeof(GLuint), bytes);
+			pending.indicesSent += count;
+		}
+		complete = pending.vertexBytesSent == vertexBytes && pending.indicesSent == decoded.indexCount;
+		reportIndex = pending.reportIndex;
+	}
+
+	// O envio de cada asset no relatório é a soma dos pedaços
+	auto sliceEnd = Clock::now();
+	LoadReport::Asset& asset = m_report.assets[reportIndex];
+	if (asset.uploadMilliseconds == 0.0)
+	{
+		asset.uploadStartMilliseconds = millisecondsBetween(batch.start, sliceStart);
+	}
+	asset.uploadMilliseconds += millisecondsBetween(sliceStart, sliceEnd);
+	m_streamStats.stagedBytes += bytes;
+	if (!complete)
+	{
+		return true;
+	}
+
+	batch.uploads.pop_front();
+	if (isTexture)
+	{
+		Batch::PendingTexture& pending = batch.textures[index];
+		std::shared_ptr<Texture> texture = pending.texture;
+		uint64_t hash = pending.decoded.contentHash;
+		m_textures[pending.key] = { texture, hash };
+		if (hash != 0)
+		{
+			m_textureByHash[hash] = pending.key;
+		}
+		completeTexture(index, texture);
+	}
+	else
+	{
+		Batch::PendingMesh& pending = batch.meshes[index];
+		pending.uploaded = true;
+		if (!pending.waitingTexture)
+		{
+			makeResident(index);
+		}
+	}
+	return true;
+}
+
+void AssetRegistry::makeResident(size_t index)
+{
+	Batch& batch = *m_batch;
+	Batch::PendingMesh& pending = batch.meshes[index];
+	pending.mesh = createMesh(pending.decoded, pending.range);
+	pending.mesh->diffuseTexture = pending.texture;
+	pending.decoded = DecodedMesh();
+	m_streamStats.resident++;
+
+	// Só entra no registro inteira, já com a textura
+	Entry<GpuMesh> entry = { pending.mesh, pending.contentHash };
+	m_meshes[pending.key] = entry;
+	for (const std::string& alias : pending.aliases)
+	{
+		m_meshes[alias] = entry;
+	}
+	if (pending.contentHash != 0)
+	{
+		m_meshByHash[pending.contentHash] = pending.key;
+	}
+	pushSwap(pending.current, pending.mesh);
+	for (size_t follower : pending.followers)
+	{
+		pushSwap(batch.meshes[follower].current, pending.mesh);
+	}
+}
+
+void AssetRegistry::completeTexture(size_t index, std::shared_ptr<Texture> texture)
+{
+	Batch& batch = *m_batch;
+	Batch::PendingTexture& pending = batch.textures[index];
+	pending.decoded = DecodedTexture();
+	pending.done = true;
+	if (texture)
+	{
+		m_streamStats.resident++;
+	}
+
+	// As malhas que já terminaram de chegar só esperavam por ela
+	for (size_t mesh : pending.meshes)
+	{
+		Batch::PendingMesh& waiting = batch.meshes[mesh];
+		waiting.texture = texture;
+		waiting.waitingTexture = false;
+		if (waiting.uploaded)
+		{
+			makeResident(mesh);
+		}
+	}
+}
+
+void AssetRegistry::pushSwap(std::shared_ptr<GpuMesh>& current, std::shared_ptr<GpuMesh> to)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_swapMutex);
+		m_swaps.push_back({ current, to });
+	}
+	current = std::move(to);
+}
+
+std::shared_ptr<GpuMesh> AssetRegistry::createBox(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	// Os 8 cantos (bit 0 = x, 1 = y, 2 = z) e as 6 faces em dois triângulos
+	GLfloat vertices[8 * VERTEX_FLOATS] = {};
+	for (int corner = 0; corner < 8; ++corner)
+	{
+		GLfloat* vertex = vertices + corner * VERTEX_FLOATS;
+		vertex[0] = corner & 1 ? boundsMax.x : boundsMin.x;
+		vertex[1] = corner & 2 ? boundsMax.y : boundsMin.y;
+		vertex[2] = corner & 4 ? boundsMax.z : boundsMin.z;
+		vertex[3] = vertex[4] = vertex[5] = 0.6f;
+	}
+	const GLuint faces[6][4] = { { 0, 2, 6, 4 }, { 1, 5, 7, 3 }, { 0, 4, 5, 1 }, { 2, 3, 7, 6 }, { 0, 1, 3, 2 }, { 4, 6, 7, 5 } };
+	GLuint indices[36];
+	for (int face = 0; face < 6; ++face)
+	{
+		const GLuint* quad = faces[face];
+		GLuint* triangles = indices + face * 6;
+		triangles[0] = quad[0]; triangles[1] = quad[1]; triangles[2] = quad[2];
+		triangles[3] = quad[0]; triangles[4] = quad[2]; triangles[5] = quad[3];
+	}
+
+	auto box = std::make_shared<GpuMesh>();
+	if (!m_geometry.allocate(vertices, 8, indices, 36, box->range))
+	{
+		return nullptr;
+	}
+	box->path = "placeholder";
+	box->boundsMin = boundsMin;
+	box->boundsMax = boundsMax;
+	box->boundsCenter = (boundsMin + boundsMax) * 0.5f;
+	box->boundsRadius = glm::length(boundsMax - box->boundsCenter);
+	box->diffuseTexture = m_placeholderTexture;
+	box->materialIndex = m_placeholderMaterial;
+	m_boxes.push_back(box);
+	return box;
+}
+
+void AssetRegistry::releaseBoxes(bool all)
+{
+	// Uma caixa que só o registro referencia não está em nenhuma cena nem
+	// snapshot; a do placeholder unitário é dividida e fica até o clear()
+	m_boxes.erase(std::remove_if(m_boxes.begin(), m_boxes.end(), [&](const std::shared_ptr<GpuMesh>& box)
+		{
+			if (box == m_placeholder || (!all && box.use_count() > 1))
+			{
+				return false;
+			}
+			m_geometry.release(box->range);
+			return true;
+		}), m_boxes.end());
+}
+
+void AssetRegistry::destroy(GpuMesh& mesh)
+{
+	m_geometry.release(mesh.range);
+	mesh.range = MeshRange();
+	mesh.diffuseTexture.reset();
+}
+
+void AssetRegistry::destroy(Texture& texture)
+{
+	GlState::get().deleteTextures(1, &texture.id);
+	texture.id = 0;
+}
+
+void AssetRegistry::releaseUnused()
+{
+	// Um asset está sem uso quando todas as referências vêm das entradas do
+	// próprio registro (o mesmo asset pode estar em mais de um caminho)
+	auto release = [](auto& entries, auto& byHash, auto destroyAsset)
+		{
+			std::unordered_map<const void*, long> registryRefs;
+			for (auto& [key, entry] : entries)
+			{
+				registryRefs[entry.asset.get()]++;
+			}
+
+			std::unordered_set<const void*> unused;
+			for (auto& [key, entry] : entries)
+			{
+				if (entry.asset.use_count() == registryRefs[entry.asset.get()])
+				{
+					unused.insert(entry.asset.get());
+				}
+			}
+
+			for (auto it = entries.begin(); it != entries.end();)
+			{
+				if (!unused.count(it->second.asset.get()))
+				{
+					++it;
+					continue;
+				}
+				if (it->second.asset.use_count() == 1)
+				{
+					destroyAsset(*it->second.asset);
+				}
+				byHash.erase(it->second.contentHash);
+				it = entries.erase(it);
+			}
+		};
+
+	// Malhas primeiro: ao liberar uma malha a referência da textura dela some
+	release(m_meshes, m_meshByHash, [this](GpuMesh& mesh) { destroy(mesh); });
+	release(m_textures, m_textureByHash, [](Texture& texture) { destroy(texture); });
+	// Os hashes adiantados valiam para o que estava carregado
+	m_prefetched.clear();
+}
+
+void AssetRegistry::clear()
+{
+	// Streaming interrompido: espera os jobs que ainda decodificam, sem
+	// enviar nada, e apaga as texturas que não chegaram inteiras
+	if (m_batch)
+	{
+		Batch& batch = *m_batch;
+		JobSystem& jobs = JobSystem::get();
+		while (batch.outstanding > 0)
+		{
+			{
+				std::lock_guard<std::mutex> lock(batch.readyMutex);
+				batch.outstanding -= batch.ready.size();
+				batch.ready.clear();
+			}
+			if (batch.outstanding > 0 && !jobs.help())
+			{
+				std::this_thread::yield();
+			}
+		}
+		for (Batch::PendingTexture& texture : batch.textures)
+		{
+			if (texture.texture && !texture.done)
+			{
+				destroy(*texture.texture);
+			}
+		}
+		m_batch.reset();
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_swapMutex);
+		m_swaps.clear();
+	}
+	m_placeholder.reset();
+	releaseBoxes(true);
+	if (m_placeholderTexture)
+	{
+		destroy(*m_placeholderTexture);
+		m_placeholderTexture.reset();
+	}
+	m_staging.destroy();
+
+	std::unordered_set<GpuMesh*> meshes;
+	for (auto& [key, entry] : m_meshes)
+	{
+		if (meshes.insert(entry.asset.get()).second)
+		{
+			destroy(*entry.asset);
+		}
+	}
+
+	std::unordered_set<Texture*> textures;
+	for (auto& [key, entry] : m_textures)
+	{
+		if (textures.insert(entry.asset.get()).second)
+		{
+			destroy(*entry.asset);
+		}
+	}
+
+	m_meshes.clear();
+	m_textures.clear();
+	m_meshByHash.clear();
+	m_textureByHash.clear();
+	m_prefetched.clear();
+	m_geometry.destroy();
+	m_materials.destroy();
+}
+
+void AssetRegistry::printStats() const
+{
+	std::cout << "Asset registry: " << m_meshes.size() << " mesh paths (" << m_stats.meshHits << " hits / "
+		<< m_stats.meshMisses << " misses), " << m_textures.size() << " texture paths ("
+		<< m_stats.textureHits << " hits / " << m_stats.textureMisses << " misses)" << std::endl;
+}
+
+void AssetRegistry::printLoadReport(size_t slowest) const
+{
+	const LoadReport& report = m_report;
+	size_t textures = std::count_if(report.assets.begin(), report.assets.end(), [](const LoadReport::Asset& asset) { return asset.texture; });
+	std::cout << "Loading: " << report.assets.size() - textures << " meshes + " << textures << " textures in "
+		<< report.wallMilliseconds << " ms on " << report.threads << " threads (" << report.reused << " requests reused)" << std::endl;
+
+	std::cout << "  prefetch " << report.prefetchMilliseconds << " ms, decode " << report.decodeMilliseconds
+		<< " ms in jobs, upload " << report.uploadMilliseconds << " ms on the GL thread, critical path "
+		<< report.criticalPathMilliseconds << " ms (";
+	if (report.criticalAsset >= 0)
+	{
+		const LoadReport::Asset& asset = report.assets[report.criticalAsset];
+		std::cout << asset.path;
+		if (asset.parent >= 0)
+		{
+			std::cout << " after " << report.assets[asset.parent].path;
+		}
+	}
+	else
+	{
+		std::cout << (report.assets.empty() ? "nothing to load" : "the upload stage");
+	}
+	std::cout << ")" << std::endl;
+
+	std::vector<const LoadReport::Asset*> assets;
+	for (const LoadReport::Asset& asset : report.assets)
+	{
+		assets.push_back(&asset);
+	}
+	std::sort(assets.begin(), assets.end(), [](const LoadReport::Asset* a, const LoadReport::Asset* b)
+		{
+			return a->decodeMilliseconds + a->uploadMilliseconds > b->decodeMilliseconds + b->uploadMilliseconds;
+		});
+	for (size_t i = 0; i < std::min(slowest, assets.size()); ++i)
+	{
+		const LoadReport::Asset& asset = *assets[i];
+		std::cout << "  " << (asset.texture ? "texture " : "mesh ") << asset.path << ": decode " << asset.decodeMilliseconds
+			<< " ms at +" << asset.decodeStartMilliseconds << " ms, upload " << asset.uploadMilliseconds
+			<< " ms at +" << asset.uploadStartMilliseconds << " ms" << std::endl;
+	}
+}
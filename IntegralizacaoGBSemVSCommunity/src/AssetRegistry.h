@@ -0,0 +1,247 @@
+#pragma once
+#include "GeometryPool.h"
+#include "MaterialTable.h"
+#include "Mesh.h"
+#include "StagingBuffer.h"
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Textura já enviada para a GPU
+struct Texture
+{
+	GLuint id = 0;
+	std::string path;
+	int width = 0;
+	int height = 0;
+};
+
+// Quantos triângulos de cada malha viram oclusores
+const size_t OCCLUDER_TRIANGLES = 64;
+
+// Malha já enviada para a GPU (faixa dentro do GeometryPool) e o material lido do MTL
+struct GpuMesh
+{
+	MeshRange range;
+	glm::vec3 boundsMin = glm::vec3(0.0f);
+	glm::vec3 boundsMax = glm::vec3(0.0f);
+	// Esfera envolvente centrada no meio da AABB (para o culling)
+	glm::vec3 boundsCenter = glm::vec3(0.0f);
+	float boundsRadius = 0.0f;
+	// Maiores triângulos da malha em espaço local (3 vértices cada), usados
+	// como oclusores pelo OcclusionCuller
+	std::vector<glm::vec3> occluder;
+	std::string path;
+	bool hasMaterial = false;
+	Material material;
+	GLuint materialIndex = 0;   // entrada no MaterialTable
+	std::shared_ptr<Texture> diffuseTexture;
+};
+
+// Registro de assets compartilhados: cada OBJ/PNG é lido e enviado para a GPU
+// uma única vez, e todos os objetos que usam o mesmo arquivo recebem o mesmo
+// handle. A chave é o caminho canônico; se o caminho for novo, o hash do
+// conteúdo ainda encontra cópias idênticas em outros caminhos.
+//
+// A carga tem duas metades: a decodificação (OBJ ou .gbmesh, MTL, PNG via
+// stb_image) não toca na OpenGL e roda em jobs; o envio (GeometryPool,
+// glTexImage2D) fica na thread dona do contexto, que recebe os resultados
+// na ordem em que terminam.
+//
+// Em streaming (streamMeshes) a carga não bloqueia: cada objeto começa com
+// uma caixa no lugar da malha, e a thread de desenho envia um pouco por
+// quadro, por um StagingBuffer, até gastar o orçamento. As trocas
+// placeholder -> recurso pronto são entregues ao loop principal por
+// takeSwaps(), a única função chamada de outra thread durante o streaming.
+//
+// Os handles são contados por referência (shared_ptr). Os recursos da OpenGL
+// são liberados explicitamente por releaseUnused() / clear(), já que o
+// contexto precisa estar ativo quando glDelete* é chamado.
+class AssetRegistry
+{
+public:
+	struct Stats
+	{
+		unsigned meshHits = 0;
+		unsigned meshMisses = 0;
+		unsigned textureHits = 0;
+		unsigned textureMisses = 0;
+	};
+
+	// Tempos da última carga em lote, desde o começo do loadMeshes
+	struct LoadReport
+	{
+		struct Asset
+		{
+			std::string path;
+			bool texture = false;
+			int parent = -1;                       // malha cujo MTL pediu a textura
+			double decodeStartMilliseconds = 0.0;
+			double decodeMilliseconds = 0.0;       // num job, sem o contexto
+			double uploadStartMilliseconds = 0.0;
+			double uploadMilliseconds = 0.0;       // na thread dona do contexto
+		};
+
+		unsigned threads = 0;
+		unsigned reused = 0;                       // pedidos resolvidos sem carregar nada
+		double wallMilliseconds = 0.0;
+		double prefetchMilliseconds = 0.0;         // caminhos canônicos e hashes
+		double decodeMilliseconds = 0.0;           // soma das decodificações
+		double uploadMilliseconds = 0.0;           // soma dos envios (uma thread só)
+		// Prefetch + a maior cadeia (decodificar a malha, a textura dela e
+		// enviar) ou a etapa de envio inteira, o que for maior
+		double criticalPathMilliseconds = 0.0;
+		int criticalAsset = -1;                    // fim da maior cadeia; -1 se o envio limita
+		std::vector<Asset> assets;
+	};
+
+	// Lado da thread de desenho durante o streaming
+	struct StreamStats
+	{
+		unsigned frames = 0;                  // quadros com algo para enviar
+		unsigned stalledFrames = 0;           // quadros que pararam com o StagingBuffer cheio
+		unsigned pending = 0;                 // malhas e texturas ainda não prontas
+		unsigned resident = 0;
+		size_t stagedBytes = 0;
+		double lastPumpMilliseconds = 0.0;
+		double maxPumpMilliseconds = 0.0;
+		double budgetMilliseconds = 0.0;
+	};
+
+	// Troca de uma malha por outra em todas as entidades que a usam (to pode
+	// ser nullptr se a carga falhou)
+	struct MeshSwap
+	{
+		std::shared_ptr<GpuMesh> from;
+		std::shared_ptr<GpuMesh> to;
+	};
+
+	// Tamanho do anel de upload e do maior pedaço enviado de uma vez
+	static constexpr size_t STAGING_BYTES = 16 * 1024 * 1024;
+	static constexpr size_t STREAM_SLICE_BYTES = 256 * 1024;
+
+	AssetRegistry();
+	~AssetRegistry();
+	AssetRegistry(const AssetRegistry&) = delete;
+	AssetRegistry& operator=(const AssetRegistry&) = delete;
+
+	std::shared_ptr<GpuMesh> loadMesh(const std::string& objPath);
+	// Carrega todos os modelos de uma vez, na mesma ordem de objPaths (nullptr
+	// nos que falharem): as malhas e depois as texturas que os MTL pedem são
+	// decodificadas em jobs, e esta thread envia cada uma assim que fica pronta
+	std::vector<std::shared_ptr<GpuMesh>> loadMeshes(const std::vector<std::string>& objPaths);
+	// Calcula em jobs o caminho canônico e o hash do conteúdo dos modelos
+	// ainda não carregados; o loadMesh de cada um usa o resultado em vez de
+	// ler os arquivos de novo nesta thread
+	void prefetchMeshes(const std::vector<std::string>& objPaths);
+	std::shared_ptr<Texture> loadTexture(const std::string& path);
+
+	// Começa a carga em segundo plano e volta na hora com um placeholder (ou a
+	// malha, se já estava carregada) por caminho. Chamar com o contexto ativo
+	std::vector<std::shared_ptr<GpuMesh>> streamMeshes(const std::vector<std::string>& objPaths);
+	// Na thread dona do contexto, uma vez por quadro: envia o que já foi
+	// decodificado até gastar budgetMilliseconds (ao menos um pedaço, e no
+	// máximo um além do orçamento)
+	void pumpStreaming(double budgetMilliseconds);
+	// Na thread da simulação: as trocas desde a última chamada, em ordem
+	void takeSwaps(std::vector<MeshSwap>& out);
+	const StreamStats& getStreamStats() const { return m_streamStats; }
+	// true até o pumpStreaming deixar todos os assets do streaming prontos
+	bool isStreaming() const { return m_batch != nullptr; }
+
+	// Mensagens por asset carregado (desligadas no benchmark)
+	void setLogging(bool enabled) { m_logging = enabled; }
+
+	// Libera os assets que só o registro ainda referencia
+	void releaseUnused();
+	// Libera todos os recursos da GPU (chamar antes de destruir o contexto)
+	void clear();
+
+	GeometryPool& getGeometry() { return m_geometry; }
+	MaterialTable& getMaterials() { return m_materials; }
+
+	const Stats& getStats() const { return m_stats; }
+	size_t getMeshCount() const { return m_meshes.size(); }
+	size_t getTextureCount() const { return m_textures.size(); }
+	void printStats() const;
+
+	const LoadReport& getLoadReport() const { return m_report; }
+	// Totais e os slowest assets que mais demoraram (decodificação + envio)
+	void printLoadReport(size_t slowest = 16) const;
+private:
+	template <typename T>
+	struct Entry
+	{
+		std::shared_ptr<T> asset;
+		uint64_t contentHash = 0;
+	};
+
+	struct DecodedMesh;
+	struct DecodedTexture;
+	struct Batch;
+
+	// contentHash vai para o .gbmesh, se ele for (re)gravado
+	static void decodeMesh(const std::string& objPath, uint64_t contentHash, DecodedMesh& out);
+	// channels 0 mantém os canais do arquivo
+	static void decodeTexture(const std::string& path, DecodedTexture& out, int channels = 0);
+	std::shared_ptr<GpuMesh> uploadMesh(DecodedMesh& decoded);
+	// GpuMesh de uma malha já na faixa range do GeometryPool, com o material
+	std::shared_ptr<GpuMesh> createMesh(DecodedMesh& decoded, const MeshRange& range);
+	std::shared_ptr<Texture> uploadTexture(DecodedTexture& decoded);
+
+	// Lote em andamento: beginBatch agenda as malhas, pumpBatch envia o que
+	// já terminou e diz se acabou
+	void beginBatch(const std::vector<std::string>& objPaths, bool streaming);
+	bool pumpBatch();
+	void finishMesh(size_t index);
+	void finishTexture(size_t index);
+	// A textura de uma malha pendente: já carregada, ou nullptr e agendada
+	std::shared_ptr<Texture> requestTexture(const std::string& path, size_t mesh, int parent);
+	void finishReport();
+
+	// Streaming: o primeiro passo de cada asset que chegou, um pedaço do
+	// envio do primeiro da fila (false se o StagingBuffer está cheio) e a
+	// malha que fica pronta quando ela e a textura estão na GPU
+	void arriveMesh(size_t index);
+	void arriveTexture(size_t index);
+	bool streamSlice();
+	void makeResident(size_t index);
+	void completeTexture(size_t index, std::shared_ptr<Texture> texture);
+	void pushSwap(std::shared_ptr<GpuMesh>& current, std::shared_ptr<GpuMesh> to);
+	// Caixa cinza com os limites dados, com faixa própria no GeometryPool
+	std::shared_ptr<GpuMesh> createBox(const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+	void releaseBoxes(bool all);
+
+	void destroy(GpuMesh& mesh);
+	static void destroy(Texture& texture);
+
+	GeometryPool m_geometry;
+	MaterialTable m_materials;
+
+	std::unordered_map<std::string, Entry<GpuMesh>> m_meshes;
+	std::unordered_map<std::string, Entry<Texture>> m_textures;
+	std::unordered_map<uint64_t, std::string> m_meshByHash;
+	std::unordered_map<uint64_t, std::string> m_textureByHash;
+	// Caminho pedido -> (chave, hash) calculados por prefetchMeshes
+	std::unordered_map<std::string, std::pair<std::string, uint64_t>> m_prefetched;
+	std::unique_ptr<Batch> m_batch;
+	LoadReport m_report;
+
+	// Streaming: a caixa unitária dos placeholders, as caixas do tamanho de
+	// cada malha (liberadas quando ninguém mais as desenha) e as trocas
+	StagingBuffer m_staging;
+	std::shared_ptr<GpuMesh> m_placeholder;
+	std::shared_ptr<Texture> m_placeholderTexture;
+	GLuint m_placeholderMaterial = 0;
+	std::vector<std::shared_ptr<GpuMesh>> m_boxes;
+	std::mutex m_swapMutex;
+	std::vector<MeshSwap> m_swaps;
+	StreamStats m_streamStats;
+	Stats m_stats;
+	bool m_logging = true;
+};
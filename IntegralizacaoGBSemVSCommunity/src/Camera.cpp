@@ -1,7 +1,7 @@
 #include "Camera.h"
 #include <GLFW/glfw3.h>
 
-Camera::Camera(glm::vec3 position) : m_position(position)
+Camera::Camera(glm::vec3 position) : m_position(position), m_previousPosition(position), m_viewPosition(position)
 {
 
 }
@@ -41,29 +41,26 @@ void Camera::mouseCallback(double xpos, double ypos)
 }
 
 
-void Camera::initCamera(GLuint shaderID)
+void Camera::update(GLFWwindow* window)
 {
-    GLint camPosLoc = glGetUniformLocation(shaderID, "camPos");
-    glUniform3fv(camPosLoc, 1, glm::value_ptr(m_position));
-
-    GLint projectionLoc = glGetUniformLocation(shaderID, "projection");
-    glm::mat4 projection = glm::perspective(glm::radians(m_fov), m_aspecRatio, m_nearPlane, m_farPlane);
-    glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
-
-    m_viewLoc = glGetUniformLocation(shaderID, "view");
-    glm::mat4 view = glm::lookAt(
-        m_position,  // posi��o da c�mera
-        m_lookAt,  // ponto para onde olha
-        m_cameraUp   // eixo "up" (para cima)
-    );
-    glUniformMatrix4fv(m_viewLoc, 1, GL_FALSE, glm::value_ptr(view));
+    m_previousPosition = m_position;
+    processInput(window);
 }
 
-void Camera::update(GLFWwindow* window)
+void Camera::interpolate(float alpha)
 {
-    processInput(window);
-    glm::mat4 view = glm::lookAt(m_position, m_position + m_lookAt, m_cameraUp);
-    glUniformMatrix4fv(m_viewLoc, 1, GL_FALSE, glm::value_ptr(view));
+    m_viewPosition = glm::mix(m_previousPosition, m_position, alpha);
+}
+
+// m_lookAt é a direção para onde a câmera olha (o mouse atualiza)
+glm::mat4 Camera::getViewMatrix() const
+{
+    return glm::lookAt(m_viewPosition, m_viewPosition + m_lookAt, m_cameraUp);
+}
+
+glm::mat4 Camera::getProjectionMatrix() const
+{
+    return glm::perspective(glm::radians(m_fov), m_aspecRatio, m_nearPlane, m_farPlane);
 }
 
 void Camera::setFrustum(float fov, float aspectRatio, float nearPlane, float farPlane)
@@ -74,6 +71,7 @@ void Camera::setFrustum(float fov, float aspectRatio, float nearPlane, float far
     m_farPlane = farPlane;
 }
 
+// Velocidade por passo fixo (6 unidades por segundo), não por quadro
 void Camera::processInput(GLFWwindow* window)
 {
     const float speed = 0.1f;
@@ -8,18 +8,28 @@ class Camera
 {
 public:
 	Camera(glm::vec3 position);
-	void setPosition(glm::vec3 position) { m_position = position; }
+	// Teleporte: sem interpolação a partir da posição anterior
+	void setPosition(glm::vec3 position) { m_position = m_previousPosition = m_viewPosition = position; }
 	void setLookAt(glm::vec3 lookAt) { m_lookAt = lookAt; }
 	void mouseCallback(double xpos, double ypos);
-	void initCamera(GLuint shaderID);
+	// Um passo fixo da simulação (teclas de movimento)
 	void update(struct GLFWwindow* window);
-	glm::vec3 getPosition() const { return m_position; }
+	// Posição desenhada entre a do passo anterior (alpha 0) e a do último (1)
+	void interpolate(float alpha);
+	glm::mat4 getViewMatrix() const;
+	glm::mat4 getProjectionMatrix() const;
+	// A posição desenhada (interpolada)
+	glm::vec3 getPosition() const { return m_viewPosition; }
 	glm::vec3 getLookAt() const { return m_lookAt; }
 	glm::vec3 getCameraUp() const { return m_cameraUp; }
 	void setFrustum(float fov, float aspectRatio, float nearPlane, float farPlane);
+	float getNearPlane() const { return m_nearPlane; }
+	float getFarPlane() const { return m_farPlane; }
 private:
 	void processInput(struct GLFWwindow* window);
 	glm::vec3 m_position;
+	glm::vec3 m_previousPosition;
+	glm::vec3 m_viewPosition;
 	glm::vec3 m_lookAt = glm::vec3(0.0f, 0.0f, 0.0f);
 	glm::vec3 m_cameraUp = glm::vec3(0.0f, 1.0f, 0.0f);
 
@@ -28,9 +38,6 @@ private:
 	float m_nearPlane = 0.1f;
 	float m_farPlane = 100.0f;
 
-	GLint m_viewLoc;
-	GLuint m_shaderID;
-
 	// Para controle de �ngulo
 	float yaw = -90.0f;  // Come�a olhando no -Z
 	float pitch = 0.0f;
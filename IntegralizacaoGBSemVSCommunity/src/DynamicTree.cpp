@@ -0,0 +1,421 @@
+#include "DynamicTree.h"
+#include <cassert>
+
+DynamicTree::DynamicTree()
+{
+	m_nodes.reserve(16);
+}
+
+int DynamicTree::allocateNode()
+{
+	if (m_freeList == NULL_NODE)
+	{
+		// Cresce o vetor e encadeia os novos nós na lista livre
+		int first = static_cast<int>(m_nodes.size());
+		int count = std::max(first, 16);
+		m_nodes.resize(first + count);
+		for (int i = first; i < first + count - 1; ++i)
+		{
+			m_nodes[i].parent = i + 1;
+			m_nodes[i].height = -1;
+		}
+		m_nodes[first + count - 1].parent = NULL_NODE;
+		m_nodes[first + count - 1].height = -1;
+		m_freeList = first;
+	}
+
+	int node = m_freeList;
+	m_freeList = m_nodes[node].parent;
+	m_nodes[node] = TreeNode();
+	m_nodes[node].height = 0;
+	return node;
+}
+
+void DynamicTree::freeNode(int node)
+{
+	m_nodes[node].parent = m_freeList;
+	m_nodes[node].height = -1;
+	m_freeList = node;
+}
+
+int DynamicTree::createProxy(const Aabb& aabb, uint32_t userData)
+{
+	int proxyId = allocateNode();
+	glm::vec3 margin(AABB_MARGIN);
+	m_nodes[proxyId].aabb = { aabb.lowerBound - margin, aabb.upperBound + margin };
+	m_nodes[proxyId].userData = userData;
+	m_nodes[proxyId].height = 0;
+	insertLeaf(proxyId);
+	++m_proxyCount;
+	return proxyId;
+}
+
+void DynamicTree::destroyProxy(int proxyId)
+{
+	assert(0 <= proxyId && proxyId < static_cast<int>(m_nodes.size()));
+	assert(m_nodes[proxyId].isLeaf());
+	removeLeaf(proxyId);
+	freeNode(proxyId);
+	--m_proxyCount;
+}
+
+bool DynamicTree::moveProxy(int proxyId, const Aabb& aabb, const glm::vec3& displacement)
+{
+	assert(m_nodes[proxyId].isLeaf());
+
+	// AABB gorda: margem fixa mais o deslocamento previsto do próximo quadro
+	glm::vec3 margin(AABB_MARGIN);
+	Aabb fatAabb = { aabb.lowerBound - margin, aabb.upperBound + margin };
+	glm::vec3 d = AABB_MULTIPLIER * displacement;
+	fatAabb.lowerBound += glm::min(d, glm::vec3(0.0f));
+	fatAabb.upperBound += glm::max(d, glm::vec3(0.0f));
+
+	const Aabb& treeAabb = m_nodes[proxyId].aabb;
+	if (treeAabb.contains(aabb))
+	{
+		// Ainda contém o objeto; só reinsere se a caixa da árvore ficou grande
+		// demais (o objeto parou depois de um deslocamento grande)
+		glm::vec3 hugeMargin(4.0f * AABB_MARGIN);
+		Aabb hugeAabb = { fatAabb.lowerBound - hugeMargin, fatAabb.upperBound + hugeMargin };
+		if (hugeAabb.contains(treeAabb))
+		{
+			return false;
+		}
+	}
+
+	removeLeaf(proxyId);
+	m_nodes[proxyId].aabb = fatAabb;
+	insertLeaf(proxyId);
+	return true;
+}
+
+void DynamicTree::insertLeaf(int leaf)
+{
+	if (m_root == NULL_NODE)
+	{
+		m_root = leaf;
+		m_nodes[m_root].parent = NULL_NODE;
+		return;
+	}
+
+	// Desce pelo filho de menor custo: a área do novo pai mais o aumento que
+	// a inserção causa em todos os ancestrais
+	Aabb leafAabb = m_nodes[leaf].aabb;
+	int index = m_root;
+	while (!m_nodes[index].isLeaf())
+	{
+		int child1 = m_nodes[index].child1;
+		int child2 = m_nodes[index].child2;
+
+		float area = m_nodes[index].aabb.getSurfaceArea();
+		float combinedArea = Aabb::combine(m_nodes[index].aabb, leafAabb).getSurfaceArea();
+
+		// Custo de criar um novo pai para este nó e a folha
+		float cost = 2.0f * combinedArea;
+		// Custo mínimo de empurrar a folha mais para baixo
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		auto descendCost = [&](int child)
+			{
+				float newArea = Aabb::combine(leafAabb, m_nodes[child].aabb).getSurfaceArea();
+				if (m_nodes[child].isLeaf())
+				{
+					return newArea + inheritanceCost;
+				}
+				return newArea - m_nodes[child].aabb.getSurfaceArea() + inheritanceCost;
+			};
+		float cost1 = descendCost(child1);
+		float cost2 = descendCost(child2);
+
+		if (cost < cost1 && cost < cost2)
+		{
+			break;
+		}
+		index = cost1 < cost2 ? child1 : child2;
+	}
+	int sibling = index;
+
+	// Novo pai para o irmão e a folha (allocateNode pode realocar m_nodes)
+	int oldParent = m_nodes[sibling].parent;
+	int newParent = allocateNode();
+	m_nodes[newParent].parent = oldParent;
+	m_nodes[newParent].aabb = Aabb::combine(leafAabb, m_nodes[sibling].aabb);
+	m_nodes[newParent].height = m_nodes[sibling].height + 1;
+	m_nodes[newParent].child1 = sibling;
+	m_nodes[newParent].child2 = leaf;
+	m_nodes[sibling].parent = newParent;
+	m_nodes[leaf].parent = newParent;
+
+	if (oldParent != NULL_NODE)
+	{
+		if (m_nodes[oldParent].child1 == sibling)
+		{
+			m_nodes[oldParent].child1 = newParent;
+		}
+		else
+		{
+			m_nodes[oldParent].child2 = newParent;
+		}
+	}
+	else
+	{
+		m_root = newParent;
+	}
+
+	refit(m_nodes[leaf].parent);
+}
+
+void DynamicTree::removeLeaf(int leaf)
+{
+	if (leaf == m_root)
+	{
+		m_root = NULL_NODE;
+		return;
+	}
+
+	int parent = m_nodes[leaf].parent;
+	int grandParent = m_nodes[parent].parent;
+	int sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+	if (grandParent != NULL_NODE)
+	{
+		// O irmão toma o lugar do pai, que é descartado
+		if (m_nodes[grandParent].child1 == parent)
+		{
+			m_nodes[grandParent].child1 = sibling;
+		}
+		else
+		{
+			m_nodes[grandParent].child2 = sibling;
+		}
+		m_nodes[sibling].parent = grandParent;
+		freeNode(parent);
+		refit(grandParent);
+	}
+	else
+	{
+		m_root = sibling;
+		m_nodes[sibling].parent = NULL_NODE;
+		freeNode(parent);
+	}
+}
+
+void DynamicTree::refit(int index)
+{
+	while (index != NULL_NODE)
+	{
+		index = balance(index);
+
+		TreeNode& node = m_nodes[index];
+		const TreeNode& child1 = m_nodes[node.child1];
+		const TreeNode& child2 = m_nodes[node.child2];
+		node.height = 1 + std::max(child1.height, child2.height);
+		node.aabb = Aabb::combine(child1.aabb, child2.aabb);
+
+		index = node.parent;
+	}
+}
+
+// Rotação AVL: se uma subárvore de iA estiver mais de um nível mais alta que
+// a outra, o filho mais alto sobe para o lugar de iA. Retorna a nova raiz
+int DynamicTree::balance(int iA)
+{
+	TreeNode* A = &m_nodes[iA];
+	if (A->isLeaf() || A->height < 2)
+	{
+		return iA;
+	}
+
+	int iB = A->child1;
+	int iC = A->child2;
+	TreeNode* B = &m_nodes[iB];
+	TreeNode* C = &m_nodes[iC];
+
+	int balanceFactor = C->height - B->height;
+
+	// Sobe C
+	if (balanceFactor > 1)
+	{
+		int iF = C->child1;
+		int iG = C->child2;
+		TreeNode* F = &m_nodes[iF];
+		TreeNode* G = &m_nodes[iG];
+
+		// Troca A e C
+		C->child1 = iA;
+		C->parent = A->parent;
+		A->parent = iC;
+
+		// O antigo pai de A passa a apontar para C
+		if (C->parent != NULL_NODE)
+		{
+			if (m_nodes[C->parent].child1 == iA)
+			{
+				m_nodes[C->parent].child1 = iC;
+			}
+			else
+			{
+				m_nodes[C->parent].child2 = iC;
+			}
+		}
+		else
+		{
+			m_root = iC;
+		}
+
+		// O neto mais alto fica com C, o outro desce para A
+		if (F->height > G->height)
+		{
+			C->child2 = iF;
+			A->child2 = iG;
+			G->parent = iA;
+			A->aabb = Aabb::combine(B->aabb, G->aabb);
+			C->aabb = Aabb::combine(A->aabb, F->aabb);
+			A->height = 1 + std::max(B->height, G->height);
+			C->height = 1 + std::max(A->height, F->height);
+		}
+		else
+		{
+			C->child2 = iG;
+			A->child2 = iF;
+			F->parent = iA;
+			A->aabb = Aabb::combine(B->aabb, F->aabb);
+			C->aabb = Aabb::combine(A->aabb, G->aabb);
+			A->height = 1 + std::max(B->height, F->height);
+			C->height = 1 + std::max(A->height, G->height);
+		}
+		return iC;
+	}
+
+	// Sobe B
+	if (balanceFactor < -1)
+	{
+		int iD = B->child1;
+		int iE = B->child2;
+		TreeNode* D = &m_nodes[iD];
+		TreeNode* E = &m_nodes[iE];
+
+		// Troca A e B
+		B->child1 = iA;
+		B->parent = A->parent;
+		A->parent = iB;
+
+		if (B->parent != NULL_NODE)
+		{
+			if (m_nodes[B->parent].child1 == iA)
+			{
+				m_nodes[B->parent].child1 = iB;
+			}
+			else
+			{
+				m_nodes[B->parent].child2 = iB;
+			}
+		}
+		else
+		{
+			m_root = iB;
+		}
+
+		if (D->height > E->height)
+		{
+			B->child2 = iD;
+			A->child1 = iE;
+			E->parent = iA;
+			A->aabb = Aabb::combine(C->aabb, E->aabb);
+			B->aabb = Aabb::combine(A->aabb, D->aabb);
+			A->height = 1 + std::max(C->height, E->height);
+			B->height = 1 + std::max(A->height, D->height);
+		}
+		else
+		{
+			B->child2 = iE;
+			A->child1 = iD;
+			D->parent = iA;
+			A->aabb = Aabb::combine(C->aabb, D->aabb);
+			B->aabb = Aabb::combine(A->aabb, E->aabb);
+			A->height = 1 + std::max(C->height, D->height);
+			B->height = 1 + std::max(A->height, E->height);
+		}
+		return iB;
+	}
+
+	return iA;
+}
+
+int DynamicTree::getMaxBalance() const
+{
+	int maxBalance = 0;
+	for (const TreeNode& node : m_nodes)
+	{
+		if (node.height <= 1)
+		{
+			continue;
+		}
+		int difference = std::abs(m_nodes[node.child2].height - m_nodes[node.child1].height);
+		maxBalance = std::max(maxBalance, difference);
+	}
+	return maxBalance;
+}
+
+float DynamicTree::getAreaRatio() const
+{
+	if (m_root == NULL_NODE)
+	{
+		return 0.0f;
+	}
+	float rootArea = m_nodes[m_root].aabb.getSurfaceArea();
+	float totalArea = 0.0f;
+	for (const TreeNode& node : m_nodes)
+	{
+		if (node.height >= 0)
+		{
+			totalArea += node.aabb.getSurfaceArea();
+		}
+	}
+	return rootArea > 0.0f ? totalArea / rootArea : 0.0f;
+}
+
+bool DynamicTree::validate() const
+{
+	if (m_root != NULL_NODE && m_nodes[m_root].parent != NULL_NODE)
+	{
+		return false;
+	}
+	int freeCount = 0;
+	for (int node = m_freeList; node != NULL_NODE; node = m_nodes[node].parent)
+	{
+		++freeCount;
+	}
+	// Toda folha é um proxy e toda árvore binária cheia tem 2n - 1 nós
+	int used = m_proxyCount == 0 ? 0 : 2 * m_proxyCount - 1;
+	return used + freeCount == static_cast<int>(m_nodes.size()) && validateNode(m_root);
+}
+
+bool DynamicTree::validateNode(int index) const
+{
+	if (index == NULL_NODE)
+	{
+		return true;
+	}
+	const TreeNode& node = m_nodes[index];
+	if (node.isLeaf())
+	{
+		return node.child2 == NULL_NODE && node.height == 0;
+	}
+	const TreeNode& child1 = m_nodes[node.child1];
+	const TreeNode& child2 = m_nodes[node.child2];
+	if (child1.parent != index || child2.parent != index)
+	{
+		return false;
+	}
+	if (node.height != 1 + std::max(child1.height, child2.height))
+	{
+		return false;
+	}
+	Aabb combined = Aabb::combine(child1.aabb, child2.aabb);
+	if (combined.lowerBound != node.aabb.lowerBound || combined.upperBound != node.aabb.upperBound)
+	{
+		return false;
+	}
+	return validateNode(node.child1) && validateNode(node.child2);
+}
@@ -0,0 +1,303 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Caixa alinhada aos eixos no mundo
+struct Aabb
+{
+	glm::vec3 lowerBound = glm::vec3(0.0f);
+	glm::vec3 upperBound = glm::vec3(0.0f);
+
+	glm::vec3 getCenter() const { return 0.5f * (lowerBound + upperBound); }
+	glm::vec3 getExtents() const { return 0.5f * (upperBound - lowerBound); }
+	// Custo da SAH: área da superfície da caixa
+	float getSurfaceArea() const
+	{
+		glm::vec3 d = upperBound - lowerBound;
+		return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+	}
+	bool contains(const Aabb& other) const
+	{
+		return glm::all(glm::lessThanEqual(lowerBound, other.lowerBound))
+			&& glm::all(glm::lessThanEqual(other.upperBound, upperBound));
+	}
+	bool overlaps(const Aabb& other) const
+	{
+		return glm::all(glm::lessThanEqual(lowerBound, other.upperBound))
+			&& glm::all(glm::lessThanEqual(other.lowerBound, upperBound));
+	}
+	// Distância de entrada do raio na caixa (slab test), ou -1 se ele não acerta em [0, maxDistance]
+	float rayCast(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance) const
+	{
+		glm::vec3 t0 = (lowerBound - origin) * inverseDirection;
+		glm::vec3 t1 = (upperBound - origin) * inverseDirection;
+		glm::vec3 near = glm::min(t0, t1), far = glm::max(t0, t1);
+		float enter = std::max(std::max(near.x, near.y), std::max(near.z, 0.0f));
+		float exit = std::min(std::min(far.x, far.y), std::min(far.z, maxDistance));
+		return enter <= exit ? enter : -1.0f;
+	}
+
+	static Aabb combine(const Aabb& a, const Aabb& b)
+	{
+		return { glm::min(a.lowerBound, b.lowerBound), glm::max(a.upperBound, b.upperBound) };
+	}
+	// Caixa local levada ao mundo pela matriz model (Arvo: centro transformado, |R| * meia-extensão)
+	static Aabb transform(const Aabb& local, const glm::mat4& model)
+	{
+		glm::vec3 center = glm::vec3(model * glm::vec4(local.getCenter(), 1.0f));
+		glm::vec3 halfSize = local.getExtents();
+		glm::vec3 extent(0.0f);
+		for (int column = 0; column < 3; ++column)
+		{
+			extent += glm::abs(glm::vec3(model[column])) * halfSize[column];
+		}
+		return { center - extent, center + extent };
+	}
+};
+
+// Raio para rayCast: a direção não precisa ser normalizada, maxDistance é
+// medido em múltiplos dela
+struct RayCastInput
+{
+	glm::vec3 origin;
+	glm::vec3 direction;
+	float maxDistance;
+};
+
+// Árvore de volumes envolventes dinâmica, versão 3D do b2DynamicTree da
+// Box2D (dependencies/box2d-lib). Cada proxy guarda uma AABB "gorda" (com
+// margem e estendida na direção do movimento), de forma que objetos que se
+// mexem pouco não precisam ser reinseridos. A inserção escolhe o irmão pela
+// heurística de área de superfície e a árvore é mantida balanceada com
+// rotações, então consultas custam O(log n) mais o número de resultados.
+class DynamicTree
+{
+public:
+	static constexpr int NULL_NODE = -1;
+	// Folga em volta da AABB justa e fator aplicado ao deslocamento
+	static constexpr float AABB_MARGIN = 0.1f;
+	static constexpr float AABB_MULTIPLIER = 4.0f;
+
+	DynamicTree();
+
+	// Cria um proxy numa folha; userData é devolvido nas consultas
+	int createProxy(const Aabb& aabb, uint32_t userData);
+	void destroyProxy(int proxyId);
+	// Reinsere o proxy só se a AABB justa saiu da gorda (ou se a gorda ficou
+	// grande demais). Retorna true quando houve reinserção
+	bool moveProxy(int proxyId, const Aabb& aabb, const glm::vec3& displacement);
+
+	uint32_t getUserData(int proxyId) const { return m_nodes[proxyId].userData; }
+	const Aabb& getFatAabb(int proxyId) const { return m_nodes[proxyId].aabb; }
+
+	// callback(proxyId) para cada folha que toca aabb; retornar false encerra a busca
+	template <typename T>
+	void query(T&& callback, const Aabb& aabb) const;
+
+	// callback(proxyId) para cada folha que toca o frustum dos seis planos
+	// (normalizados, apontando para dentro). Subárvores inteiramente dentro
+	// de um plano não testam mais esse plano
+	template <typename T>
+	void queryFrustum(T&& callback, const glm::vec4 planes[6]) const;
+
+	// callback(input, proxyId) para cada folha que o raio atravessa, em ordem
+	// da árvore. O valor retornado é a nova distância máxima: 0 encerra,
+	// negativo ignora o proxy, input.maxDistance mantém o raio inteiro
+	template <typename T>
+	void rayCast(T&& callback, const RayCastInput& input) const;
+
+	int getProxyCount() const { return m_proxyCount; }
+	int getHeight() const { return m_root == NULL_NODE ? 0 : m_nodes[m_root].height; }
+	int getMaxBalance() const;
+	// Soma das áreas dos nós internos dividida pela área da raiz
+	float getAreaRatio() const;
+	// Confere ponteiros, alturas e caixas de todos os nós (só para depuração)
+	bool validate() const;
+
+private:
+	struct TreeNode
+	{
+		bool isLeaf() const { return child1 == NULL_NODE; }
+
+		Aabb aabb;
+		uint32_t userData = 0;
+		int parent = NULL_NODE;   // próximo livre quando o nó está na lista livre
+		int child1 = NULL_NODE;
+		int child2 = NULL_NODE;
+		int height = -1;          // folha = 0, nó livre = -1
+	};
+
+	// Pilha das consultas: começa num array local e só aloca em árvores muito profundas
+	template <typename Entry>
+	class GrowableStack
+	{
+	public:
+		void push(const Entry& node)
+		{
+			if (m_count == CAPACITY)
+			{
+				m_overflow.push_back(node);
+				return;
+			}
+			m_stack[m_count++] = node;
+		}
+		Entry pop()
+		{
+			if (!m_overflow.empty())
+			{
+				Entry node = m_overflow.back();
+				m_overflow.pop_back();
+				return node;
+			}
+			return m_stack[--m_count];
+		}
+		bool empty() const { return m_count == 0 && m_overflow.empty(); }
+	private:
+		static const int CAPACITY = 256;
+		Entry m_stack[CAPACITY];
+		int m_count = 0;
+		std::vector<Entry> m_overflow;
+	};
+
+	int allocateNode();
+	void freeNode(int node);
+	void insertLeaf(int leaf);
+	void removeLeaf(int leaf);
+	int balance(int index);
+	// Refaz altura e caixa de index até a raiz, balanceando no caminho
+	void refit(int index);
+	bool validateNode(int index) const;
+
+	int m_root = NULL_NODE;
+	std::vector<TreeNode> m_nodes;
+	int m_freeList = NULL_NODE;
+	int m_proxyCount = 0;
+};
+
+template <typename T>
+void DynamicTree::query(T&& callback, const Aabb& aabb) const
+{
+	GrowableStack<int> stack;
+	if (m_root != NULL_NODE)
+	{
+		stack.push(m_root);
+	}
+	while (!stack.empty())
+	{
+		int nodeId = stack.pop();
+		const TreeNode& node = m_nodes[nodeId];
+		if (!node.aabb.overlaps(aabb))
+		{
+			continue;
+		}
+		if (node.isLeaf())
+		{
+			if (!callback(nodeId))
+			{
+				return;
+			}
+		}
+		else
+		{
+			stack.push(node.child1);
+			stack.push(node.child2);
+		}
+	}
+}
+
+template <typename T>
+void DynamicTree::queryFrustum(T&& callback, const glm::vec4 planes[6]) const
+{
+	// Cada entrada leva junto a máscara dos planos que ainda precisam ser testados
+	const unsigned ALL_PLANES = 0x3f;
+	GrowableStack<std::pair<int, unsigned>> stack;
+	if (m_root != NULL_NODE)
+	{
+		stack.push({ m_root, ALL_PLANES });
+	}
+	while (!stack.empty())
+	{
+		auto [nodeId, mask] = stack.pop();
+		const TreeNode& node = m_nodes[nodeId];
+
+		glm::vec3 center = node.aabb.getCenter();
+		glm::vec3 extent = node.aabb.getExtents();
+		bool outside = false;
+		for (int i = 0; i < 6 && !outside; ++i)
+		{
+			if (!(mask & (1u << i)))
+			{
+				continue;
+			}
+			float distance = glm::dot(glm::vec3(planes[i]), center) + planes[i].w;
+			float reach = glm::dot(glm::abs(glm::vec3(planes[i])), extent);
+			if (distance + reach < 0.0f)
+			{
+				outside = true;
+			}
+			else if (distance - reach >= 0.0f)
+			{
+				mask &= ~(1u << i);
+			}
+		}
+		if (outside)
+		{
+			continue;
+		}
+		if (node.isLeaf())
+		{
+			if (!callback(nodeId))
+			{
+				return;
+			}
+		}
+		else
+		{
+			stack.push({ node.child1, mask });
+			stack.push({ node.child2, mask });
+		}
+	}
+}
+
+template <typename T>
+void DynamicTree::rayCast(T&& callback, const RayCastInput& input) const
+{
+	glm::vec3 inverseDirection = 1.0f / input.direction;
+	RayCastInput subInput = input;
+	GrowableStack<int> stack;
+	if (m_root != NULL_NODE)
+	{
+		stack.push(m_root);
+	}
+	while (!stack.empty())
+	{
+		int nodeId = stack.pop();
+		const TreeNode& node = m_nodes[nodeId];
+		if (node.aabb.rayCast(input.origin, inverseDirection, subInput.maxDistance) < 0.0f)
+		{
+			continue;
+		}
+		if (node.isLeaf())
+		{
+			float value = callback(subInput, nodeId);
+			if (value == 0.0f)
+			{
+				return;
+			}
+			if (value > 0.0f)
+			{
+				// Encurta o raio: só interessa o que estiver mais perto
+				subInput.maxDistance = value;
+			}
+		}
+		else
+		{
+			stack.push(node.child1);
+			stack.push(node.child2);
+		}
+	}
+}
@@ -0,0 +1,114 @@
+#include "FrameGraph.h"
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+	double millisecondsBetween(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+	{
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+}
+
+FrameGraph::Stage FrameGraph::addStage(const std::string& name, std::function<void()> run, std::initializer_list<Stage> after,
+	Affinity affinity)
+{
+	Node node;
+	node.name = name;
+	node.run = std::move(run);
+	node.affinity = affinity;
+	for (Stage stage : after)
+	{
+		if (stage < m_nodes.size())
+		{
+			node.after.push_back(stage);
+		}
+	}
+	m_nodes.push_back(std::move(node));
+	return m_nodes.size() - 1;
+}
+
+void FrameGraph::runNode(Node& node)
+{
+	node.start = std::chrono::steady_clock::now();
+	node.run();
+	node.end = std::chrono::steady_clock::now();
+}
+
+void FrameGraph::execute()
+{
+	JobSystem& jobs = JobSystem::get();
+	auto frameStart = std::chrono::steady_clock::now();
+
+	// Todos os handles existem antes de qualquer etapa rodar: as Main ficam
+	// abertas até a vez delas nesta thread, as outras já entram como jobs
+	std::vector<JobHandle> dependencies;
+	for (Node& node : m_nodes)
+	{
+		if (node.affinity == Affinity::Main)
+		{
+			node.handle = jobs.open();
+			continue;
+		}
+		dependencies.clear();
+		for (Stage stage : node.after)
+		{
+			dependencies.push_back(m_nodes[stage].handle);
+		}
+		node.handle = jobs.schedule([this, &node]() { runNode(node); }, dependencies);
+	}
+
+	for (Node& node : m_nodes)
+	{
+		if (node.affinity != Affinity::Main)
+		{
+			continue;
+		}
+		for (Stage stage : node.after)
+		{
+			jobs.wait(m_nodes[stage].handle);
+		}
+		runNode(node);
+		jobs.close(node.handle);
+	}
+	for (Node& node : m_nodes)
+	{
+		jobs.wait(node.handle);
+	}
+	auto frameEnd = std::chrono::steady_clock::now();
+
+	// Caminho crítico: cada etapa termina, no melhor caso, a sua duração
+	// depois da mais demorada das suas dependências
+	m_stats.stages.resize(m_nodes.size());
+	m_stats.workMilliseconds = 0.0;
+	m_stats.criticalPathMilliseconds = 0.0;
+	std::vector<double> finish(m_nodes.size(), 0.0);
+	for (size_t i = 0; i < m_nodes.size(); ++i)
+	{
+		const Node& node = m_nodes[i];
+		StageStats& stage = m_stats.stages[i];
+		stage.name = node.name;
+		stage.startMilliseconds = millisecondsBetween(frameStart, node.start);
+		stage.milliseconds = millisecondsBetween(node.start, node.end);
+		double ready = 0.0;
+		for (Stage dependency : node.after)
+		{
+			ready = std::max(ready, finish[dependency]);
+		}
+		finish[i] = ready + stage.milliseconds;
+		m_stats.workMilliseconds += stage.milliseconds;
+		m_stats.criticalPathMilliseconds = std::max(m_stats.criticalPathMilliseconds, finish[i]);
+	}
+	m_stats.frameMilliseconds = millisecondsBetween(frameStart, frameEnd);
+}
+
+void FrameGraph::printStats() const
+{
+	std::cout << "Frame graph: " << m_stats.frameMilliseconds << " ms (stages " << m_stats.workMilliseconds
+		<< " ms in series, critical path " << m_stats.criticalPathMilliseconds << " ms)";
+	for (const StageStats& stage : m_stats.stages)
+	{
+		std::cout << ", " << stage.name << " " << stage.milliseconds << " ms";
+	}
+	std::cout << std::endl;
+}
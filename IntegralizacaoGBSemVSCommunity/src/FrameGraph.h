@@ -0,0 +1,62 @@
+#pragma once
+#include "JobSystem.h"
+#include <chrono>
+#include <functional>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+// Etapas de um quadro e as dependências de dados entre elas, declaradas uma
+// vez na inicialização. execute() roda todas no JobSystem: cada etapa vira
+// um job que depende das etapas de que ela lê, então as que não dependem
+// uma da outra (bounds do frustum e BVH, por exemplo) correm juntas. As
+// etapas Main (GLFW, janela, produtor do RenderThread) rodam na thread que
+// chama execute(), na ordem em que foram declaradas, e enquanto esperam as
+// suas dependências essa thread ajuda a executar os jobs.
+//
+// As etapas são declaradas em ordem: uma só pode depender de anteriores.
+class FrameGraph
+{
+public:
+	enum class Affinity { Any, Main };
+	using Stage = size_t;
+
+	struct StageStats
+	{
+		std::string name;
+		double startMilliseconds = 0.0;   // desde o começo do execute()
+		double milliseconds = 0.0;
+	};
+
+	struct Stats
+	{
+		double frameMilliseconds = 0.0;         // do começo ao fim do execute()
+		double workMilliseconds = 0.0;          // soma das etapas (o quadro em série)
+		double criticalPathMilliseconds = 0.0;  // maior cadeia de dependências
+		std::vector<StageStats> stages;
+	};
+
+	Stage addStage(const std::string& name, std::function<void()> run, std::initializer_list<Stage> after = {},
+		Affinity affinity = Affinity::Any);
+
+	// Roda todas as etapas uma vez e volta quando a última terminar
+	void execute();
+
+	const Stats& getStats() const { return m_stats; }
+	void printStats() const;
+private:
+	struct Node
+	{
+		std::string name;
+		std::function<void()> run;
+		std::vector<Stage> after;
+		Affinity affinity = Affinity::Any;
+		JobHandle handle;
+		std::chrono::steady_clock::time_point start, end;
+	};
+
+	void runNode(Node& node);
+
+	std::vector<Node> m_nodes;
+	Stats m_stats;
+};
@@ -0,0 +1,168 @@
+#include "FrustumCuller.h"
+#include "AssetRegistry.h"
+#include "JobSystem.h"
+#include "Scene.h"
+#include "Simd.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+	const size_t LANES = 8;
+	// Entidades por job em setBounds(scene); múltiplo de LANES para os blocos
+	// não dividirem uma linha de cache dos arrays
+	const size_t BOUNDS_PER_JOB = 4096;
+}
+
+void FrustumCuller::extractPlanes(const glm::mat4& m, glm::vec4 planes[6])
+{
+	glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+	glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+	glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+	glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+	planes[0] = row3 + row0;   // esquerda
+	planes[1] = row3 - row0;   // direita
+	planes[2] = row3 + row1;   // baixo
+	planes[3] = row3 - row1;   // cima
+	planes[4] = row3 + row2;   // perto
+	planes[5] = row3 - row2;   // longe
+	for (int i = 0; i < 6; ++i)
+	{
+		planes[i] /= glm::length(glm::vec3(planes[i]));
+	}
+}
+
+void FrustumCuller::resize(size_t count)
+{
+	m_count = count;
+	size_t padded = (count + LANES - 1) / LANES * LANES;
+	m_centerX.resize(padded, 0.0f);
+	m_centerY.resize(padded, 0.0f);
+	m_centerZ.resize(padded, 0.0f);
+	m_radius.resize(padded, -1.0f);
+	m_extentX.resize(padded, 0.0f);
+	m_extentY.resize(padded, 0.0f);
+	m_extentZ.resize(padded, 0.0f);
+}
+
+void FrustumCuller::setBounds(size_t index, const GpuMesh& mesh, const glm::mat4& model)
+{
+	glm::vec3 center = glm::vec3(model * glm::vec4(mesh.boundsCenter, 1.0f));
+	glm::vec3 halfSize = (mesh.boundsMax - mesh.boundsMin) * 0.5f;
+
+	// AABB no mundo: |R| * meia-extensão (Arvo); esfera: raio vezes a maior escala
+	glm::vec3 extent(0.0f);
+	float maxScale = 0.0f;
+	for (int column = 0; column < 3; ++column)
+	{
+		glm::vec3 axis = glm::vec3(model[column]);
+		extent += glm::abs(axis) * halfSize[column];
+		maxScale = std::max(maxScale, glm::length(axis));
+	}
+
+	m_centerX[index] = center.x;
+	m_centerY[index] = center.y;
+	m_centerZ[index] = center.z;
+	m_radius[index] = mesh.boundsRadius * maxScale;
+	m_extentX[index] = extent.x;
+	m_extentY[index] = extent.y;
+	m_extentZ[index] = extent.z;
+}
+
+void FrustumCuller::setBounds(const Scene& scene)
+{
+	JobSystem& jobs = JobSystem::get();
+	jobs.wait(jobs.parallelFor(scene.size(), BOUNDS_PER_JOB, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				if (const GpuMesh* mesh = scene.getMesh(static_cast<Entity>(i)))
+				{
+					setBounds(i, *mesh, scene.getModelMatrix(static_cast<Entity>(i)));
+				}
+			}
+		}));
+}
+
+const std::vector<uint32_t>& FrustumCuller::cull(const glm::mat4& viewProjection)
+{
+	auto start = std::chrono::steady_clock::now();
+	glm::vec4 planes[6];
+	extractPlanes(viewProjection, planes);
+
+	m_visible.clear();
+	size_t padded = m_centerX.size();
+	for (size_t i = 0; i < padded; i += LANES)
+	{
+		unsigned mask = 0;
+#if defined(GB_USE_AVX)
+		__m256 cx = _mm256_loadu_ps(&m_centerX[i]), cy = _mm256_loadu_ps(&m_centerY[i]), cz = _mm256_loadu_ps(&m_centerZ[i]);
+		__m256 radius = _mm256_loadu_ps(&m_radius[i]);
+		__m256 ex = _mm256_loadu_ps(&m_extentX[i]), ey = _mm256_loadu_ps(&m_extentY[i]), ez = _mm256_loadu_ps(&m_extentZ[i]);
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (const glm::vec4& plane : planes)
+		{
+			__m256 distance = _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.x), cx), _mm256_mul_ps(_mm256_set1_ps(plane.y), cy)),
+				_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.z), cz), _mm256_set1_ps(plane.w)));
+			__m256 projected = _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(std::fabs(plane.x)), ex), _mm256_mul_ps(_mm256_set1_ps(std::fabs(plane.y)), ey)),
+				_mm256_mul_ps(_mm256_set1_ps(std::fabs(plane.z)), ez));
+			__m256 reach = _mm256_min_ps(radius, projected);
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, reach), _mm256_setzero_ps(), _CMP_GE_OQ));
+		}
+		mask = static_cast<unsigned>(_mm256_movemask_ps(inside));
+#elif defined(GB_USE_SSE)
+		for (size_t half = 0; half < LANES; half += 4)
+		{
+			size_t j = i + half;
+			__m128 cx = _mm_loadu_ps(&m_centerX[j]), cy = _mm_loadu_ps(&m_centerY[j]), cz = _mm_loadu_ps(&m_centerZ[j]);
+			__m128 radius = _mm_loadu_ps(&m_radius[j]);
+			__m128 ex = _mm_loadu_ps(&m_extentX[j]), ey = _mm_loadu_ps(&m_extentY[j]), ez = _mm_loadu_ps(&m_extentZ[j]);
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (const glm::vec4& plane : planes)
+			{
+				__m128 distance = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), cx), _mm_mul_ps(_mm_set1_ps(plane.y), cy)),
+					_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), cz), _mm_set1_ps(plane.w)));
+				__m128 projected = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::fabs(plane.x)), ex), _mm_mul_ps(_mm_set1_ps(std::fabs(plane.y)), ey)),
+					_mm_mul_ps(_mm_set1_ps(std::fabs(plane.z)), ez));
+				__m128 reach = _mm_min_ps(radius, projected);
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, reach), _mm_setzero_ps()));
+			}
+			mask |= static_cast<unsigned>(_mm_movemask_ps(inside)) << half;
+		}
+#else
+		for (size_t lane = 0; lane < LANES; ++lane)
+		{
+			size_t j = i + lane;
+			bool inside = true;
+			for (const glm::vec4& plane : planes)
+			{
+				float distance = plane.x * m_centerX[j] + plane.y * m_centerY[j] + plane.z * m_centerZ[j] + plane.w;
+				float projected = std::fabs(plane.x) * m_extentX[j] + std::fabs(plane.y) * m_extentY[j] + std::fabs(plane.z) * m_extentZ[j];
+				inside = inside && distance + std::min(m_radius[j], projected) >= 0.0f;
+			}
+			mask |= (inside ? 1u : 0u) << lane;
+		}
+#endif
+		// As sobras depois de m_count são descartadas aqui
+		while (mask != 0)
+		{
+			unsigned lane = 0;
+			while (!(mask & (1u << lane))) ++lane;
+			mask &= mask - 1;
+			if (i + lane < m_count)
+			{
+				m_visible.push_back(static_cast<uint32_t>(i + lane));
+			}
+		}
+	}
+
+	m_stats.visible = static_cast<unsigned>(m_visible.size());
+	m_stats.culled = static_cast<unsigned>(m_count - m_visible.size());
+	m_stats.cullMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return m_visible;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+struct GpuMesh;
+class Scene;
+
+// Culling por frustum sobre os limites de todos os objetos em SoA. Cada
+// objeto tem uma esfera e uma AABB no mundo (centro comum); ele é descartado
+// se qualquer um dos dois volumes ficar inteiro atrás de um dos seis planos.
+// O teste roda 8 objetos por iteração: dois registradores SSE no build
+// padrão, ou um AVX quando compilado com AVX (opção GB_AVX do CMake).
+class FrustumCuller
+{
+public:
+	struct Stats
+	{
+		unsigned visible = 0;
+		unsigned culled = 0;
+		double cullMilliseconds = 0.0;
+	};
+
+	// Planos de Gribb-Hartmann de projection * view, normalizados e apontando
+	// para dentro do frustum
+	static void extractPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]);
+
+	// Número de objetos do quadro (os limites precisam ser preenchidos com setBounds)
+	void resize(size_t count);
+	// Leva a esfera e a AABB locais da malha para o mundo com a matriz model
+	void setBounds(size_t index, const GpuMesh& mesh, const glm::mat4& model);
+	// setBounds de todas as entidades com malha, em blocos no JobSystem
+	void setBounds(const Scene& scene);
+	// Índices (em ordem) dos objetos que tocam o frustum de viewProjection
+	const std::vector<uint32_t>& cull(const glm::mat4& viewProjection);
+
+	const std::vector<uint32_t>& getVisible() const { return m_visible; }
+	const Stats& getStats() const { return m_stats; }
+private:
+	size_t m_count = 0;
+	// Tamanho sempre múltiplo de 8; as sobras depois de m_count também são
+	// testadas e podem passar, então cull() as descarta pelo índice
+	std::vector<float> m_centerX, m_centerY, m_centerZ;
+	std::vector<float> m_radius;
+	std::vector<float> m_extentX, m_extentY, m_extentZ;
+	std::vector<uint32_t> m_visible;
+	Stats m_stats;
+};
@@ -1,9 +1,15 @@
 #include <iostream>
 #include <string>
+#include <algorithm>
 #include <assert.h>
 #include <fstream>
 #include <sstream>
 #include <vector>
+#include <unordered_map>
+#include <cmath>
+#include <random>
+#include <chrono>
+#include <thread>
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 #include "glad/glad.h"
@@ -12,15 +18,55 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include "SceneLoader.h"
+#include "IndirectRenderer.h"
+#include "UniformBuffers.h"
+#include "LightClusters.h"
+#include "FrustumCuller.h"
+#include "SceneTree.h"
+#include "OcclusionCuller.h"
+#include "GpuCuller.h"
+#include "GpuPaths.h"
+#include "FrameGraph.h"
+#include "GlState.h"
+#include "JobSystem.h"
+#include "LoadingBenchmark.h"
+#include "ObjParser.h"
+#include "PathSystem.h"
+#include "RenderThread.h"
+#include "SimulationClock.h"
+#include "SpscQueue.h"
+#include "TransformSystem.h"
 
 // Protótipo da função de callback de teclado
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+
+// Evento do GLFW guardado pelo callback e tratado no começo do próximo quadro
+struct InputEvent
+{
+	enum class Type { Key, CursorPos, MouseButton };
+	Type type = Type::Key;
+	int code = 0;      // tecla ou botão
+	int action = 0;
+	double x = 0.0;
+	double y = 0.0;
+};
 
 using namespace std;
 
 // Protótipos das funções
 int setupShader();
+void replicateObjects(size_t count);
+void processInput(GLFWwindow* window);
+void moveSelected(const glm::vec3& offset);
+void generateLights(size_t count);
+void handleInput(GLFWwindow* window, const InputEvent& event);
+void handleKey(GLFWwindow* window, int key, int action);
+void handleMouseButton(int button, int action);
+void renderFrame(const RenderSnapshot& snapshot, AssetRegistry& assets);
+void printRenderStats(const RenderSnapshot& snapshot, AssetRegistry& assets);
+void printPipelineStats();
 
 // Dimensões da janela (pode ser alterado em tempo de execução)
 const GLuint WIDTH = 800, HEIGHT = 600;
@@ -32,13 +78,19 @@ layout (location = 0) in vec3 position;
 layout (location = 1) in vec3 color;
 layout (location = 2) in vec2 texc;
 layout (location = 3) in vec3 normal;
-uniform mat4 model;
-uniform mat4 projection;
-uniform mat4 view;
+layout (location = 4) in mat4 model;
+layout (location = 8) in uint materialIndex;
+layout (std140, binding = 0) uniform FrameBlock
+{
+    mat4 view;
+    mat4 projection;
+    vec4 camPos;
+};
 out vec2 texCoord;
 out vec3 vNormal;
 out vec4 fragPos;
 out vec4 vertexColor;
+flat out uint vMaterial;
 void main()
 {
    	gl_Position =  projection * view * model * vec4(position.x, position.y, position.z, 1.0);
@@ -46,27 +98,57 @@ void main()
 	vertexColor = vec4(color, 1.0);
 	vNormal = normal;
 	texCoord = vec2(texc.x, 1 - texc.y);
+	vMaterial = materialIndex;
 })";
 
 //Códifo fonte do Fragment Shader (em GLSL): ainda hardcoded
 const GLchar* fragmentShaderSource = R"(
 #version 450
 
-#define MAX_LIGHTS 16
-
 struct Light {
-    vec3 position;
-    vec3 color;
+    vec4 position;  // w = alcance
+    vec4 color;
+};
+
+layout (std140, binding = 0) uniform FrameBlock
+{
+    mat4 view;
+    mat4 projection;
+    vec4 camPos;
 };
 
-uniform int numLights;
-uniform Light lights[MAX_LIGHTS];
+layout (std140, binding = 1) uniform ClusterBlock
+{
+    uvec4 gridSize;
+    vec4 zParams;   // escala e deslocamento do log da profundidade, near, far
+    vec4 tileSize;
+};
 
-uniform vec3 camPos;
-uniform vec3 ka;
-uniform vec3 kd;
-uniform vec3 ks;
-uniform float q;
+layout (std430, binding = 3) readonly buffer LightBuffer
+{
+    Light lights[];
+};
+
+layout (std430, binding = 4) readonly buffer ClusterBuffer
+{
+    uvec2 clusters[];   // início e quantidade em lightIndices
+};
+
+layout (std430, binding = 5) readonly buffer LightIndexBuffer
+{
+    uint lightIndices[];
+};
+
+struct Material {
+    vec4 ka;
+    vec4 kd;
+    vec4 ks;    // w = expoente especular
+};
+
+layout (std430, binding = 2) readonly buffer MaterialBlock
+{
+    Material materials[];
+};
 
 uniform sampler2D tex_buffer;
 
@@ -74,33 +156,50 @@ in vec2 texCoord;
 in vec4 vertexColor;
 in vec4 fragPos;
 in vec3 vNormal;
+flat in uint vMaterial;
 
 out vec4 color;
 
 void main()
 {
+    vec3 ka = materials[vMaterial].ka.rgb;
+    vec3 kd = materials[vMaterial].kd.rgb;
+    vec3 ks = materials[vMaterial].ks.rgb;
+    float q = materials[vMaterial].ks.w;
     vec3 N = normalize(vNormal);
-    vec3 V = normalize(camPos - vec3(fragPos));
+    vec3 V = normalize(camPos.xyz - vec3(fragPos));
     vec3 texColor = texture(tex_buffer, texCoord).rgb;
     vec3 ambient = vec3(0.0);
     vec3 diffuse = vec3(0.0);
     vec3 specular = vec3(0.0);
 
-    for (int i = 0; i < numLights; ++i)
+    // Cluster do fragmento: bloco da tela + fatia exponencial da profundidade
+    float depth = -(view * fragPos).z;
+    uint slice = uint(max(log(depth) * zParams.x + zParams.y, 0.0));
+    uvec3 cell = min(uvec3(uvec2(gl_FragCoord.xy / tileSize.xy), slice), gridSize.xyz - 1u);
+    uvec2 cluster = clusters[cell.x + gridSize.x * (cell.y + gridSize.y * cell.z)];
+
+    for (uint j = 0u; j < cluster.y; ++j)
     {
-        vec3 L = normalize(lights[i].position - vec3(fragPos));
+        Light light = lights[lightIndices[cluster.x + j]];
+        vec3 toLight = light.position.xyz - vec3(fragPos);
+        float distance = length(toLight);
+        // Cai suavemente até zero no alcance da luz
+        float falloff = clamp(1.0 - pow(distance / light.position.w, 4.0), 0.0, 1.0);
+        vec3 lightColor = light.color.rgb * falloff * falloff;
+        vec3 L = toLight / distance;
         vec3 R = reflect(-L, N);
 
         // Ambient
-        ambient += lights[i].color * ka;
+        ambient += lightColor * ka;
 
         // Diffuse
         float diff = max(dot(N, L), 0.0);
-        diffuse += diff * lights[i].color * kd;
+        diffuse += diff * lightColor * kd;
 
         // Specular
         float spec = pow(max(dot(R, V), 0.0), q);
-        specular += spec * ks * lights[i].color;
+        specular += spec * ks * lightColor;
     }
 
     vec3 result = (ambient + diffuse) * texColor + specular;
@@ -109,14 +208,143 @@ void main()
 )";
 Camera camera = Camera(glm::vec3(0.0f, 0.0f, 5.0f));
 
-std::vector<Object> objects;
+Scene scene;
 std::vector<Light> lights;
-int selectedObject = 0;
-bool isUpdatingObjects = false;
+IndirectRenderer indirectRenderer;
+UniformBuffers uniformBuffers;
+LightClusters lightClusters;
+FrustumCuller frustumCuller;
+SceneTree sceneTree;
+// Varredura SIMD de todos os objetos, consulta na BVH, culling todo na GPU
+// ou sem culling (tecla C)
+enum class CullMode { Simd, Tree, Gpu, Off };
+CullMode cullMode = CullMode::Simd;
+OcclusionCuller occlusionCuller;
+bool occlusionEnabled = true;
+GpuCuller gpuCuller;
+// Caminhos avaliados num compute antes do culling da GPU (tecla V, só com
+// o culling da GPU); a CPU não anda com eles. gpuPaths compila e passa o
+// progresso no loop principal, renderPaths envia e despacha no desenho
+GpuPaths gpuPaths;
+GpuPaths renderPaths;
+bool gpuPathsEnabled = false;
+PathSystem pathSystem;
+TransformSystem transformSystem;
+// Câmera, caminhos e teclas seguradas andam em passos fixos de 1/60 s
+SimulationClock simulationClock;
+
+// Thread de desenho, dona do contexto GL depois do carregamento. O que ela
+// precisa do loop principal vem no RenderSnapshot: o modo de desenho (M), as
+// luzes (trocadas inteiras por T/G) e o pedido de estatísticas (P)
+RenderThread renderThread;
+// Etapas do quadro no loop principal (montado uma vez antes do loop)
+FrameGraph frameGraph;
+IndirectRenderer::Mode renderMode = IndirectRenderer::Mode::MultiDrawIndirect;
+std::shared_ptr<const std::vector<Light>> publishedLights;
+uint64_t statsRequest = 0;
+double simulationMilliseconds = 0.0;
+// Só a thread de desenho mexe nestes
+std::shared_ptr<const std::vector<Light>> renderLights;
+uint64_t renderStatsRequest = 0;
+// Tempo por quadro que a thread de desenho pode gastar enviando assets em streaming
+double uploadBudget = 2.0;
+// Os callbacks do GLFW (dentro do glfwPollEvents) produzem, o loop principal consome
+SpscQueue<InputEvent, 256> inputQueue;
+unsigned droppedInputs = 0;
 
 // Função MAIN
-int main()
+// --objects N replica os objetos da cena até N (para medir o custo de submissão)
+// --lights N completa a cena com luzes aleatórias até N (para medir o forward clusterizado)
+// --benchmark-obj N lê N vezes cada OBJ de Modelos3D com o laço antigo e com o ObjParser e sai
+// --benchmark-transforms N compara a composição das matrizes model e sai
+// --benchmark-entities N compara atualização + preparação do desenho com e sem componentes e sai
+// --benchmark-paths N compara a animação por waypoints por objeto e em lote e sai
+// --benchmark-gpu-paths N compara o custo na CPU dos caminhos com a avaliação na GPU e sai
+// --benchmark-timestep N compara o passo fixo com o avanço por quadro a várias taxas e sai
+// --benchmark-jobs N mede transformações, caminhos e bounds de 1 até N threads no JobSystem e sai
+// --benchmark-submit N mede N quadros de submissão por objeto e com multi-draw indirect com 1k, 10k e 100k objetos e sai
+// --benchmark-loading N carrega uma cena sintética com N assets (OBJ + PNG) de 1 até N threads e sai
+// --max-fps N limita a taxa de quadros (para conferir que a simulação não muda com ela)
+// --pipeline-depth N quadros em andamento ao mesmo tempo, de 1 a 3 (tecla L troca)
+// --stream abre a janela sem esperar os modelos: caixas no lugar deles até chegarem
+// --upload-budget MS tempo máximo de envio em streaming por quadro (padrão 2 ms)
+int main(int argc, char** argv)
 {
+	auto startupStart = std::chrono::steady_clock::now();
+	// --stream é o único sem valor
+	bool streaming = std::find(argv + 1, argv + argc, std::string("--stream")) != argv + argc;
+	size_t objectCount = 0;
+	size_t lightCount = 0;
+	size_t loadingBenchmark = 0;
+	size_t gpuPathsBenchmark = 0;
+	size_t submitBenchmark = 0;
+	double maxFps = 0.0;
+	for (int i = 1; i + 1 < argc; ++i)
+	{
+		if (std::string(argv[i]) == "--objects")
+		{
+			objectCount = std::stoul(argv[++i]);
+		}
+		else if (std::string(argv[i]) == "--lights")
+		{
+			lightCount = std::stoul(argv[++i]);
+		}
+		else if (std::string(argv[i]) == "--benchmark-obj")
+		{
+			ObjParser::benchmark(std::stoul(argv[++i]));
+			return 0;
+		}
+		else if (std::string(argv[i]) == "--benchmark-transforms")
+		{
+			TransformSystem::benchmark(std::stoul(argv[++i]));
+			return 0;
+		}
+		else if (std::string(argv[i]) == "--benchmark-entities")
+		{
+			Scene::benchmark(std::stoul(argv[++i]));
+			return 0;
+		}
+		else if (std::string(argv[i]) == "--benchmark-paths")
+		{
+			PathSystem::benchmark(std::stoul(argv[++i]));
+			return 0;
+		}
+		else if (std::string(argv[i]) == "--benchmark-gpu-paths")
+		{
+			gpuPathsBenchmark = std::stoul(argv[++i]);
+		}
+		else if (std::string(argv[i]) == "--benchmark-timestep")
+		{
+			SimulationClock::benchmark(std::stoul(argv[++i]));
+			return 0;
+		}
+		else if (std::string(argv[i]) == "--benchmark-jobs")
+		{
+			JobSystem::benchmark(std::stoul(argv[++i]));
+			return 0;
+		}
+		else if (std::string(argv[i]) == "--benchmark-submit")
+		{
+			submitBenchmark = std::stoul(argv[++i]);
+		}
+		else if (std::string(argv[i]) == "--benchmark-loading")
+		{
+			loadingBenchmark = std::stoul(argv[++i]);
+		}
+		else if (std::string(argv[i]) == "--max-fps")
+		{
+			maxFps = std::stod(argv[++i]);
+		}
+		else if (std::string(argv[i]) == "--pipeline-depth")
+		{
+			renderThread.setPipelineDepth(std::stoul(argv[++i]));
+		}
+		else if (std::string(argv[i]) == "--upload-budget")
+		{
+			uploadBudget = std::stod(argv[++i]);
+		}
+	}
+
 	// Inicialização da GLFW
 	glfwInit();
 
@@ -139,27 +367,51 @@ int main()
 	std::cout << "Renderer: " << renderer << std::endl;
 	std::cout << "OpenGL version supported " << version << std::endl;
 
+	// O envio das texturas e malhas e o compute shader dos caminhos precisam de um contexto
+	if (loadingBenchmark > 0)
+	{
+		LoadingBenchmark::run(loadingBenchmark);
+		glfwTerminate();
+		return 0;
+	}
+	if (gpuPathsBenchmark > 0)
+	{
+		GpuPaths::benchmark(gpuPathsBenchmark);
+		glfwTerminate();
+		return 0;
+	}
+
 	// Definindo as dimensões da viewport com as mesmas dimensões da janela da aplicação
 	int width, height;
 	glfwGetFramebufferSize(window, &width, &height);
 	glViewport(0, 0, width, height);
 
 	GLuint shaderID = setupShader();
+	if (submitBenchmark > 0)
+	{
+		IndirectRenderer::benchmark(submitBenchmark, shaderID);
+		glfwTerminate();
+		return 0;
+	}
 
-	glUseProgram(shaderID);
+	GlState::get().useProgram(shaderID);
 	SceneLoader sceneLoader(shaderID);
-	objects = sceneLoader.loadObjects("../config/scene_objects_config.txt");
-
-	glm::mat4 model = glm::mat4(1);
-	GLint modelLoc = glGetUniformLocation(shaderID, "model");
+	sceneLoader.setStreaming(streaming);
+	auto loadStart = std::chrono::steady_clock::now();
+	scene = sceneLoader.loadObjects("../config/scene_objects_config.txt");
+	double loadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+	replicateObjects(objectCount);
+	scene.select(0);
 
 	lights = sceneLoader.loadLights("../config/scene_lights_config.txt");
-	// Envia quantidade de luzes
-	glUniform1i(glGetUniformLocation(shaderID, "numLights"), lights.size());
+	generateLights(lightCount);
+	uniformBuffers.init();
+	lightClusters.init();
 
 	camera = sceneLoader.loadCamera("../config/scene_camera_config.txt");
 
 	glfwSetCursorPosCallback(window, mouse_callback);
+	glfwSetMouseButtonCallback(window, mouse_button_callback);
 	// Esconde o cursor e captura ele
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
@@ -167,113 +419,419 @@ int main()
 
 	glEnable(GL_DEPTH_TEST);
 
+	indirectRenderer.init(sceneLoader.getAssets().getGeometry());
+	indirectRenderer.setProgram(shaderID);
+	gpuCuller.init(sceneLoader.getAssets().getGeometry(), indirectRenderer, width, height);
+	renderPaths.init();
+	publishedLights = std::make_shared<const std::vector<Light>>(lights);
 
-	// Loop da aplicação - "game loop"
-	while (!glfwWindowShouldClose(window))
-	{
-		// Checa se houveram eventos de input (key pressed, mouse moved etc.) e chama as funções de callback correspondentes
-		glfwPollEvents();
+	// Daqui em diante o contexto GL é da thread de desenho
+	glfwMakeContextCurrent(nullptr);
+	AssetRegistry& assets = sceneLoader.getAssets();
+	renderThread.start(window, [&assets](const RenderSnapshot& snapshot) { renderFrame(snapshot, assets); });
+	// O tempo de abertura vai até a troca de buffers do primeiro quadro, que
+	// acontece na thread de desenho; é impresso quando ela avisa
+	bool startupReported = false;
+	auto reportStartup = [&]()
+		{
+			std::chrono::steady_clock::time_point firstPresent;
+			if (startupReported || !renderThread.getFirstPresentTime(firstPresent))
+			{
+				return;
+			}
+			std::cout << "Startup: " << std::chrono::duration<double, std::milli>(firstPresent - startupStart).count()
+				<< " ms until the first frame (" << loadMilliseconds << " ms loading the scene" << (streaming ? ", assets streaming in" : "")
+				<< ")" << std::endl;
+			startupReported = true;
+		};
 
-		// Limpa o buffer de cor
-		glClearColor(1.0f, 1.0f, 1.0f, 1.0f); //cor de fundo
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	// Um quadro do loop principal como grafo de etapas: cada uma declara de
+	// quais lê, e as que não dependem uma da outra correm juntas no JobSystem.
+	// GLFW, janela e a publicação do snapshot ficam nesta thread (Main)
+	double frameStart = glfwGetTime();
+	float alpha = 0.0f;
+	bool pathsOnGpu = false;
+	std::chrono::steady_clock::time_point inputTime;
 
-		glLineWidth(10);
-		glPointSize(20);
-		
-		camera.update(window);
-		objects[selectedObject].processInput(window, &camera);
-		for(auto& object : objects) 
+	// Checa se houveram eventos de input (key pressed, mouse moved etc.) e chama as funções de callback correspondentes.
+	// Os callbacks só enfileiram; os eventos são tratados aqui, em ordem, antes dos passos
+	FrameGraph::Stage input = frameGraph.addStage("input", [&]()
 		{
-			isUpdatingObjects = true;
-			object.update(window, &camera);
-			isUpdatingObjects = false;
-			object.draw(modelLoc);
-		}
+			inputTime = std::chrono::steady_clock::now();
+			glfwPollEvents();
+			InputEvent event;
+			while (inputQueue.pop(event))
+			{
+				handleInput(window, event);
+			}
+		}, {}, FrameGraph::Affinity::Main);
 
-		// Troca os buffers da tela
-		glfwSwapBuffers(window);
-	}
-	// Pede pra OpenGL desalocar os buffers
-	for(auto& object : objects) 
+	// Streaming: as entidades passam para o que a thread de desenho deixou
+	// pronto (a caixa do tamanho do modelo, depois o modelo). Várias trocas
+	// da mesma malha podem chegar juntas; vale a última da cadeia
+	std::vector<AssetRegistry::MeshSwap> swaps;
+	FrameGraph::Stage stream = frameGraph.addStage("stream", [&]()
+		{
+			assets.takeSwaps(swaps);
+			if (swaps.empty())
+			{
+				return;
+			}
+			std::unordered_map<const GpuMesh*, std::shared_ptr<GpuMesh>> next;
+			for (const AssetRegistry::MeshSwap& swap : swaps)
+			{
+				next[swap.from.get()] = swap.to;
+			}
+			for (Entity entity = 0; entity < scene.size(); ++entity)
+			{
+				std::shared_ptr<GpuMesh> mesh = scene.getRenderable(entity).mesh;
+				for (auto found = next.find(mesh.get()); found != next.end(); found = next.find(mesh.get()))
+				{
+					mesh = found->second;
+				}
+				if (mesh != scene.getRenderable(entity).mesh)
+				{
+					scene.setRenderable(entity, { mesh, mesh ? mesh->materialIndex : 0 });
+				}
+			}
+			swaps.clear();
+		}, { input }, FrameGraph::Affinity::Main);
+
+	// Simulação: zero, um ou vários passos fixos conforme o tempo real
+	// desde o quadro anterior (a câmera e as teclas seguradas leem a janela)
+	FrameGraph::Stage simulate = frameGraph.addStage("simulate", [&]()
+		{
+			unsigned steps = simulationClock.advance(frameStart);
+			for (unsigned step = 0; step < steps; ++step)
+			{
+				camera.update(window);
+				processInput(window);
+				if (!gpuPaths.isActive())
+				{
+					pathSystem.update(scene);
+				}
+			}
+		}, { stream }, FrameGraph::Affinity::Main);
+
+	// Desenho: estado entre o passo anterior e o atual, pela fração de
+	// passo que sobrou no relógio
+	FrameGraph::Stage interpolate = frameGraph.addStage("interpolate", [&]()
+		{
+			alpha = simulationClock.getAlpha();
+			camera.interpolate(alpha);
+			// Só as entidades com caminho andam. Ao trocar entre CPU e GPU o
+			// progresso passa pelos WaypointPath
+			pathsOnGpu = gpuPathsEnabled && cullMode == CullMode::Gpu;
+			gpuPaths.setTime(simulationClock.getStep(), alpha);
+			if (pathsOnGpu != gpuPaths.isActive())
+			{
+				if (pathsOnGpu)
+				{
+					pathSystem.saveProgress(scene);
+					gpuPaths.begin(scene);
+				}
+				else
+				{
+					gpuPaths.end(scene);
+					pathSystem.reload();
+				}
+			}
+			if (pathsOnGpu)
+			{
+				gpuPaths.sync(scene);
+			}
+			else
+			{
+				pathSystem.interpolate(scene, alpha);
+			}
+		}, { simulate });
+
+	// Só as matrizes que mudaram são recompostas
+	FrameGraph::Stage transforms = frameGraph.addStage("transforms", [&]()
+		{
+			transformSystem.update(scene.getTransforms(), scene.getModels());
+		}, { interpolate });
+
+	// Os limites do frustum e a BVH (usada no culling e no picking) só leem
+	// as matrizes: correm juntos
+	FrameGraph::Stage bounds = frameGraph.addStage("bounds", [&]()
+		{
+			frustumCuller.resize(scene.size());
+			if (cullMode == CullMode::Simd)
+			{
+				frustumCuller.setBounds(scene);
+			}
+		}, { transforms });
+	FrameGraph::Stage tree = frameGraph.addStage("bvh", [&]()
+		{
+			sceneTree.sync(scene);
+		}, { transforms });
+
+	// Só os objetos que tocam o frustum vão para o snapshot; na GPU o
+	// GpuCuller faz frustum e oclusão sem a lista passar pela CPU
+	FrameGraph::Stage cull = frameGraph.addStage("cull", [&]()
+		{
+			RenderSnapshot& snapshot = renderThread.getSnapshot();
+			snapshot.visible.clear();
+			if (cullMode == CullMode::Simd || cullMode == CullMode::Tree)
+			{
+				glm::mat4 viewProjection = camera.getProjectionMatrix() * camera.getViewMatrix();
+				const std::vector<uint32_t>* visible = cullMode == CullMode::Simd
+					? &frustumCuller.cull(viewProjection) : &sceneTree.cull(viewProjection);
+				// Dos que sobraram, tira os escondidos atrás dos maiores oclusores (tecla H)
+				if (occlusionEnabled)
+				{
+					visible = &occlusionCuller.cull(scene, *visible, viewProjection, camera.getPosition());
+				}
+				snapshot.visible.assign(visible->begin(), visible->end());
+			}
+			else if (cullMode == CullMode::Off)
+			{
+				for (Entity entity = 0; entity < scene.size(); ++entity)
+				{
+					snapshot.visible.push_back(entity);
+				}
+			}
+		}, { bounds, tree });
+
+	frameGraph.addStage("publish", [&]()
+		{
+			RenderSnapshot& snapshot = renderThread.getSnapshot();
+			snapshot.camera = camera;
+			snapshot.width = width;
+			snapshot.height = height;
+			snapshot.lights = publishedLights;
+			snapshot.renderMode = renderMode;
+			snapshot.gpuCulling = cullMode == CullMode::Gpu;
+			snapshot.pathTables = pathsOnGpu ? gpuPaths.getTables() : nullptr;
+			snapshot.simulationStep = simulationClock.getStep();
+			snapshot.alpha = alpha;
+			snapshot.statsRequest = statsRequest;
+			snapshot.inputTime = inputTime;
+			renderThread.publish(scene, transformSystem.getDirty());
+		}, { cull }, FrameGraph::Affinity::Main);
+
+	// Loop da aplicação - "game loop": o grafo acima a cada quadro; o
+	// desenho de cada quadro vai para a thread de desenho num RenderSnapshot
+	auto loopStart = std::chrono::steady_clock::now();
+	while (!glfwWindowShouldClose(window))
 	{
-		object.deleteVertexArray();
+		if (maxFps > 0.0)
+		{
+			double wait = frameStart + 1.0 / maxFps - glfwGetTime();
+			if (wait > 0.0)
+			{
+				std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+			}
+		}
+		frameStart = glfwGetTime();
+		auto simulationStart = std::chrono::steady_clock::now();
+		frameGraph.execute();
+		simulationMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - simulationStart).count();
+
+		// Com o pipeline cheio só trata eventos; o próximo quadro começa
+		// quando o desenho entrega um dos que estão em andamento
+		while (!renderThread.canBegin() && !glfwWindowShouldClose(window))
+		{
+			glfwWaitEventsTimeout(0.001);
+		}
+		reportStartup();
 	}
+	double loopSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - loopStart).count();
+	renderThread.stop();
+	reportStartup();
+	glfwMakeContextCurrent(window);
+	printPipelineStats();
+	std::cout << "Throughput: " << renderThread.getPublishStats().published << " frames in " << loopSeconds << " s ("
+		<< renderThread.getPublishStats().published / loopSeconds << " fps)" << std::endl;
+
+	// Pede pra OpenGL desalocar os buffers e texturas compartilhados
+	renderPaths.destroy();
+	gpuCuller.destroy();
+	indirectRenderer.destroy();
+	uniformBuffers.destroy();
+	lightClusters.destroy();
+	assets.clear();
 	// Finaliza a execução da GLFW, limpando os recursos alocados por ela
 	glfwTerminate();
 	return 0;
 }
 
+// Um quadro na thread de desenho, só a partir do snapshot: nada aqui lê a
+// cena, a câmera ou as luzes do loop principal. Os assets em streaming
+// entram antes do desenho, dentro do orçamento
+void renderFrame(const RenderSnapshot& snapshot, AssetRegistry& assets)
+{
+	GlState::get().beginFrame();
+	assets.pumpStreaming(uploadBudget);
+
+	// Limpa o buffer de cor
+	glClearColor(1.0f, 1.0f, 1.0f, 1.0f); //cor de fundo
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	glLineWidth(10);
+	glPointSize(20);
+
+	if (snapshot.lights != renderLights)
+	{
+		renderLights = snapshot.lights;
+		lightClusters.setLights(*renderLights);
+	}
+	// Câmera vai para o UBO num único glBufferSubData; as luzes são
+	// distribuídas nos clusters da nova posição da câmera
+	uniformBuffers.setCamera(snapshot.camera);
+	uniformBuffers.upload();
+	lightClusters.update(snapshot.camera, snapshot.width, snapshot.height);
+	assets.getMaterials().upload();
+	indirectRenderer.setMode(snapshot.renderMode);
+
+	if (snapshot.gpuCulling)
+	{
+		// Na GPU: frustum, oclusão em duas fases e desenho sem a lista passar pela CPU
+		if (snapshot.pathTables)
+		{
+			renderPaths.setTables(snapshot.pathTables);
+			renderPaths.setTime(snapshot.simulationStep, snapshot.alpha);
+		}
+		gpuCuller.render(snapshot.scene, snapshot.camera, snapshot.pathTables ? &renderPaths : nullptr);
+	}
+	else
+	{
+		indirectRenderer.begin(snapshot.camera.getViewMatrix());
+		for (uint32_t entity : snapshot.visible)
+		{
+			indirectRenderer.submit(snapshot.scene, entity);
+		}
+		// Um glMultiDrawElementsIndirect por textura
+		indirectRenderer.flush();
+	}
+
+	if (snapshot.statsRequest != renderStatsRequest)
+	{
+		renderStatsRequest = snapshot.statsRequest;
+		printRenderStats(snapshot, assets);
+	}
+}
+
 // Função de callback de teclado - só pode ter uma instância (deve ser estática se
 // estiver dentro de uma classe) - É chamada sempre que uma tecla for pressionada
-// ou solta via GLFW
+// ou solta via GLFW. Os três callbacks só enfileiram o evento; se a fila
+// encher (loop principal parado) o evento é perdido e contado
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode)
+{
+	InputEvent event;
+	event.type = InputEvent::Type::Key;
+	event.code = key;
+	event.action = action;
+	if (!inputQueue.push(event))
+	{
+		droppedInputs++;
+	}
+}
+
+void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+	InputEvent event;
+	event.type = InputEvent::Type::CursorPos;
+	event.x = xpos;
+	event.y = ypos;
+	if (!inputQueue.push(event))
+	{
+		droppedInputs++;
+	}
+}
+
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
+{
+	InputEvent event;
+	event.type = InputEvent::Type::MouseButton;
+	event.code = button;
+	event.action = action;
+	if (!inputQueue.push(event))
+	{
+		droppedInputs++;
+	}
+}
+
+void handleInput(GLFWwindow* window, const InputEvent& event)
+{
+	switch (event.type)
+	{
+	case InputEvent::Type::Key:
+		handleKey(window, event.code, event.action);
+		break;
+	case InputEvent::Type::CursorPos:
+		camera.mouseCallback(event.x, event.y);
+		break;
+	case InputEvent::Type::MouseButton:
+		handleMouseButton(event.code, event.action);
+		break;
+	}
+}
+
+void handleKey(GLFWwindow* window, int key, int action)
 {
 	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
 		glfwSetWindowShouldClose(window, GL_TRUE);
 
 	if(key == GLFW_KEY_PERIOD && action == GLFW_PRESS) 
 	{
-		selectedObject = (selectedObject + 1) % objects.size();
-		std::cout << "Selected object: " << selectedObject << std::endl;
+		scene.select((scene.getSelected() + 1) % scene.size());
+		std::cout << "Selected object: " << scene.getSelected() << std::endl;
 	}
 
 	if (key == GLFW_KEY_COMMA && action == GLFW_PRESS)
 	{
-		selectedObject = (selectedObject - 1) % objects.size();
-		std::cout << "Selected object: " << selectedObject << std::endl;
+		scene.select((scene.getSelected() + scene.size() - 1) % scene.size());
+		std::cout << "Selected object: " << scene.getSelected() << std::endl;
 	}
 
 	if(key == GLFW_KEY_UP && action == GLFW_PRESS) 
 	{
-		if(!isUpdatingObjects)
-			objects[selectedObject].clearWaypoints();
-		objects[selectedObject].setPosition(objects[selectedObject].getPosition() + glm::vec3(0.0f, 0.0f, -0.1f));
+		moveSelected(glm::vec3(0.0f, 0.0f, -0.1f));
 	}
 
 	if (key == GLFW_KEY_DOWN && action == GLFW_PRESS)
 	{
-		if (!isUpdatingObjects)
-			objects[selectedObject].clearWaypoints();
-		objects[selectedObject].setPosition(objects[selectedObject].getPosition() + glm::vec3(0.0f, 0.0f, 0.1f));
+		moveSelected(glm::vec3(0.0f, 0.0f, 0.1f));
 	}
 
 	if (key == GLFW_KEY_LEFT && action == GLFW_PRESS)
 	{
-		if (!isUpdatingObjects)
-			objects[selectedObject].clearWaypoints();
-		objects[selectedObject].setPosition(objects[selectedObject].getPosition() + glm::vec3(-0.1f, 0.0f, 0.0f));
+		moveSelected(glm::vec3(-0.1f, 0.0f, 0.0f));
 	}
 
 	if (key == GLFW_KEY_RIGHT && action == GLFW_PRESS)
 	{
-		if (!isUpdatingObjects)
-			objects[selectedObject].clearWaypoints();
-		objects[selectedObject].setPosition(objects[selectedObject].getPosition() + glm::vec3(0.1f, 0.0f, 0.0f));
+		moveSelected(glm::vec3(0.1f, 0.0f, 0.0f));
 	}
 
 	if (key == GLFW_KEY_I && action == GLFW_PRESS)
 	{
-		if (!isUpdatingObjects)
-			objects[selectedObject].clearWaypoints();
-		objects[selectedObject].setPosition(objects[selectedObject].getPosition() + glm::vec3(0.0f, 0.1f, 0.0f));
+		moveSelected(glm::vec3(0.0f, 0.1f, 0.0f));
 	}
 
 	if (key == GLFW_KEY_J && action == GLFW_PRESS)
 	{
-		if (!isUpdatingObjects)
-			objects[selectedObject].clearWaypoints();
-		objects[selectedObject].setPosition(objects[selectedObject].getPosition() + glm::vec3(0.0f, -0.1f, -0.0f));
+		moveSelected(glm::vec3(0.0f, -0.1f, -0.0f));
 	}
 
 	if(key == GLFW_KEY_O && action == GLFW_PRESS) 
 	{
-		objects[selectedObject].setScale(objects[selectedObject].getScale() + glm::vec3(0.1f, 0.1f, 0.1f));
+		if (scene.getSelected() != NULL_ENTITY)
+		{
+			Transform& transform = scene.getTransform(scene.getSelected());
+			transform.setScale(transform.scale + glm::vec3(0.1f, 0.1f, 0.1f));
+		}
 	}
 
 	if (key == GLFW_KEY_K && action == GLFW_PRESS)
 	{
-		objects[selectedObject].setScale(objects[selectedObject].getScale() + glm::vec3(-0.1f, -0.1f, -0.1f));
+		if (scene.getSelected() != NULL_ENTITY)
+		{
+			Transform& transform = scene.getTransform(scene.getSelected());
+			transform.setScale(transform.scale + glm::vec3(-0.1f, -0.1f, -0.1f));
+		}
 	}
 
 	if( key == GLFW_KEY_T && action == GLFW_PRESS)
@@ -282,6 +840,7 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 		{	
 			l.setLightIntensity(l.getLightIntensity() + glm::vec3(0.1f, 0.1f, 0.1f));
 		}
+		publishedLights = std::make_shared<const std::vector<Light>>(lights);
 	}
 
 	if (key == GLFW_KEY_G && action == GLFW_PRESS)
@@ -290,12 +849,252 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 		{
 			l.setLightIntensity(l.getLightIntensity() - glm::vec3(0.1f, 0.1f, 0.1f));
 		}
+		publishedLights = std::make_shared<const std::vector<Light>>(lights);
+	}
+
+	if (key == GLFW_KEY_M && action == GLFW_PRESS)
+	{
+		bool indirect = renderMode == IndirectRenderer::Mode::MultiDrawIndirect;
+		renderMode = indirect ? IndirectRenderer::Mode::PerObject : IndirectRenderer::Mode::MultiDrawIndirect;
+		std::cout << "Render path: " << (indirect ? "per object" : "multi-draw indirect") << std::endl;
+	}
+
+	if (key == GLFW_KEY_C && action == GLFW_PRESS)
+	{
+		cullMode = cullMode == CullMode::Simd ? CullMode::Tree : cullMode == CullMode::Tree ? CullMode::Gpu
+			: cullMode == CullMode::Gpu ? CullMode::Off : CullMode::Simd;
+		std::cout << "Frustum culling: " << (cullMode == CullMode::Simd ? "SIMD scan" : cullMode == CullMode::Tree ? "BVH"
+			: cullMode == CullMode::Gpu ? "GPU compute" : "off") << std::endl;
+	}
+
+	if (key == GLFW_KEY_L && action == GLFW_PRESS)
+	{
+		renderThread.setPipelineDepth(renderThread.getPipelineDepth() % RenderThread::MAX_PIPELINE_DEPTH + 1);
+		std::cout << "Pipeline depth: " << renderThread.getPipelineDepth() << " frames" << std::endl;
+	}
+
+	if (key == GLFW_KEY_V && action == GLFW_PRESS)
+	{
+		gpuPathsEnabled = !gpuPathsEnabled;
+		std::cout << "Path animation: " << (gpuPathsEnabled ? "GPU (with GPU culling)" : "CPU") << std::endl;
+	}
+
+	if (key == GLFW_KEY_H && action == GLFW_PRESS)
+	{
+		occlusionEnabled = !occlusionEnabled;
+		std::cout << "Occlusion culling: " << (occlusionEnabled ? "on" : "off") << std::endl;
+	}
+
+	if (key == GLFW_KEY_B && action == GLFW_PRESS)
+	{
+		sceneTree.benchmark(camera.getProjectionMatrix() * camera.getViewMatrix(), camera.getPosition(), camera.getLookAt());
+	}
+
+	// O lado da simulação imprime agora; o do desenho quando o próximo
+	// snapshot chegar lá (printRenderStats)
+	if (key == GLFW_KEY_P && action == GLFW_PRESS)
+	{
+		const TransformSystem::Stats& transformStats = transformSystem.getStats();
+		std::cout << "Transforms: " << transformStats.objects << ", recomposed: " << transformStats.dirty
+			<< ", compose: " << transformStats.composeMilliseconds << " ms" << std::endl;
+		const PathSystem::Stats& pathStats = pathSystem.getStats();
+		std::cout << "Paths: " << pathStats.paths << ", segments: " << pathStats.segments << ", jobs: " << pathStats.jobs
+			<< ", rebuilds: " << pathStats.rebuilds << ", update: " << pathStats.updateMilliseconds << " ms" << std::endl;
+		const SimulationClock::Stats& clockStats = simulationClock.getStats();
+		std::cout << "Simulation: step " << clockStats.totalSteps << " (" << 1.0 / SimulationClock::STEP << " Hz), steps this frame: " << clockStats.steps
+			<< ", alpha: " << clockStats.alpha << ", dropped: " << clockStats.droppedSteps << ", frame: " << clockStats.frameMilliseconds << " ms" << std::endl;
+		const RenderThread::PublishStats& publishStats = renderThread.getPublishStats();
+		std::cout << "Main thread: " << simulationMilliseconds << " ms per frame, snapshots published: " << publishStats.published
+			<< ", in flight: " << publishStats.inFlight << " of " << renderThread.getPipelineDepth() << ", models copied: " << publishStats.copiedModels
+			<< (publishStats.fullCopy ? " (full copy)" : "") << ", input events dropped: " << droppedInputs << std::endl;
+		frameGraph.printStats();
+		const FrustumCuller::Stats& cullStats = frustumCuller.getStats();
+		std::cout << "Visible: " << cullStats.visible << ", culled: " << cullStats.culled
+			<< ", cull: " << cullStats.cullMilliseconds << " ms" << std::endl;
+		const SceneTree::Stats& treeStats = sceneTree.getStats();
+		std::cout << "BVH proxies: " << treeStats.proxies << ", height: " << treeStats.height
+			<< ", reinserted: " << treeStats.reinserted << ", sync: " << treeStats.syncMilliseconds << " ms"
+			<< ", visible: " << treeStats.visible << ", cull: " << treeStats.cullMilliseconds << " ms" << std::endl;
+		const OcclusionCuller::Stats& occlusionStats = occlusionCuller.getStats();
+		std::cout << "Occluders: " << occlusionStats.occluders << " (" << occlusionStats.triangles << " triangles, "
+			<< occlusionStats.jobs << " jobs), tested: " << occlusionStats.tested << ", occluded: " << occlusionStats.occluded
+			<< ", raster: " << occlusionStats.rasterMilliseconds << " ms, test: " << occlusionStats.testMilliseconds << " ms" << std::endl;
+		statsRequest++;
 	}
 }
 
-void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+// Estatísticas dos sistemas que só a thread de desenho toca
+void printRenderStats(const RenderSnapshot& snapshot, AssetRegistry& assets)
 {
-	camera.mouseCallback(xpos, ypos);
+	const IndirectRenderer::Stats& stats = indirectRenderer.getStats();
+	std::cout << "Objects: " << snapshot.scene.size() << ", instances: " << stats.instances
+		<< ", commands: " << stats.commands << ", buckets: " << stats.buckets
+		<< ", draw calls: " << stats.drawCalls
+		<< ", sort: " << stats.sortMilliseconds << " ms"
+		<< ", CPU submit: " << stats.submitMilliseconds << " ms"
+		<< ", UBO uploads: " << uniformBuffers.getUploads() << std::endl;
+	const GlState::Stats& glStats = GlState::get().getStats();
+	const char* callNames[GlState::CALL_COUNT] = { "program", "VAO", "texture", "buffer", "uniform" };
+	std::cout << "GL calls issued/skipped:";
+	for (int call = 0; call < GlState::CALL_COUNT; ++call)
+	{
+		std::cout << " " << callNames[call] << " " << glStats.issued[call] << "/" << glStats.skipped[call];
+	}
+	std::cout << std::endl;
+	const LightClusters::Stats& lightStats = lightClusters.getStats();
+	std::cout << "Lights: " << lightStats.lights << ", visible: " << lightStats.visibleLights
+		<< ", cluster references: " << lightStats.references << ", max per cluster: " << lightStats.maxPerCluster
+		<< ", binning: " << lightStats.binMilliseconds << " ms" << std::endl;
+	const RenderThread::Stats& threadStats = renderThread.getStats();
+	std::cout << "Render thread: frames: " << threadStats.rendered << ", render: " << threadStats.renderMilliseconds
+		<< " ms, idle: " << threadStats.idleMilliseconds << " ms" << std::endl;
+	printPipelineStats();
+	const AssetRegistry::StreamStats& streamStats = assets.getStreamStats();
+	if (streamStats.frames > 0)
+	{
+		std::cout << "Streaming: " << streamStats.pending << " assets pending, " << streamStats.resident << " resident, "
+			<< streamStats.stagedBytes / (1024.0 * 1024.0) << " MB staged, upload " << streamStats.lastPumpMilliseconds
+			<< " ms (max " << streamStats.maxPumpMilliseconds << " ms, budget " << streamStats.budgetMilliseconds << " ms), "
+			<< streamStats.stalledFrames << " frames waiting for the staging ring" << std::endl;
+	}
+	if (snapshot.gpuCulling)
+	{
+		const GpuCuller::Stats& gpuStats = gpuCuller.readStats();
+		std::cout << "GPU cull: " << gpuStats.objects << " objects, " << gpuStats.slots << " slots, draw calls: " << gpuStats.drawCalls
+			<< ", early: " << gpuStats.earlyDrawn << ", late: " << gpuStats.lateDrawn << ", frustum culled: " << gpuStats.frustumCulled
+			<< ", occluded: " << gpuStats.occluded << ", uploaded: " << gpuStats.uploadedObjects
+			<< ", CPU submit: " << gpuStats.submitMilliseconds << " ms"
+			<< ", GPU: " << gpuStats.gpuMilliseconds << " ms" << std::endl;
+	}
+	if (snapshot.pathTables)
+	{
+		const GpuPaths::Stats& pathGpuStats = renderPaths.readStats();
+		std::cout << "GPU paths: " << pathGpuStats.paths << ", segments: " << pathGpuStats.segments
+			<< ", buffers: " << pathGpuStats.bytes << " bytes, uploads: " << pathGpuStats.uploads
+			<< ", GPU: " << pathGpuStats.gpuMilliseconds << " ms, max error vs CPU: " << pathGpuStats.maxError << std::endl;
+	}
+}
+
+// Latência média de cada quadro desde a última troca de profundidade (na
+// thread de desenho, ou depois que ela parou)
+void printPipelineStats()
+{
+	const RenderThread::Stats& stats = renderThread.getStats();
+	std::cout << "Pipeline depth " << stats.pipelineDepth << ": input to present " << stats.latencyMilliseconds
+		<< " ms (simulate " << stats.simulateMilliseconds << " ms, queued " << stats.queuedMilliseconds
+		<< " ms, render " << stats.presentMilliseconds << " ms) over " << stats.measuredFrames << " frames" << std::endl;
+}
+
+// Clique esquerdo seleciona o objeto no centro da tela (o cursor fica preso),
+// com um raio da câmera consultado na BVH
+void handleMouseButton(int button, int action)
+{
+	if (button != GLFW_MOUSE_BUTTON_LEFT || action != GLFW_PRESS)
+		return;
+
+	int hit = sceneTree.pick(camera.getPosition(), camera.getLookAt(), camera.getFarPlane());
+	if (hit < 0)
+	{
+		std::cout << "No object under the crosshair" << std::endl;
+		return;
+	}
+	scene.select(hit);
+	std::vector<uint32_t> overlaps;
+	sceneTree.queryOverlaps(sceneTree.getBounds(hit), overlaps);
+	std::cout << "Selected object: " << hit << " (overlapping " << overlaps.size() - 1 << " others)" << std::endl;
+}
+
+// Completa a lista de luzes com luzes aleatórias (semente fixa) espalhadas
+// em volta da cena, cada uma com alcance curto
+void generateLights(size_t count)
+{
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+	std::uniform_real_distribution<float> color(0.2f, 1.0f);
+	std::uniform_real_distribution<float> range(1.5f, 4.0f);
+	for (size_t i = lights.size(); i < count; ++i)
+	{
+		lights.emplace_back(glm::vec3(position(random), position(random) * 0.5f, position(random)),
+			glm::vec3(color(random), color(random), color(random)), range(random));
+	}
+}
+
+// Copia os objetos carregados numa grade ao lado da cena até chegar em count.
+// As cópias ficam paradas (só Transform e Renderable, sem caminho)
+void replicateObjects(size_t count)
+{
+	size_t original = scene.size();
+	if (original == 0 || count <= original)
+	{
+		return;
+	}
+
+	size_t side = static_cast<size_t>(std::ceil(std::cbrt(static_cast<double>(count))));
+	for (size_t i = original; i < count; ++i)
+	{
+		Entity source = static_cast<Entity>(i % original);
+		Entity copy = scene.createEntity();
+		Transform& transform = scene.getTransform(copy);
+		transform = scene.getTransform(source);
+		glm::vec3 cell(float(i % side), float((i / side) % side), float(i / (side * side)));
+		transform.setPosition(transform.position + cell * 3.0f + glm::vec3(5.0f, 0.0f, 0.0f));
+		scene.getRenderable(copy) = scene.getRenderable(source);
+	}
+	std::cout << "Replicated scene to " << scene.size() << " objects" << std::endl;
+}
+
+// Teclas seguradas da entidade selecionada, uma vez por passo da simulação:
+// E grava a posição da câmera como waypoint, Z/X/Y giram 0.01 rad por passo
+void processInput(GLFWwindow* window)
+{
+	Entity selected = scene.getSelected();
+	if (selected == NULL_ENTITY)
+	{
+		return;
+	}
+	Selection* selection = scene.getSelection();
+	if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS)
+	{
+		if (!selection->addWaypointKeyPressed)
+		{
+			scene.addWaypoint(selected, camera.getPosition());
+			selection->addWaypointKeyPressed = true;
+			std::cout << "Waypoint adicionado: " << camera.getPosition().x << ", " << camera.getPosition().y << ", " << camera.getPosition().z << std::endl;
+		}
+	}
+	else
+	{
+		selection->addWaypointKeyPressed = false;
+	}
+
+	Transform& transform = scene.getTransform(selected);
+	if (glfwGetKey(window, GLFW_KEY_Z) == GLFW_PRESS)
+	{
+		transform.setRotateAngle(transform.rotateAngle + glm::vec3(0.0f, 0.0f, 0.01f));
+	}
+
+	if (glfwGetKey(window, GLFW_KEY_X) == GLFW_PRESS)
+	{
+		transform.setRotateAngle(transform.rotateAngle + glm::vec3(0.01f, 0.0f, 0.0f));
+	}
+
+	if (glfwGetKey(window, GLFW_KEY_Y) == GLFW_PRESS)
+	{
+		transform.setRotateAngle(transform.rotateAngle + glm::vec3(0.0f, 0.01f, 0.0f));
+	}
+}
+
+// Mover à mão tira a entidade do caminho
+void moveSelected(const glm::vec3& offset)
+{
+	Entity selected = scene.getSelected();
+	if (selected == NULL_ENTITY)
+	{
+		return;
+	}
+	scene.clearWaypoints(selected);
+	Transform& transform = scene.getTransform(selected);
+	transform.setPosition(transform.position + offset);
 }
 
 //Esta função está basntante hardcoded - objetivo é compilar e "buildar" um programa de
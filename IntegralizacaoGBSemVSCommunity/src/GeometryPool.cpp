@@ -0,0 +1,238 @@
+#include "GeometryPool.h"
+#include "GlState.h"
+#include "Mesh.h"
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+namespace
+{
+	// Capacidade inicial: cobre as malhas da cena padrão sem crescer
+	const size_t INITIAL_VERTICES = 64 * 1024;
+	const size_t INITIAL_INDICES = 256 * 1024;
+	const size_t VERTEX_BYTES = VERTEX_FLOATS * sizeof(GLfloat);
+}
+
+void GeometryPool::RangeAllocator::reset(size_t capacity)
+{
+	m_free.clear();
+	m_free[0] = capacity;
+	m_capacity = capacity;
+	m_used = 0;
+}
+
+void GeometryPool::RangeAllocator::grow(size_t newCapacity)
+{
+	insertFree(m_capacity, newCapacity - m_capacity);
+	m_capacity = newCapacity;
+}
+
+bool GeometryPool::RangeAllocator::allocate(size_t count, size_t& offset)
+{
+	for (auto it = m_free.begin(); it != m_free.end(); ++it)
+	{
+		if (it->second >= count)
+		{
+			offset = it->first;
+			size_t remaining = it->second - count;
+			m_free.erase(it);
+			if (remaining > 0)
+			{
+				m_free[offset + count] = remaining;
+			}
+			m_used += count;
+			return true;
+		}
+	}
+	return false;
+}
+
+void GeometryPool::RangeAllocator::release(size_t offset, size_t count)
+{
+	m_used -= count;
+	insertFree(offset, count);
+}
+
+void GeometryPool::RangeAllocator::insertFree(size_t offset, size_t count)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	// Junta com os vizinhos livres para não fragmentar
+	auto next = m_free.lower_bound(offset);
+	if (next != m_free.end() && offset + count == next->first)
+	{
+		count += next->second;
+		next = m_free.erase(next);
+	}
+	if (next != m_free.begin())
+	{
+		auto prev = std::prev(next);
+		if (prev->first + prev->second == offset)
+		{
+			prev->second += count;
+			return;
+		}
+	}
+	m_free[offset] = count;
+}
+
+void GeometryPool::init()
+{
+	if (m_VAO != 0)
+	{
+		return;
+	}
+
+	m_vertices.reset(INITIAL_VERTICES);
+	m_indices.reset(INITIAL_INDICES);
+
+	glGenVertexArrays(1, &m_VAO);
+	glGenBuffers(1, &m_VBO);
+	glGenBuffers(1, &m_EBO);
+
+	GlState::get().bindBuffer(GL_ARRAY_BUFFER, m_VBO);
+	glBufferData(GL_ARRAY_BUFFER, INITIAL_VERTICES * VERTEX_BYTES, nullptr, GL_STATIC_DRAW);
+	GlState::get().bindBuffer(GL_ARRAY_BUFFER, 0);
+
+	bindLayout();
+
+	GlState::get().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, INITIAL_INDICES * sizeof(GLuint), nullptr, GL_STATIC_DRAW);
+	GlState::get().bindVertexArray(0);
+}
+
+void GeometryPool::destroy()
+{
+	GlState::get().deleteVertexArrays(1, &m_VAO);
+	GlState::get().deleteBuffers(1, &m_VBO);
+	GlState::get().deleteBuffers(1, &m_EBO);
+	m_VAO = m_VBO = m_EBO = 0;
+}
+
+void GeometryPool::bindLayout()
+{
+	GlState::get().bindVertexArray(m_VAO);
+	GlState::get().bindBuffer(GL_ARRAY_BUFFER, m_VBO);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof(float), (void*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof(float), (void*)(6 * sizeof(float)));
+	glEnableVertexAttribArray(2);
+	GlState::get().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+	GlState::get().bindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GeometryPool::growBuffer(GLuint& buffer, size_t oldBytes, size_t newBytes)
+{
+	GLuint bigger;
+	glGenBuffers(1, &bigger);
+	GlState::get().bindBuffer(GL_COPY_WRITE_BUFFER, bigger);
+	glBufferData(GL_COPY_WRITE_BUFFER, newBytes, nullptr, GL_STATIC_DRAW);
+	GlState::get().bindBuffer(GL_COPY_READ_BUFFER, buffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldBytes);
+	GlState::get().bindBuffer(GL_COPY_READ_BUFFER, 0);
+	GlState::get().bindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	GlState::get().deleteBuffers(1, &buffer);
+	buffer = bigger;
+}
+
+bool GeometryPool::allocate(const void* vertices, GLuint vertexCount, const GLuint* indices, GLuint indexCount,
+	MeshRange& range)
+{
+	if (!reserve(vertexCount, indexCount, range))
+	{
+		return false;
+	}
+
+	GlState::get().bindBuffer(GL_ARRAY_BUFFER, m_VBO);
+	glBufferSubData(GL_ARRAY_BUFFER, range.baseVertex * VERTEX_BYTES, vertexCount * VERTEX_BYTES, vertices);
+	GlState::get().bindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// GL_COPY_WRITE_BUFFER evita mexer no EBO do VAO que estiver ligado
+	GlState::get().bindBuffer(GL_COPY_WRITE_BUFFER, m_EBO);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, range.firstIndex * sizeof(GLuint), indexCount * sizeof(GLuint), indices);
+	GlState::get().bindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	return true;
+}
+
+bool GeometryPool::reserve(GLuint vertexCount, GLuint indexCount, MeshRange& range)
+{
+	init();
+
+	size_t vertexOffset, indexOffset;
+	if (!m_vertices.allocate(vertexCount, vertexOffset))
+	{
+		size_t oldCapacity = m_vertices.capacity();
+		size_t newCapacity = std::max(oldCapacity * 2, oldCapacity + vertexCount);
+		growBuffer(m_VBO, oldCapacity * VERTEX_BYTES, newCapacity * VERTEX_BYTES);
+		m_vertices.grow(newCapacity);
+		bindLayout();
+		GlState::get().bindVertexArray(0);
+		if (!m_vertices.allocate(vertexCount, vertexOffset))
+		{
+			return false;
+		}
+	}
+	if (!m_indices.allocate(indexCount, indexOffset))
+	{
+		size_t oldCapacity = m_indices.capacity();
+		size_t newCapacity = std::max(oldCapacity * 2, oldCapacity + indexCount);
+		growBuffer(m_EBO, oldCapacity * sizeof(GLuint), newCapacity * sizeof(GLuint));
+		m_indices.grow(newCapacity);
+		bindLayout();
+		GlState::get().bindVertexArray(0);
+		if (!m_indices.allocate(indexCount, indexOffset))
+		{
+			m_vertices.release(vertexOffset, vertexCount);
+			return false;
+		}
+	}
+
+	range.firstIndex = static_cast<GLuint>(indexOffset);
+	range.indexCount = indexCount;
+	range.baseVertex = static_cast<GLint>(vertexOffset);
+	range.vertexCount = vertexCount;
+	return true;
+}
+
+void GeometryPool::copyVertices(GLuint source, size_t sourceOffset, const MeshRange& range, size_t offset, size_t bytes)
+{
+	GlState::get().bindBuffer(GL_COPY_READ_BUFFER, source);
+	GlState::get().bindBuffer(GL_COPY_WRITE_BUFFER, m_VBO);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, sourceOffset, range.baseVertex * VERTEX_BYTES + offset, bytes);
+	GlState::get().bindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	GlState::get().bindBuffer(GL_COPY_READ_BUFFER, 0);
+}
+
+void GeometryPool::copyIndices(GLuint source, size_t sourceOffset, const MeshRange& range, size_t offset, size_t bytes)
+{
+	GlState::get().bindBuffer(GL_COPY_READ_BUFFER, source);
+	GlState::get().bindBuffer(GL_COPY_WRITE_BUFFER, m_EBO);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, sourceOffset, range.firstIndex * sizeof(GLuint) + offset, bytes);
+	GlState::get().bindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	GlState::get().bindBuffer(GL_COPY_READ_BUFFER, 0);
+}
+
+void GeometryPool::release(const MeshRange& range)
+{
+	if (range.vertexCount == 0 && range.indexCount == 0)
+	{
+		return;
+	}
+	m_vertices.release(static_cast<size_t>(range.baseVertex), range.vertexCount);
+	m_indices.release(range.firstIndex, range.indexCount);
+}
+
+size_t GeometryPool::getVertexBytesUsed() const
+{
+	return m_vertices.used() * VERTEX_BYTES;
+}
+
+size_t GeometryPool::getIndexBytesUsed() const
+{
+	return m_indices.used() * sizeof(GLuint);
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+#include <map>
+
+// Faixa de uma malha dentro do GeometryPool
+struct MeshRange
+{
+	GLuint firstIndex = 0;
+	GLuint indexCount = 0;
+	GLint baseVertex = 0;
+	GLuint vertexCount = 0;
+};
+
+// Um único VBO + EBO (índices de 32 bits) com o formato de vértice comum a
+// todas as malhas, e um VAO que já aponta para eles. As malhas são
+// sub-alocadas aqui, então um quadro inteiro desenha com um único bind de VAO.
+// Os buffers crescem por cópia (glCopyBufferSubData) quando enchem, e as
+// faixas liberadas voltam para uma lista livre.
+class GeometryPool
+{
+public:
+	// Pode ser chamado mais de uma vez; só cria os objetos na primeira
+	void init();
+	void destroy();
+
+	bool allocate(const void* vertices, GLuint vertexCount, const GLuint* indices, GLuint indexCount,
+		MeshRange& range);
+	// Só a faixa: o conteúdo chega depois, aos pedaços, de um buffer de
+	// upload (índices já em 32 bits). Os offsets são em bytes dentro da faixa
+	bool reserve(GLuint vertexCount, GLuint indexCount, MeshRange& range);
+	void copyVertices(GLuint source, size_t sourceOffset, const MeshRange& range, size_t offset, size_t bytes);
+	void copyIndices(GLuint source, size_t sourceOffset, const MeshRange& range, size_t offset, size_t bytes);
+	void release(const MeshRange& range);
+
+	GLuint getVAO() const { return m_VAO; }
+	size_t getVertexBytesUsed() const;
+	size_t getIndexBytesUsed() const;
+private:
+	// Alocador first-fit sobre [0, capacidade) em unidades de elemento
+	class RangeAllocator
+	{
+	public:
+		void reset(size_t capacity);
+		void grow(size_t newCapacity);
+		bool allocate(size_t count, size_t& offset);
+		void release(size_t offset, size_t count);
+		size_t capacity() const { return m_capacity; }
+		size_t used() const { return m_used; }
+	private:
+		void insertFree(size_t offset, size_t count);
+
+		std::map<size_t, size_t> m_free;   // início -> tamanho
+		size_t m_capacity = 0;
+		size_t m_used = 0;
+	};
+
+	void growBuffer(GLuint& buffer, size_t oldBytes, size_t newBytes);
+	void bindLayout();
+
+	GLuint m_VAO = 0;
+	GLuint m_VBO = 0;
+	GLuint m_EBO = 0;
+	RangeAllocator m_vertices;
+	RangeAllocator m_indices;
+};
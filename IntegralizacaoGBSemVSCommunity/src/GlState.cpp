@@ -0,0 +1,269 @@
+#include "GlState.h"
+#include <cstring>
+#include <iterator>
+
+GlState& GlState::get()
+{
+	static GlState state;
+	return state;
+}
+
+GlState::GlState()
+{
+	// Estado inicial de um contexto novo: tudo desligado, unidade 0 ativa
+	invalidate();
+	m_program = m_vertexArray = m_activeUnit = 0;
+	for (GLint& texture : m_textures) texture = 0;
+	for (GLint& buffer : m_buffers) buffer = 0;
+	for (GLint& buffer : m_uniformBases) buffer = 0;
+	for (GLint& buffer : m_storageBases) buffer = 0;
+}
+
+void GlState::beginFrame()
+{
+	m_lastFrame = m_frame;
+	m_frame = Stats();
+}
+
+void GlState::invalidate()
+{
+	m_program = m_vertexArray = m_activeUnit = -1;
+	for (GLint& texture : m_textures) texture = -1;
+	for (GLint& buffer : m_buffers) buffer = -1;
+	for (GLint& buffer : m_uniformBases) buffer = -1;
+	for (GLint& buffer : m_storageBases) buffer = -1;
+	m_uniforms.clear();
+}
+
+bool GlState::skip(Call call, bool unchanged)
+{
+	if (unchanged)
+	{
+		m_frame.skipped[call]++;
+	}
+	else
+	{
+		m_frame.issued[call]++;
+	}
+	return unchanged;
+}
+
+int GlState::bufferSlot(GLenum target)
+{
+	switch (target)
+	{
+	case GL_ARRAY_BUFFER: return ARRAY_BUFFER;
+	case GL_COPY_READ_BUFFER: return COPY_READ_BUFFER;
+	case GL_COPY_WRITE_BUFFER: return COPY_WRITE_BUFFER;
+	case GL_DRAW_INDIRECT_BUFFER: return DRAW_INDIRECT_BUFFER;
+	case GL_PARAMETER_BUFFER_ARB: return PARAMETER_BUFFER;
+	case GL_SHADER_STORAGE_BUFFER: return SHADER_STORAGE_BUFFER;
+	case GL_UNIFORM_BUFFER: return UNIFORM_BUFFER;
+	case GL_PIXEL_PACK_BUFFER: return PIXEL_PACK_BUFFER;
+	case GL_PIXEL_UNPACK_BUFFER: return PIXEL_UNPACK_BUFFER;
+	default: return -1;
+	}
+}
+
+void GlState::useProgram(GLuint program)
+{
+	if (skip(PROGRAM, m_program == static_cast<GLint>(program)))
+	{
+		return;
+	}
+	glUseProgram(program);
+	m_program = static_cast<GLint>(program);
+}
+
+void GlState::bindVertexArray(GLuint vao)
+{
+	if (skip(VERTEX_ARRAY, m_vertexArray == static_cast<GLint>(vao)))
+	{
+		return;
+	}
+	glBindVertexArray(vao);
+	m_vertexArray = static_cast<GLint>(vao);
+}
+
+void GlState::activeTexture(GLenum unit)
+{
+	GLint index = static_cast<GLint>(unit - GL_TEXTURE0);
+	if (skip(TEXTURE, m_activeUnit == index))
+	{
+		return;
+	}
+	glActiveTexture(unit);
+	m_activeUnit = index;
+}
+
+void GlState::bindTexture(GLenum target, GLuint texture)
+{
+	bool tracked = target == GL_TEXTURE_2D && m_activeUnit >= 0 && m_activeUnit < TEXTURE_UNITS;
+	if (skip(TEXTURE, tracked && m_textures[m_activeUnit] == static_cast<GLint>(texture)))
+	{
+		return;
+	}
+	glBindTexture(target, texture);
+	if (tracked)
+	{
+		m_textures[m_activeUnit] = static_cast<GLint>(texture);
+	}
+	else if (m_activeUnit < 0)
+	{
+		// Unidade desconhecida: a ligação pode ter ido para qualquer uma
+		for (GLint& bound : m_textures) bound = -1;
+	}
+}
+
+void GlState::bindBuffer(GLenum target, GLuint buffer)
+{
+	int slot = bufferSlot(target);
+	if (skip(BUFFER, slot >= 0 && m_buffers[slot] == static_cast<GLint>(buffer)))
+	{
+		return;
+	}
+	glBindBuffer(target, buffer);
+	if (slot >= 0)
+	{
+		m_buffers[slot] = static_cast<GLint>(buffer);
+	}
+}
+
+void GlState::bindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+	GLint* bases = target == GL_UNIFORM_BUFFER ? m_uniformBases : target == GL_SHADER_STORAGE_BUFFER ? m_storageBases : nullptr;
+	bool tracked = bases && index < static_cast<GLuint>(INDEXED_BINDINGS);
+	int slot = bufferSlot(target);
+	if (skip(BUFFER, tracked && bases[index] == static_cast<GLint>(buffer) && slot >= 0 && m_buffers[slot] == static_cast<GLint>(buffer)))
+	{
+		return;
+	}
+	glBindBufferBase(target, index, buffer);
+	if (tracked)
+	{
+		bases[index] = static_cast<GLint>(buffer);
+	}
+	if (slot >= 0)
+	{
+		m_buffers[slot] = static_cast<GLint>(buffer);
+	}
+}
+
+bool GlState::uniformChanged(GLint location, const void* data, size_t size)
+{
+	// location -1 é ignorada pelo GL; programa desconhecido não dá para comparar
+	if (location < 0)
+	{
+		return !skip(UNIFORM, true);
+	}
+	if (m_program <= 0)
+	{
+		return !skip(UNIFORM, false);
+	}
+	std::vector<unsigned char>& last = m_uniforms[(static_cast<uint64_t>(m_program) << 32) | static_cast<uint32_t>(location)];
+	if (skip(UNIFORM, last.size() == size && std::memcmp(last.data(), data, size) == 0))
+	{
+		return false;
+	}
+	last.assign(static_cast<const unsigned char*>(data), static_cast<const unsigned char*>(data) + size);
+	return true;
+}
+
+void GlState::uniform1i(GLint location, GLint value)
+{
+	if (uniformChanged(location, &value, sizeof(value)))
+	{
+		glUniform1i(location, value);
+	}
+}
+
+void GlState::uniform1ui(GLint location, GLuint value)
+{
+	if (uniformChanged(location, &value, sizeof(value)))
+	{
+		glUniform1ui(location, value);
+	}
+}
+
+void GlState::uniform1f(GLint location, GLfloat value)
+{
+	if (uniformChanged(location, &value, sizeof(value)))
+	{
+		glUniform1f(location, value);
+	}
+}
+
+void GlState::uniform2i(GLint location, GLint x, GLint y)
+{
+	GLint value[2] = { x, y };
+	if (uniformChanged(location, value, sizeof(value)))
+	{
+		glUniform2i(location, x, y);
+	}
+}
+
+void GlState::uniform4fv(GLint location, GLsizei count, const GLfloat* value)
+{
+	if (uniformChanged(location, value, count * 4 * sizeof(GLfloat)))
+	{
+		glUniform4fv(location, count, value);
+	}
+}
+
+void GlState::uniformMatrix4fv(GLint location, GLsizei count, const GLfloat* value)
+{
+	if (uniformChanged(location, value, count * 16 * sizeof(GLfloat)))
+	{
+		glUniformMatrix4fv(location, count, GL_FALSE, value);
+	}
+}
+
+void GlState::deleteProgram(GLuint program)
+{
+	glDeleteProgram(program);
+	if (m_program == static_cast<GLint>(program))
+	{
+		m_program = -1;
+	}
+	for (auto it = m_uniforms.begin(); it != m_uniforms.end();)
+	{
+		it = (it->first >> 32) == program ? m_uniforms.erase(it) : std::next(it);
+	}
+}
+
+void GlState::deleteVertexArrays(GLsizei count, const GLuint* arrays)
+{
+	glDeleteVertexArrays(count, arrays);
+	for (GLsizei i = 0; i < count; ++i)
+	{
+		if (m_vertexArray == static_cast<GLint>(arrays[i]))
+		{
+			m_vertexArray = 0;
+		}
+	}
+}
+
+void GlState::deleteTextures(GLsizei count, const GLuint* textures)
+{
+	glDeleteTextures(count, textures);
+	for (GLsizei i = 0; i < count; ++i)
+	{
+		for (GLint& bound : m_textures)
+		{
+			if (bound == static_cast<GLint>(textures[i])) bound = 0;
+		}
+	}
+}
+
+void GlState::deleteBuffers(GLsizei count, const GLuint* buffers)
+{
+	glDeleteBuffers(count, buffers);
+	for (GLsizei i = 0; i < count; ++i)
+	{
+		GLint buffer = static_cast<GLint>(buffers[i]);
+		for (GLint& bound : m_buffers) if (bound == buffer) bound = 0;
+		// As ligações indexadas o GL não desfaz sozinho de forma garantida
+		for (GLint& bound : m_uniformBases) if (bound == buffer) bound = -1;
+		for (GLint& bound : m_storageBases) if (bound == buffer) bound = -1;
+	}
+}
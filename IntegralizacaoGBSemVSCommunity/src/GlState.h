@@ -0,0 +1,105 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Cópia do estado de ligação do contexto GL (programa, VAO, texturas por
+// unidade, buffers por alvo e por índice, valores de uniform) que só repassa
+// ao driver as chamadas que mudam alguma coisa. Todo o código do projeto
+// passa por aqui; uma chamada direta a glBind* dessincroniza a cópia, e
+// nesse caso invalidate() volta tudo para "desconhecido".
+//
+// Os contadores são por quadro: beginFrame() fecha o quadro anterior, que é
+// o que getStats() devolve (tecla P).
+class GlState
+{
+public:
+	enum Call
+	{
+		PROGRAM,
+		VERTEX_ARRAY,
+		TEXTURE,
+		BUFFER,
+		UNIFORM,
+		CALL_COUNT
+	};
+
+	static constexpr int TEXTURE_UNITS = 16;
+	static constexpr int INDEXED_BINDINGS = 16;
+
+	struct Stats
+	{
+		unsigned issued[CALL_COUNT] = {};
+		unsigned skipped[CALL_COUNT] = {};
+	};
+
+	// Um contexto, uma cópia
+	static GlState& get();
+
+	void beginFrame();
+	void invalidate();
+
+	void useProgram(GLuint program);
+	GLuint getProgram() const { return m_program > 0 ? static_cast<GLuint>(m_program) : 0; }
+	void bindVertexArray(GLuint vao);
+	void activeTexture(GLenum unit);
+	// Só GL_TEXTURE_2D é acompanhado; outros alvos vão direto
+	void bindTexture(GLenum target, GLuint texture);
+	// GL_ELEMENT_ARRAY_BUFFER faz parte do VAO e sempre vai direto
+	void bindBuffer(GLenum target, GLuint buffer);
+	// Também liga o alvo genérico, como no GL
+	void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+
+	// Uniforms do programa em uso, comparados com o último valor enviado
+	void uniform1i(GLint location, GLint value);
+	void uniform1ui(GLint location, GLuint value);
+	void uniform1f(GLint location, GLfloat value);
+	void uniform2i(GLint location, GLint x, GLint y);
+	void uniform4fv(GLint location, GLsizei count, const GLfloat* value);
+	void uniformMatrix4fv(GLint location, GLsizei count, const GLfloat* value);
+
+	// Apagam os objetos e esquecem qualquer ligação a eles
+	void deleteProgram(GLuint program);
+	void deleteVertexArrays(GLsizei count, const GLuint* arrays);
+	void deleteTextures(GLsizei count, const GLuint* textures);
+	void deleteBuffers(GLsizei count, const GLuint* buffers);
+
+	const Stats& getStats() const { return m_lastFrame; }
+private:
+	GlState();
+
+	enum BufferTarget
+	{
+		ARRAY_BUFFER,
+		COPY_READ_BUFFER,
+		COPY_WRITE_BUFFER,
+		DRAW_INDIRECT_BUFFER,
+		PARAMETER_BUFFER,
+		SHADER_STORAGE_BUFFER,
+		UNIFORM_BUFFER,
+		PIXEL_PACK_BUFFER,
+		PIXEL_UNPACK_BUFFER,
+		BUFFER_TARGET_COUNT
+	};
+
+	static int bufferSlot(GLenum target);
+	// true (e guarda o valor) quando o uniform precisa ser enviado
+	bool uniformChanged(GLint location, const void* data, size_t size);
+	bool skip(Call call, bool unchanged);
+
+	// -1: desconhecido (força a próxima chamada)
+	GLint m_program = -1;
+	GLint m_vertexArray = -1;
+	GLint m_activeUnit = -1;
+	GLint m_textures[TEXTURE_UNITS];
+	GLint m_buffers[BUFFER_TARGET_COUNT];
+	GLint m_uniformBases[INDEXED_BINDINGS];
+	GLint m_storageBases[INDEXED_BINDINGS];
+	// (programa << 32 | location) -> bytes do último valor
+	std::unordered_map<uint64_t, std::vector<unsigned char>> m_uniforms;
+
+	Stats m_frame;
+	Stats m_lastFrame;
+};
@@ -0,0 +1,650 @@
+#include "GpuCuller.h"
+#include "Camera.h"
+#include "FrustumCuller.h"
+#include "GlState.h"
+#include "GpuPaths.h"
+#include "Scene.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <map>
+
+namespace
+{
+	const GLuint CULL_GROUP_SIZE = 64;
+	const GLuint PYRAMID_GROUP_SIZE = 8;
+	const GLuint PYRAMID_TEXTURE_UNIT = 1;
+
+	// Frustum e oclusão de um objeto por invocação. Na fase 0 viewProjection é
+	// a do quadro anterior (a da pirâmide); na fase 1, a atual
+	const GLchar* cullShaderSource = R"(
+#version 450
+layout (local_size_x = 64) in;
+
+struct ObjectData {
+    mat4 model;
+    vec4 boundsMin;
+    vec4 boundsMax;
+    uint slot;
+    uint materialIndex;
+    uint padding0;
+    uint padding1;
+};
+
+struct DrawCommand {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+struct InstanceData {
+    mat4 model;
+    uint materialIndex;
+    uint padding0;
+    uint padding1;
+    uint padding2;
+};
+
+layout (std430, binding = 6) readonly buffer ObjectBuffer { ObjectData objects[]; };
+layout (std430, binding = 8) buffer CommandBuffer { DrawCommand commands[]; };
+layout (std430, binding = 9) writeonly buffer InstanceBuffer { InstanceData instances[]; };
+layout (std430, binding = 10) buffer VisibilityBuffer { uint drawnEarly[]; };
+// 0: desenhados na fase 0, 1: desenhados na fase 1, 2: fora do frustum, 3: ocluídos
+layout (std430, binding = 12) buffer CounterBuffer { uint counters[4]; };
+
+uniform uint objectCount;
+uniform uint phase;
+uniform vec4 planes[6];
+uniform mat4 viewProjection;
+uniform bool useOcclusion;
+uniform sampler2D depthPyramid;
+uniform ivec2 pyramidSize;
+uniform int pyramidLevels;
+
+// Mesmo teste do OcclusionCuller: retângulo na tela e profundidade mais
+// próxima da AABB contra a maior profundidade dos texels que ela cobre
+bool isOccluded(vec3 lower, vec3 upper)
+{
+    vec2 screenMin = vec2(1e30);
+    vec2 screenMax = vec2(-1e30);
+    float nearest = 1.0;
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        vec3 point = vec3((corner & 1) != 0 ? upper.x : lower.x,
+                          (corner & 2) != 0 ? upper.y : lower.y,
+                          (corner & 4) != 0 ? upper.z : lower.z);
+        vec4 clip = viewProjection * vec4(point, 1.0);
+        // Cruza o near: nada pode estar na frente dele
+        if (clip.w <= 0.0 || clip.z < -clip.w)
+            return false;
+        vec3 ndc = clip.xyz / clip.w;
+        vec2 screen = (ndc.xy * 0.5 + 0.5) * vec2(pyramidSize);
+        screenMin = min(screenMin, screen);
+        screenMax = max(screenMax, screen);
+        nearest = min(nearest, ndc.z * 0.5 + 0.5);
+    }
+
+    ivec2 p0 = max(ivec2(floor(screenMin)), ivec2(0));
+    ivec2 p1 = min(ivec2(floor(screenMax)), pyramidSize - 1);
+    if (any(greaterThan(p0, p1)))
+        return false;
+
+    // Nível em que o retângulo cobre no máximo 2x2 texels; o último texel de
+    // cada linha e coluna também cobre a sobra dos tamanhos ímpares
+    int level = 0;
+    while (level < pyramidLevels - 1 && any(greaterThan((p1 >> level) - (p0 >> level), ivec2(1))))
+        ++level;
+    ivec2 levelSize = max(pyramidSize >> level, ivec2(1));
+    ivec2 t0 = min(p0 >> level, levelSize - 1);
+    ivec2 t1 = min(p1 >> level, levelSize - 1);
+    for (int y = t0.y; y <= t1.y; ++y)
+        for (int x = t0.x; x <= t1.x; ++x)
+            if (texelFetch(depthPyramid, ivec2(x, y), level).r >= nearest)
+                return false;
+    return true;
+}
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= objectCount)
+        return;
+    // A 2ª fase só reavalia quem ficou de fora na 1ª
+    if (phase == 1u && drawnEarly[i] != 0u)
+        return;
+
+    // AABB no mundo (Arvo)
+    ObjectData object = objects[i];
+    vec3 halfSize = 0.5 * (object.boundsMax.xyz - object.boundsMin.xyz);
+    vec3 center = (object.model * vec4(0.5 * (object.boundsMin.xyz + object.boundsMax.xyz), 1.0)).xyz;
+    vec3 extent = abs(object.model[0].xyz) * halfSize.x + abs(object.model[1].xyz) * halfSize.y + abs(object.model[2].xyz) * halfSize.z;
+
+    for (int k = 0; k < 6; ++k)
+    {
+        if (dot(planes[k].xyz, center) + planes[k].w + dot(abs(planes[k].xyz), extent) < 0.0)
+        {
+            if (phase == 0u)
+            {
+                drawnEarly[i] = 0u;
+                atomicAdd(counters[2], 1u);
+            }
+            return;
+        }
+    }
+
+    bool occluded = useOcclusion && isOccluded(center - extent, center + extent);
+    if (phase == 0u)
+        drawnEarly[i] = occluded ? 0u : 1u;
+    if (occluded)
+    {
+        if (phase == 1u)
+            atomicAdd(counters[3], 1u);
+        return;
+    }
+
+    atomicAdd(counters[phase], 1u);
+    uint local = atomicAdd(commands[object.slot].instanceCount, 1u);
+    instances[commands[object.slot].baseInstance + local] = InstanceData(object.model, object.materialIndex, 0u, 0u, 0u);
+}
+)";
+
+	// Copia os comandos com instâncias para o início do trecho do seu balde
+	const GLchar* compactShaderSource = R"(
+#version 450
+layout (local_size_x = 64) in;
+
+struct SlotData {
+    uint bucket;
+    uint firstDraw;
+    uint padding0;
+    uint padding1;
+};
+
+struct DrawCommand {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout (std430, binding = 7) readonly buffer SlotBuffer { SlotData slots[]; };
+layout (std430, binding = 8) readonly buffer CommandBuffer { DrawCommand commands[]; };
+layout (std430, binding = 11) writeonly buffer DrawBuffer { DrawCommand draws[]; };
+layout (std430, binding = 13) buffer DrawCountBuffer { uint drawCounts[]; };
+
+uniform uint slotCount;
+
+void main()
+{
+    uint s = gl_GlobalInvocationID.x;
+    if (s >= slotCount || commands[s].instanceCount == 0u)
+        return;
+    uint index = atomicAdd(drawCounts[slots[s].bucket], 1u);
+    draws[slots[s].firstDraw + index] = commands[s];
+}
+)";
+
+	// Um nível da pirâmide: o 0 copia o buffer de profundidade, os outros
+	// guardam o máximo do nível de baixo (incluindo a sobra dos tamanhos ímpares)
+	const GLchar* pyramidShaderSource = R"(
+#version 450
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (r32f, binding = 0) uniform readonly image2D source;
+layout (r32f, binding = 1) uniform writeonly image2D destination;
+uniform sampler2D depthTexture;
+uniform bool fromDepth;
+uniform ivec2 sourceSize;
+uniform ivec2 destinationSize;
+
+void main()
+{
+    ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(p, destinationSize)))
+        return;
+    if (fromDepth)
+    {
+        imageStore(destination, p, vec4(texelFetch(depthTexture, p, 0).r));
+        return;
+    }
+
+    ivec2 first = 2 * p;
+    ivec2 last = min(2 * p + 1, sourceSize - 1);
+    // O último texel de um nível ímpar absorve a linha/coluna que sobra
+    if (p.x == destinationSize.x - 1) last.x = sourceSize.x - 1;
+    if (p.y == destinationSize.y - 1) last.y = sourceSize.y - 1;
+    float depth = 0.0;
+    for (int y = first.y; y <= last.y; ++y)
+        for (int x = first.x; x <= last.x; ++x)
+            depth = max(depth, imageLoad(source, ivec2(x, y)).r);
+    imageStore(destination, p, vec4(depth));
+}
+)";
+
+	GLuint groupsFor(size_t count, GLuint groupSize)
+	{
+		return static_cast<GLuint>((count + groupSize - 1) / groupSize);
+	}
+}
+
+GLuint GpuCuller::compileCompute(const GLchar* source, const char* name)
+{
+	GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+	glShaderSource(shader, 1, &source, NULL);
+	glCompileShader(shader);
+	GLint success;
+	GLchar infoLog[512];
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+	if (!success)
+	{
+		glGetShaderInfoLog(shader, 512, NULL, infoLog);
+		std::cout << "ERROR::SHADER::COMPUTE::COMPILATION_FAILED (" << name << ")\n" << infoLog << std::endl;
+	}
+	GLuint program = glCreateProgram();
+	glAttachShader(program, shader);
+	glLinkProgram(program);
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		glGetProgramInfoLog(program, 512, NULL, infoLog);
+		std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED (" << name << ")\n" << infoLog << std::endl;
+	}
+	glDeleteShader(shader);
+	return program;
+}
+
+void GpuCuller::init(GeometryPool& geometry, IndirectRenderer& renderer, int width, int height)
+{
+	m_geometry = &geometry;
+	m_renderer = &renderer;
+	m_width = width;
+	m_height = height;
+
+	m_cullProgram = compileCompute(cullShaderSource, "cull");
+	m_compactProgram = compileCompute(compactShaderSource, "compact");
+	m_pyramidProgram = compileCompute(pyramidShaderSource, "pyramid");
+	GLuint drawProgram = GlState::get().getProgram();
+	GlState::get().useProgram(m_cullProgram);
+	GlState::get().uniform1i(glGetUniformLocation(m_cullProgram, "depthPyramid"), PYRAMID_TEXTURE_UNIT);
+	GlState::get().useProgram(m_pyramidProgram);
+	GlState::get().uniform1i(glGetUniformLocation(m_pyramidProgram, "depthTexture"), PYRAMID_TEXTURE_UNIT);
+	GlState::get().useProgram(drawProgram);
+
+	m_cullLocations.objectCount = glGetUniformLocation(m_cullProgram, "objectCount");
+	m_cullLocations.phase = glGetUniformLocation(m_cullProgram, "phase");
+	m_cullLocations.planes = glGetUniformLocation(m_cullProgram, "planes");
+	m_cullLocations.viewProjection = glGetUniformLocation(m_cullProgram, "viewProjection");
+	m_cullLocations.useOcclusion = glGetUniformLocation(m_cullProgram, "useOcclusion");
+	m_cullLocations.pyramidSize = glGetUniformLocation(m_cullProgram, "pyramidSize");
+	m_cullLocations.pyramidLevels = glGetUniformLocation(m_cullProgram, "pyramidLevels");
+	m_slotCountLocation = glGetUniformLocation(m_compactProgram, "slotCount");
+	m_pyramidLocations.fromDepth = glGetUniformLocation(m_pyramidProgram, "fromDepth");
+	m_pyramidLocations.sourceSize = glGetUniformLocation(m_pyramidProgram, "sourceSize");
+	m_pyramidLocations.destinationSize = glGetUniformLocation(m_pyramidProgram, "destinationSize");
+
+	GLuint* buffers[] = { &m_objectSSBO, &m_slotSSBO, &m_templateBuffer, &m_commandSSBO,
+		&m_visibilitySSBO, &m_drawSSBO, &m_counterSSBO, &m_drawCountSSBO };
+	for (GLuint* buffer : buffers)
+	{
+		glGenBuffers(1, buffer);
+	}
+	GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, m_counterSSBO);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, 4 * sizeof(GLuint), nullptr, GL_DYNAMIC_READ);
+	GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	// Profundidade do quadro copiada do framebuffer e pirâmide de máximos com todos os níveis
+	m_pyramidLevels = 1 + static_cast<int>(std::floor(std::log2(std::max(width, height))));
+	glGenTextures(1, &m_depthTexture);
+	GlState::get().bindTexture(GL_TEXTURE_2D, m_depthTexture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT24, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glGenTextures(1, &m_pyramidTexture);
+	GlState::get().bindTexture(GL_TEXTURE_2D, m_pyramidTexture);
+	glTexStorage2D(GL_TEXTURE_2D, m_pyramidLevels, GL_R32F, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	GlState::get().bindTexture(GL_TEXTURE_2D, 0);
+
+	glGenQueries(1, &m_timeQuery);
+
+	GLint bindings = 0;
+	glGetIntegerv(GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS, &bindings);
+	if (bindings <= static_cast<GLint>(CULL_DRAW_COUNT_SSBO_BINDING))
+	{
+		std::cerr << "Only " << bindings << " shader storage bindings, GPU culling will not work" << std::endl;
+	}
+	if (!GLAD_GL_ARB_indirect_parameters)
+	{
+		std::cerr << "GL_ARB_indirect_parameters not supported, GPU culling draws every slot" << std::endl;
+	}
+}
+
+void GpuCuller::destroy()
+{
+	GlState::get().deleteProgram(m_cullProgram);
+	GlState::get().deleteProgram(m_compactProgram);
+	GlState::get().deleteProgram(m_pyramidProgram);
+	GLuint buffers[] = { m_objectSSBO, m_slotSSBO, m_templateBuffer, m_commandSSBO,
+		m_visibilitySSBO, m_drawSSBO, m_counterSSBO, m_drawCountSSBO };
+	GlState::get().deleteBuffers(8, buffers);
+	GlState::get().deleteTextures(1, &m_depthTexture);
+	GlState::get().deleteTextures(1, &m_pyramidTexture);
+	glDeleteQueries(1, &m_timeQuery);
+	m_cullProgram = m_compactProgram = m_pyramidProgram = 0;
+	m_objectSSBO = m_slotSSBO = m_templateBuffer = m_commandSSBO = 0;
+	m_visibilitySSBO = m_drawSSBO = m_counterSSBO = m_drawCountSSBO = 0;
+	m_depthTexture = m_pyramidTexture = m_timeQuery = 0;
+	m_objectMeshes.clear();
+	m_objectCapacity = 0;
+	m_hasPyramid = false;
+	m_queryPending = false;
+}
+
+void GpuCuller::buildSlots(const Scene& scene)
+{
+	// Slots ordenados por textura e malha, para cada textura ser um trecho contíguo
+	std::map<std::pair<GLuint, const GpuMesh*>, GLuint> counts;
+	for (const Renderable& renderable : scene.getRenderables())
+	{
+		if (renderable.mesh)
+		{
+			counts[{ renderable.getTextureID(), renderable.mesh.get() }]++;
+		}
+	}
+
+	size_t objectCount = scene.size();
+	std::map<const GpuMesh*, GLuint> slotOf;
+	std::vector<SlotData> slots;
+	std::vector<DrawElementsIndirectCommand> templates(2 * counts.size());
+	m_buckets.clear();
+	GLuint instanceOffset = 0;
+	for (const auto& [key, count] : counts)
+	{
+		GLuint slot = static_cast<GLuint>(slots.size());
+		if (m_buckets.empty() || m_buckets.back().textureID != key.first)
+		{
+			m_buckets.push_back({ key.first, slot, 0 });
+		}
+		m_buckets.back().slotCount++;
+		slots.push_back({ static_cast<GLuint>(m_buckets.size() - 1), m_buckets.back().firstSlot, { 0, 0 } });
+		slotOf[key.second] = slot;
+
+		// A fase 1 escreve na segunda metade do buffer de instâncias
+		const MeshRange& range = key.second->range;
+		for (GLuint phase = 0; phase < 2; ++phase)
+		{
+			templates[phase * counts.size() + slot] = { range.indexCount, 0, range.firstIndex, range.baseVertex,
+				instanceOffset + phase * static_cast<GLuint>(objectCount) };
+		}
+		instanceOffset += count;
+	}
+	m_slotCount = slots.size();
+
+	m_objectData.assign(objectCount, ObjectData());
+	m_objectMeshes.resize(objectCount);
+	for (size_t i = 0; i < objectCount; ++i)
+	{
+		const GpuMesh* mesh = scene.getMesh(static_cast<Entity>(i));
+		m_objectMeshes[i] = mesh;
+		if (mesh)
+		{
+			m_objectData[i].boundsMin = glm::vec4(mesh->boundsMin, 1.0f);
+			m_objectData[i].boundsMax = glm::vec4(mesh->boundsMax, 1.0f);
+			m_objectData[i].slot = slotOf[mesh];
+		}
+		else
+		{
+			// Sem malha: caixa invertida, nunca passa no frustum
+			m_objectData[i].boundsMin = glm::vec4(1.0f);
+			m_objectData[i].boundsMax = glm::vec4(-1.0f);
+		}
+	}
+
+	size_t slotBytes = std::max<size_t>(m_slotCount, 1);
+	GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, m_slotSSBO);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, slotBytes * sizeof(SlotData), slots.data(), GL_STATIC_DRAW);
+	GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, m_templateBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, 2 * slotBytes * sizeof(DrawElementsIndirectCommand), templates.data(), GL_STATIC_DRAW);
+	GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, m_commandSSBO);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, slotBytes * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_DRAW);
+	GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, m_drawSSBO);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, slotBytes * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_DRAW);
+	GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, m_drawCountSSBO);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, std::max<size_t>(m_buckets.size(), 1) * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+	GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void GpuCuller::uploadObjects(const Scene& scene)
+{
+	const std::vector<glm::mat4>& models = scene.getModels();
+	const std::vector<Renderable>& renderables = scene.getRenderables();
+	bool rebuild = renderables.size() != m_objectMeshes.size();
+	for (size_t i = 0; i < renderables.size() && !rebuild; ++i)
+	{
+		rebuild = renderables[i].mesh.get() != m_objectMeshes[i];
+	}
+	if (rebuild)
+	{
+		buildSlots(scene);
+	}
+
+	size_t count = std::max<size_t>(scene.size(), 1);
+	if (count > m_objectCapacity)
+	{
+		m_objectCapacity = std::max(count, m_objectCapacity * 2);
+		GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, m_objectSSBO);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, m_objectCapacity * sizeof(ObjectData), nullptr, GL_DYNAMIC_DRAW);
+		GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, m_visibilitySSBO);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, m_objectCapacity * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+		rebuild = true;
+	}
+
+	// Só o trecho entre o primeiro e o último objeto que mudou vai para a GPU;
+	// os parados (e os animados na GPU) não custam upload
+	size_t first = models.size(), last = 0;
+	for (size_t i = 0; i < models.size(); ++i)
+	{
+		if (rebuild || m_objectData[i].model != models[i] || m_objectData[i].materialIndex != renderables[i].materialIndex)
+		{
+			m_objectData[i].model = models[i];
+			m_objectData[i].materialIndex = renderables[i].materialIndex;
+			first = std::min(first, i);
+			last = i + 1;
+		}
+	}
+	m_stats.uploadedObjects = 0;
+	if (first < last)
+	{
+		m_stats.uploadedObjects = static_cast<unsigned>(last - first);
+		GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, m_objectSSBO);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, first * sizeof(ObjectData), (last - first) * sizeof(ObjectData), &m_objectData[first]);
+		GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+}
+
+void GpuCuller::render(const Scene& scene, const Camera& camera, GpuPaths* paths)
+{
+	auto start = std::chrono::steady_clock::now();
+	m_stats.drawCalls = 0;
+	uploadObjects(scene);
+	if (paths)
+	{
+		paths->animate(m_objectSSBO);
+	}
+	if (m_slotCount == 0)
+	{
+		return;
+	}
+
+	glm::mat4 viewProjection = camera.getProjectionMatrix() * camera.getViewMatrix();
+	glm::vec4 planes[6];
+	FrustumCuller::extractPlanes(viewProjection, planes);
+
+	GLuint instanceBuffer = m_renderer->reserveInstances(2 * scene.size());
+	GlState::get().bindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_OBJECT_SSBO_BINDING, m_objectSSBO);
+	GlState::get().bindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_SLOT_SSBO_BINDING, m_slotSSBO);
+	GlState::get().bindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_COMMAND_SSBO_BINDING, m_commandSSBO);
+	GlState::get().bindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_INSTANCE_SSBO_BINDING, instanceBuffer);
+	GlState::get().bindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_VISIBILITY_SSBO_BINDING, m_visibilitySSBO);
+	GlState::get().bindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_DRAW_SSBO_BINDING, m_drawSSBO);
+	GlState::get().bindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_COUNTER_SSBO_BINDING, m_counterSSBO);
+	GlState::get().bindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_DRAW_COUNT_SSBO_BINDING, m_drawCountSSBO);
+
+	GLuint zero = 0;
+	GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, m_counterSSBO);
+	glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+
+	// Só começa uma medição nova depois que a anterior foi lida; se o
+	// resultado ainda não chegou, este quadro fica sem medição em vez de
+	// esperar pela GPU
+	if (m_queryPending)
+	{
+		GLint available = 0;
+		glGetQueryObjectiv(m_timeQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available)
+		{
+			readQuery();
+		}
+	}
+	bool timing = !m_queryPending;
+	if (timing)
+	{
+		glBeginQuery(GL_TIME_ELAPSED, m_timeQuery);
+	}
+	GLuint drawProgram = GlState::get().getProgram();
+
+	// Fase 0: pirâmide e câmera do quadro anterior
+	cullPhase(0, m_previousViewProjection, planes);
+	GlState::get().useProgram(drawProgram);
+	draw();
+
+	// Fase 1: pirâmide desta profundidade parcial, só para os rejeitados acima
+	buildPyramid();
+	cullPhase(1, viewProjection, planes);
+	GlState::get().useProgram(drawProgram);
+	draw();
+	if (timing)
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+		m_queryPending = true;
+	}
+
+	m_hasPyramid = true;
+	m_previousViewProjection = viewProjection;
+	m_stats.objects = static_cast<unsigned>(scene.size());
+	m_stats.slots = static_cast<unsigned>(m_slotCount);
+	m_stats.submitMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void GpuCuller::cullPhase(GLuint phase, const glm::mat4& viewProjection, const glm::vec4 planes[6])
+{
+	// Comandos zerados da fase e contadores de desenho por balde
+	GlState::get().bindBuffer(GL_COPY_READ_BUFFER, m_templateBuffer);
+	GlState::get().bindBuffer(GL_COPY_WRITE_BUFFER, m_commandSSBO);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, phase * m_slotCount * sizeof(DrawElementsIndirectCommand), 0,
+		m_slotCount * sizeof(DrawElementsIndirectCommand));
+	GLuint zero = 0;
+	GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, m_drawCountSSBO);
+	glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+
+	GLuint objectCount = static_cast<GLuint>(m_objectData.size());
+	GlState::get().useProgram(m_cullProgram);
+	GlState::get().uniform1ui(m_cullLocations.objectCount, objectCount);
+	GlState::get().uniform1ui(m_cullLocations.phase, phase);
+	GlState::get().uniform4fv(m_cullLocations.planes, 6, &planes[0][0]);
+	GlState::get().uniformMatrix4fv(m_cullLocations.viewProjection, 1, &viewProjection[0][0]);
+	GlState::get().uniform1i(m_cullLocations.useOcclusion, phase == 1 || m_hasPyramid);
+	GlState::get().uniform2i(m_cullLocations.pyramidSize, m_width, m_height);
+	GlState::get().uniform1i(m_cullLocations.pyramidLevels, m_pyramidLevels);
+	GlState::get().activeTexture(GL_TEXTURE0 + PYRAMID_TEXTURE_UNIT);
+	GlState::get().bindTexture(GL_TEXTURE_2D, m_pyramidTexture);
+	GlState::get().activeTexture(GL_TEXTURE0);
+	glDispatchCompute(groupsFor(objectCount, CULL_GROUP_SIZE), 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	GlState::get().useProgram(m_compactProgram);
+	GlState::get().uniform1ui(m_slotCountLocation, static_cast<GLuint>(m_slotCount));
+	glDispatchCompute(groupsFor(m_slotCount, CULL_GROUP_SIZE), 1, 1);
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void GpuCuller::buildPyramid()
+{
+	// O framebuffer padrão não pode ser amostrado: a profundidade é copiada antes
+	GlState::get().bindTexture(GL_TEXTURE_2D, m_depthTexture);
+	glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, m_width, m_height);
+
+	GlState::get().useProgram(m_pyramidProgram);
+	GlState::get().activeTexture(GL_TEXTURE0 + PYRAMID_TEXTURE_UNIT);
+	GlState::get().bindTexture(GL_TEXTURE_2D, m_depthTexture);
+	GlState::get().activeTexture(GL_TEXTURE0);
+	for (int level = 0; level < m_pyramidLevels; ++level)
+	{
+		int width = std::max(1, m_width >> level), height = std::max(1, m_height >> level);
+		GlState::get().uniform1i(m_pyramidLocations.fromDepth, level == 0);
+		GlState::get().uniform2i(m_pyramidLocations.sourceSize, std::max(1, m_width >> std::max(level - 1, 0)), std::max(1, m_height >> std::max(level - 1, 0)));
+		GlState::get().uniform2i(m_pyramidLocations.destinationSize, width, height);
+		glBindImageTexture(0, m_pyramidTexture, std::max(level - 1, 0), GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+		glBindImageTexture(1, m_pyramidTexture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+		glDispatchCompute(groupsFor(width, PYRAMID_GROUP_SIZE), groupsFor(height, PYRAMID_GROUP_SIZE), 1);
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+	}
+}
+
+void GpuCuller::draw()
+{
+	GlState::get().bindVertexArray(m_geometry->getVAO());
+	GlState::get().bindBuffer(GL_DRAW_INDIRECT_BUFFER, GLAD_GL_ARB_indirect_parameters ? m_drawSSBO : m_commandSSBO);
+	if (GLAD_GL_ARB_indirect_parameters)
+	{
+		GlState::get().bindBuffer(GL_PARAMETER_BUFFER_ARB, m_drawCountSSBO);
+	}
+	for (size_t b = 0; b < m_buckets.size(); ++b)
+	{
+		const Bucket& bucket = m_buckets[b];
+		GlState::get().bindTexture(GL_TEXTURE_2D, bucket.textureID);
+		const void* offset = (void*)(bucket.firstSlot * sizeof(DrawElementsIndirectCommand));
+		if (GLAD_GL_ARB_indirect_parameters)
+		{
+			glMultiDrawElementsIndirectCountARB(GL_TRIANGLES, GL_UNSIGNED_INT, offset,
+				static_cast<GLintptr>(b * sizeof(GLuint)), static_cast<GLsizei>(bucket.slotCount), 0);
+		}
+		else
+		{
+			// Sem a contagem na GPU os comandos vazios (instanceCount 0) também vão
+			glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, offset, static_cast<GLsizei>(bucket.slotCount), 0);
+		}
+		m_stats.drawCalls++;
+	}
+}
+
+const GpuCuller::Stats& GpuCuller::readStats()
+{
+	GLuint counters[4] = { 0, 0, 0, 0 };
+	GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, m_counterSSBO);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(counters), counters);
+	GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	m_stats.earlyDrawn = counters[0];
+	m_stats.lateDrawn = counters[1];
+	m_stats.frustumCulled = counters[2];
+	m_stats.occluded = counters[3];
+
+	if (m_queryPending)
+	{
+		readQuery();
+	}
+	return m_stats;
+}
+
+void GpuCuller::readQuery()
+{
+	GLuint64 nanoseconds = 0;
+	glGetQueryObjectui64v(m_timeQuery, GL_QUERY_RESULT, &nanoseconds);
+	m_stats.gpuMilliseconds = nanoseconds / 1.0e6;
+	m_queryPending = false;
+}
@@ -0,0 +1,150 @@
+#pragma once
+#include "IndirectRenderer.h"
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+class Camera;
+class GpuPaths;
+class Scene;
+
+// Pontos de ligação dos buffers usados pelos compute shaders do GpuCuller
+// (os de 0 a 5 são do shader de desenho)
+const GLuint CULL_OBJECT_SSBO_BINDING = 6;
+const GLuint CULL_SLOT_SSBO_BINDING = 7;
+const GLuint CULL_COMMAND_SSBO_BINDING = 8;
+const GLuint CULL_INSTANCE_SSBO_BINDING = 9;
+const GLuint CULL_VISIBILITY_SSBO_BINDING = 10;
+const GLuint CULL_DRAW_SSBO_BINDING = 11;
+const GLuint CULL_COUNTER_SSBO_BINDING = 12;
+const GLuint CULL_DRAW_COUNT_SSBO_BINDING = 13;
+
+// Culling dirigido pela GPU. Transformações e limites de todos os objetos
+// ficam num SSBO; um compute shader faz o teste de frustum e de oclusão
+// contra uma pirâmide de profundidade máxima e escreve as instâncias
+// sobreviventes direto no buffer por instância do IndirectRenderer. Cada par
+// (textura, malha) tem um comando fixo ("slot"); um segundo compute compacta
+// os comandos não vazios de cada textura e o quadro é desenhado com um
+// glMultiDrawElementsIndirectCountARB por textura, sem a CPU ver a lista.
+//
+// A oclusão é em duas fases: a 1ª testa contra a pirâmide do quadro anterior
+// (com a viewProjection dele) e desenha quem passou; a pirâmide é refeita
+// com essa profundidade e a 2ª fase testa de novo só os rejeitados na 1ª,
+// desenhando os que a pirâmide antiga escondeu por engano.
+class GpuCuller
+{
+public:
+	struct Stats
+	{
+		unsigned objects = 0;
+		unsigned slots = 0;
+		unsigned drawCalls = 0;
+		unsigned earlyDrawn = 0;      // desenhados na 1ª fase
+		unsigned lateDrawn = 0;       // desenhados na 2ª fase
+		unsigned frustumCulled = 0;
+		unsigned occluded = 0;
+		unsigned uploadedObjects = 0;   // ObjectData reenviados no quadro
+		double submitMilliseconds = 0.0;
+		double gpuMilliseconds = 0.0;
+	};
+
+	// std430: espelho do ObjectData dos compute shaders (o GpuPaths escreve na model)
+	struct ObjectData
+	{
+		glm::mat4 model;
+		glm::vec4 boundsMin;
+		glm::vec4 boundsMax;
+		GLuint slot;
+		GLuint materialIndex;
+		GLuint padding[2];
+	};
+
+	// width e height são os do framebuffer (tamanho da pirâmide)
+	void init(GeometryPool& geometry, IndirectRenderer& renderer, int width, int height);
+	void destroy();
+
+	// Envia os objetos que mudaram, roda as duas fases e desenha. Com paths,
+	// as posições dos objetos com caminho são calculadas na GPU antes do
+	// culling. O programa de desenho precisa estar em uso, como no caminho da CPU
+	void render(const Scene& scene, const Camera& camera, GpuPaths* paths = nullptr);
+
+	static GLuint compileCompute(const GLchar* source, const char* name);
+
+	// Lê os contadores do último quadro de volta da GPU (bloqueia; só para a tecla P)
+	const Stats& readStats();
+private:
+	struct SlotData
+	{
+		GLuint bucket;
+		GLuint firstDraw;   // primeiro comando do balde no buffer compactado
+		GLuint padding[2];
+	};
+
+	struct Bucket
+	{
+		GLuint textureID;
+		GLuint firstSlot;
+		GLuint slotCount;
+	};
+
+	// Refaz slots, baldes e modelos de comando quando a lista de objetos muda
+	void buildSlots(const Scene& scene);
+	void uploadObjects(const Scene& scene);
+	void cullPhase(GLuint phase, const glm::mat4& viewProjection, const glm::vec4 planes[6]);
+	void buildPyramid();
+	void draw();
+	// Resultado da medição pendente em gpuMilliseconds (bloqueia se não chegou)
+	void readQuery();
+
+	GeometryPool* m_geometry = nullptr;
+	IndirectRenderer* m_renderer = nullptr;
+	GLuint m_cullProgram = 0;
+	GLuint m_compactProgram = 0;
+	GLuint m_pyramidProgram = 0;
+
+	// Locais dos uniforms, buscados uma vez no init
+	struct CullLocations
+	{
+		GLint objectCount = -1;
+		GLint phase = -1;
+		GLint planes = -1;
+		GLint viewProjection = -1;
+		GLint useOcclusion = -1;
+		GLint pyramidSize = -1;
+		GLint pyramidLevels = -1;
+	};
+	struct PyramidLocations
+	{
+		GLint fromDepth = -1;
+		GLint sourceSize = -1;
+		GLint destinationSize = -1;
+	};
+	CullLocations m_cullLocations;
+	GLint m_slotCountLocation = -1;
+	PyramidLocations m_pyramidLocations;
+
+	GLuint m_objectSSBO = 0;
+	GLuint m_slotSSBO = 0;
+	GLuint m_templateBuffer = 0;   // comandos zerados das duas fases, copiados a cada fase
+	GLuint m_commandSSBO = 0;
+	GLuint m_visibilitySSBO = 0;
+	GLuint m_drawSSBO = 0;
+	GLuint m_counterSSBO = 0;
+	GLuint m_drawCountSSBO = 0;
+	GLuint m_depthTexture = 0;
+	GLuint m_pyramidTexture = 0;
+	GLuint m_timeQuery = 0;
+	int m_width = 0;
+	int m_height = 0;
+	int m_pyramidLevels = 0;
+
+	std::vector<ObjectData> m_objectData;
+	std::vector<const GpuMesh*> m_objectMeshes;   // para saber quando refazer os slots
+	std::vector<Bucket> m_buckets;
+	size_t m_slotCount = 0;
+	size_t m_objectCapacity = 0;
+	bool m_hasPyramid = false;
+	glm::mat4 m_previousViewProjection = glm::mat4(1.0f);
+	bool m_queryPending = false;
+	Stats m_stats;
+};
@@ -0,0 +1,469 @@
+#include "GpuPaths.h"
+#include "GlState.h"
+#include "GpuCuller.h"
+#include "TransformSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace
+{
+	const GLuint PATH_GROUP_SIZE = 64;
+	const unsigned SAMPLES = PathSystem::LENGTH_SAMPLES;
+
+	// Um caminho por invocação: distância pelo tempo da simulação, segmento por
+	// busca binária nos inícios, t pela tabela de cordas e posição por Horner,
+	// no passo anterior e no atual. O init põe antes o #version e o
+	// LENGTH_SAMPLES do PathSystem
+	const GLchar* pathShaderSource = R"(
+layout (local_size_x = 64) in;
+
+struct ObjectData {
+    mat4 model;
+    vec4 boundsMin;
+    vec4 boundsMax;
+    uint slot;
+    uint materialIndex;
+    uint padding0;
+    uint padding1;
+};
+
+struct PathData {
+    uint entity;
+    uint firstSegment;
+    uint segmentCount;
+    uint startStep;
+    float length;
+    float step;
+    float stepsPerLap;
+    float startDistance;
+};
+
+struct SegmentData {
+    vec4 a;    // w = distância até o início do segmento
+    vec4 b;
+    vec4 c;
+    vec4 d;
+    float lengths[LENGTH_SAMPLES];
+};
+
+layout (std430, binding = 6) buffer ObjectBuffer { ObjectData objects[]; };
+layout (std430, binding = 14) readonly buffer PathBuffer { PathData paths[]; };
+layout (std430, binding = 15) readonly buffer SegmentBuffer { SegmentData segments[]; };
+
+uniform uint pathCount;
+// Passo inteiro da simulação e a fração desenhada entre o anterior e ele,
+// como no PathSystem::interpolate
+uniform uint simulationStep;
+uniform float alpha;
+
+// PathSystem::distanceAt: distância no passo simulationStep + offset
+float distanceAt(PathData path, float offset)
+{
+    // As voltas inteiras saem antes de multiplicar, para não perder precisão
+    float steps = mod(float(simulationStep - path.startStep), path.stepsPerLap) + offset;
+    if (steps < 0.0)
+        steps += path.stepsPerLap;
+    float s = path.startDistance + path.step * steps;
+    return s >= path.length ? s - path.length : s;
+}
+
+vec3 positionAt(PathData path, float s)
+{
+    uint lower = path.firstSegment;
+    uint upper = path.firstSegment + path.segmentCount - 1u;
+    while (lower < upper)
+    {
+        uint middle = (lower + upper + 1u) / 2u;
+        if (segments[middle].a.w <= s)
+            lower = middle;
+        else
+            upper = middle - 1u;
+    }
+    float local = s - segments[lower].a.w;
+
+    // PathSystem::sampleT
+    uint first = 0u;
+    uint last = LENGTH_SAMPLES - 1u;
+    while (first < last)
+    {
+        uint middle = (first + last) / 2u;
+        if (segments[lower].lengths[middle] < local)
+            first = middle + 1u;
+        else
+            last = middle;
+    }
+    float before = first > 0u ? segments[lower].lengths[first - 1u] : 0.0;
+    float span = segments[lower].lengths[first] - before;
+    float t = (float(first) + (span > 0.0 ? clamp((local - before) / span, 0.0, 1.0) : 0.0)) / float(LENGTH_SAMPLES);
+
+    vec3 a = segments[lower].a.xyz;
+    vec3 b = segments[lower].b.xyz;
+    vec3 c = segments[lower].c.xyz;
+    vec3 d = segments[lower].d.xyz;
+    return ((a * t + b) * t + c) * t + d;
+}
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= pathCount)
+        return;
+    PathData path = paths[i];
+
+    vec3 previous = positionAt(path, distanceAt(path, -1.0));
+    vec3 current = positionAt(path, distanceAt(path, 0.0));
+    objects[path.entity].model[3] = vec4(mix(previous, current, alpha), 1.0);
+}
+)";
+
+	double millisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+// Os 3 campos do GpuPaths e os 5 do Timing, sem padding, como no std430
+static_assert(sizeof(GpuPaths::PathData) == 8 * sizeof(GLuint), "PathData must match the std430 layout of the path shader");
+
+void GpuPaths::init()
+{
+	std::string source = "#version 450\n#define LENGTH_SAMPLES " + std::to_string(SAMPLES) + "u\n" + pathShaderSource;
+	m_program = GpuCuller::compileCompute(source.c_str(), "paths");
+	m_pathCountLocation = glGetUniformLocation(m_program, "pathCount");
+	m_simulationStepLocation = glGetUniformLocation(m_program, "simulationStep");
+	m_alphaLocation = glGetUniformLocation(m_program, "alpha");
+	glGenBuffers(1, &m_pathSSBO);
+	glGenBuffers(1, &m_segmentSSBO);
+	glGenQueries(1, &m_timeQuery);
+
+	GLint bindings = 0;
+	glGetIntegerv(GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS, &bindings);
+	if (bindings <= static_cast<GLint>(PATH_SEGMENT_SSBO_BINDING))
+	{
+		std::cerr << "Only " << bindings << " shader storage bindings, GPU paths will not work" << std::endl;
+	}
+}
+
+void GpuPaths::destroy()
+{
+	GlState::get().deleteProgram(m_program);
+	GLuint buffers[] = { m_pathSSBO, m_segmentSSBO };
+	GlState::get().deleteBuffers(2, buffers);
+	glDeleteQueries(1, &m_timeQuery);
+	m_program = m_pathSSBO = m_segmentSSBO = m_timeQuery = 0;
+	m_objectBuffer = 0;
+	m_uploaded.reset();
+	m_queryPending = false;
+	m_active = false;
+	m_builtVersion = 0;
+}
+
+void GpuPaths::begin(Scene& scene)
+{
+	compile(scene);
+	m_active = true;
+}
+
+void GpuPaths::end(Scene& scene)
+{
+	// O Transform ainda tem a posição de quando a GPU assumiu
+	saveProgress(scene);
+	for (size_t i = 0; i < m_tables->paths.size(); ++i)
+	{
+		scene.getTransform(m_tables->paths[i].entity).setPosition(evaluate(i, m_step, m_alpha));
+	}
+	m_active = false;
+	m_builtVersion = 0;
+}
+
+void GpuPaths::sync(Scene& scene)
+{
+	if (scene.getPathVersion() != m_builtVersion)
+	{
+		// Quem já andava continua de onde está
+		saveProgress(scene);
+		compile(scene);
+	}
+}
+
+void GpuPaths::setTables(std::shared_ptr<const Tables> tables)
+{
+	m_tables = tables ? std::move(tables) : std::make_shared<const Tables>();
+	m_stats.paths = static_cast<unsigned>(m_tables->paths.size());
+	m_stats.segments = static_cast<unsigned>(m_tables->segments.size());
+	m_stats.bytes = m_tables->paths.size() * sizeof(PathData) + m_tables->segments.size() * sizeof(SegmentData);
+}
+
+void GpuPaths::compile(const Scene& scene)
+{
+	const ComponentArray<WaypointPath>& components = scene.getPaths();
+	const std::vector<WaypointPath>& waypointPaths = components.getValues();
+	const std::vector<Entity>& entities = components.getEntities();
+	std::shared_ptr<Tables> tables = std::make_shared<Tables>();
+	for (size_t i = 0; i < waypointPaths.size(); ++i)
+	{
+		const WaypointPath& waypointPath = waypointPaths[i];
+		size_t count = waypointPath.waypoints.size();
+		if (count == 0)
+		{
+			// Sem waypoints fica parado, como no PathSystem
+			continue;
+		}
+
+		PathData path;
+		path.entity = entities[i];
+		path.firstSegment = static_cast<GLuint>(tables->segments.size());
+		path.segmentCount = static_cast<GLuint>(count);
+		float length = 0.0f;
+		for (size_t k = 0; k < count; ++k)
+		{
+			PathSystem::Segment segment = PathSystem::makeSegment(waypointPath.waypoints, k);
+			SegmentData data;
+			data.a = glm::vec4(segment.a, length);
+			data.b = glm::vec4(segment.b, 0.0f);
+			data.c = glm::vec4(segment.c, 0.0f);
+			data.d = glm::vec4(segment.d, 0.0f);
+			length += PathSystem::sampleLengths(segment, data.lengths);
+			tables->segments.push_back(data);
+		}
+
+		// Progresso (segmento, t) para distância, pela mesma tabela
+		const SegmentData& current = tables->segments[path.firstSegment + std::min<size_t>(waypointPath.currentWaypoint, count - 1)];
+		float startDistance = current.a.w + PathSystem::sampleDistance(current.lengths, waypointPath.t);
+		path.timing = PathSystem::makeTiming(length, waypointPath.speed * length / count, m_step, startDistance);
+		tables->paths.push_back(path);
+	}
+
+	m_builtVersion = scene.getPathVersion();
+	setTables(std::move(tables));
+}
+
+void GpuPaths::upload()
+{
+	GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, m_pathSSBO);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, std::max<size_t>(m_tables->paths.size(), 1) * sizeof(PathData), m_tables->paths.data(), GL_STATIC_DRAW);
+	GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, m_segmentSSBO);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, std::max<size_t>(m_tables->segments.size(), 1) * sizeof(SegmentData), m_tables->segments.data(), GL_STATIC_DRAW);
+	GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	m_uploaded = m_tables;
+	m_stats.uploads++;
+}
+
+void GpuPaths::saveProgress(Scene& scene) const
+{
+	ComponentArray<WaypointPath>& components = scene.getPaths();
+	for (size_t i = 0; i < m_tables->paths.size(); ++i)
+	{
+		if (WaypointPath* waypointPath = components.find(m_tables->paths[i].entity))
+		{
+			uint32_t segment = 0;
+			float t = 0.0f;
+			locate(i, PathSystem::distanceAt(m_tables->paths[i].timing, m_step, 0.0f), segment, t);
+			waypointPath->currentWaypoint = segment - m_tables->paths[i].firstSegment;
+			waypointPath->t = t;
+		}
+	}
+}
+
+void GpuPaths::locate(size_t path, float distance, uint32_t& segment, float& t) const
+{
+	// Mesma busca do shader
+	const PathData& data = m_tables->paths[path];
+	uint32_t lower = data.firstSegment, upper = data.firstSegment + data.segmentCount - 1;
+	while (lower < upper)
+	{
+		uint32_t middle = (lower + upper + 1) / 2;
+		if (m_tables->segments[middle].a.w <= distance)
+		{
+			lower = middle;
+		}
+		else
+		{
+			upper = middle - 1;
+		}
+	}
+	segment = lower;
+	t = PathSystem::sampleT(m_tables->segments[lower].lengths, distance - m_tables->segments[lower].a.w);
+}
+
+glm::vec3 GpuPaths::positionAt(size_t path, uint32_t step, float offset) const
+{
+	uint32_t segment = 0;
+	float t = 0.0f;
+	locate(path, PathSystem::distanceAt(m_tables->paths[path].timing, step, offset), segment, t);
+	const SegmentData& data = m_tables->segments[segment];
+	return ((glm::vec3(data.a) * t + glm::vec3(data.b)) * t + glm::vec3(data.c)) * t + glm::vec3(data.d);
+}
+
+glm::vec3 GpuPaths::evaluate(size_t path, uint32_t step, float alpha) const
+{
+	return glm::mix(positionAt(path, step, -1.0f), positionAt(path, step, 0.0f), alpha);
+}
+
+void GpuPaths::setTime(uint64_t step, float alpha)
+{
+	m_step = static_cast<uint32_t>(step);
+	m_alpha = alpha;
+}
+
+void GpuPaths::animate(GLuint objectBuffer)
+{
+	m_objectBuffer = objectBuffer;
+	if (m_tables->paths.empty())
+	{
+		return;
+	}
+	if (m_uploaded != m_tables)
+	{
+		upload();
+	}
+
+	GLuint drawProgram = GlState::get().getProgram();
+	GlState::get().bindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_OBJECT_SSBO_BINDING, objectBuffer);
+	GlState::get().bindBufferBase(GL_SHADER_STORAGE_BUFFER, PATH_SSBO_BINDING, m_pathSSBO);
+	GlState::get().bindBufferBase(GL_SHADER_STORAGE_BUFFER, PATH_SEGMENT_SSBO_BINDING, m_segmentSSBO);
+	GlState::get().useProgram(m_program);
+	GlState::get().uniform1ui(m_pathCountLocation, static_cast<GLuint>(m_tables->paths.size()));
+	GlState::get().uniform1ui(m_simulationStepLocation, m_step);
+	GlState::get().uniform1f(m_alphaLocation, m_alpha);
+	glBeginQuery(GL_TIME_ELAPSED, m_timeQuery);
+	glDispatchCompute(static_cast<GLuint>((m_tables->paths.size() + PATH_GROUP_SIZE - 1) / PATH_GROUP_SIZE), 1, 1);
+	glEndQuery(GL_TIME_ELAPSED);
+	m_queryPending = true;
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	GlState::get().useProgram(drawProgram);
+}
+
+const GpuPaths::Stats& GpuPaths::readStats()
+{
+	m_stats.maxError = 0.0f;
+	if (m_tables->paths.empty() || m_objectBuffer == 0)
+	{
+		return m_stats;
+	}
+
+	GLuint objectCount = 0;
+	for (const PathData& path : m_tables->paths)
+	{
+		objectCount = std::max(objectCount, path.entity + 1);
+	}
+	std::vector<GpuCuller::ObjectData> objects(objectCount);
+	GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, m_objectBuffer);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, objects.size() * sizeof(GpuCuller::ObjectData), objects.data());
+	GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	// evaluate é a conta do PathSystem::update + interpolate sobre as mesmas tabelas
+	for (size_t i = 0; i < m_tables->paths.size(); ++i)
+	{
+		glm::vec3 gpu(objects[m_tables->paths[i].entity].model[3]);
+		m_stats.maxError = std::max(m_stats.maxError, glm::length(gpu - evaluate(i, m_step, m_alpha)));
+	}
+	if (m_stats.maxError > TOLERANCE)
+	{
+		std::cerr << "GPU path positions differ from the CPU path by " << m_stats.maxError << " (tolerance " << TOLERANCE << ")" << std::endl;
+	}
+
+	if (m_queryPending)
+	{
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(m_timeQuery, GL_QUERY_RESULT, &nanoseconds);
+		m_stats.gpuMilliseconds = nanoseconds / 1.0e6;
+	}
+	return m_stats;
+}
+
+void GpuPaths::benchmark(size_t count)
+{
+	const size_t FRAMES = 10;
+	const size_t WAYPOINTS = 4;
+	const size_t TRACKED = std::min<size_t>(count, 1000);
+	const uint32_t TRACK_FRAMES = 400;
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f), offset(-10.0f, 10.0f);
+	Scene scene;
+	for (size_t i = 0; i < count; ++i)
+	{
+		Entity entity = scene.createEntity();
+		glm::vec3 origin(position(random), position(random), position(random));
+		for (size_t w = 0; w < WAYPOINTS; ++w)
+		{
+			scene.addWaypoint(entity, origin + glm::vec3(offset(random), offset(random), offset(random)) * float(w + 1));
+		}
+	}
+
+	// Na CPU: caminhos, matrizes e o reenvio dos ObjectData que mudaram
+	PathSystem pathSystem;
+	TransformSystem transformSystem;
+	pathSystem.update(scene);
+	transformSystem.update(scene.getTransforms(), scene.getModels());
+	auto start = std::chrono::steady_clock::now();
+	for (size_t frame = 0; frame < FRAMES; ++frame)
+	{
+		pathSystem.update(scene);
+		pathSystem.interpolate(scene, 1.0f);
+		transformSystem.update(scene.getTransforms(), scene.getModels());
+	}
+	double cpuMilliseconds = millisecondsSince(start) / FRAMES;
+	double cpuMegabytes = transformSystem.getStats().dirty * sizeof(GpuCuller::ObjectData) / 1.0e6;
+
+	// Na GPU a CPU só monta as tabelas uma vez; por quadro são os uniforms do tempo
+	GpuPaths paths;
+	start = std::chrono::steady_clock::now();
+	paths.compile(scene);
+	double compileMilliseconds = millisecondsSince(start);
+
+	paths.init();
+	GLuint objectBuffer = 0;
+	glGenBuffers(1, &objectBuffer);
+	GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, objectBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, count * sizeof(GpuCuller::ObjectData), nullptr, GL_DYNAMIC_DRAW);
+	GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	// Mesmo ponto de partida nos dois lados (o progresso nos WaypointPath
+	// ainda é 0): o PathSystem anda passo a passo e desenha com alpha, e a
+	// GPU calcula o mesmo instante só pelo tempo. O primeiro passo fica de
+	// fora porque o PathSystem começa da posição desenhada
+	PathSystem reference;
+	std::vector<float> errors;
+	std::vector<GpuCuller::ObjectData> objects(TRACKED);
+	for (uint32_t frame = 1; frame <= TRACK_FRAMES; ++frame)
+	{
+		float alpha = float(frame % 4 + 1) / 4.0f;
+		reference.update(scene);
+		reference.interpolate(scene, alpha);
+		paths.setTime(frame, alpha);
+		paths.animate(objectBuffer);
+		if (frame == 1)
+		{
+			continue;
+		}
+		GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, objectBuffer);
+		glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, objects.size() * sizeof(GpuCuller::ObjectData), objects.data());
+		GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		for (size_t i = 0; i < TRACKED; ++i)
+		{
+			Entity entity = paths.m_tables->paths[i].entity;
+			errors.push_back(glm::length(glm::vec3(objects[entity].model[3]) - scene.getTransform(entity).position));
+		}
+	}
+	std::sort(errors.begin(), errors.end());
+	float meanError = 0.0f;
+	for (float error : errors)
+	{
+		meanError += error / errors.size();
+	}
+	double gpuMilliseconds = paths.readStats().gpuMilliseconds;
+	GlState::get().deleteBuffers(1, &objectBuffer);
+	paths.destroy();
+
+	std::cout << "Paths: " << count << ", CPU per frame: " << cpuMilliseconds << " ms + " << cpuMegabytes << " MB upload"
+		<< ", GPU per frame: " << gpuMilliseconds << " ms on the GPU, 0 ms + 0 MB on the CPU (once: compile "
+		<< compileMilliseconds << " ms, " << paths.m_stats.bytes / 1.0e6 << " MB)" << std::endl;
+	std::cout << "Distance GPU read-back x PathSystem over " << TRACK_FRAMES << " frames: mean " << meanError
+		<< ", 99th percentile " << errors[errors.size() * 99 / 100] << ", max " << errors.back()
+		<< " (tolerance " << TOLERANCE << ")" << std::endl;
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include "PathSystem.h"
+#include "Scene.h"
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Pontos de ligação dos buffers do compute shader dos caminhos (o 6 é o
+// SSBO de objetos do GpuCuller, onde as posições são escritas)
+const GLuint PATH_SSBO_BINDING = 14;
+const GLuint PATH_SEGMENT_SSBO_BINDING = 15;
+
+// Caminhos por waypoints avaliados na GPU. Os caminhos são enviados uma vez
+// (coeficientes da Catmull-Rom de cada segmento e a tabela de comprimento
+// acumulado do PathSystem); a cada quadro um compute shader calcula, só a
+// partir do tempo da simulação (passo e fração, já interpolado), a distância
+// percorrida por cada caminho, acha o segmento e o t pela tabela e escreve a
+// posição na matriz model do objeto no SSBO do GpuCuller, antes do culling.
+// A CPU não toca nos animados e não escreve nada por quadro além dos
+// uniforms do tempo.
+//
+// O avanço é a mesma forma fechada do PathSystem (PathSystem::Timing,
+// distanceAt e sampleT sobre as mesmas tabelas): o shader calcula a posição
+// do passo anterior e a do atual e desenha entre as duas, como o
+// PathSystem::interpolate. Só o arredondamento muda, então as posições
+// ficam a menos de TOLERANCE das da CPU. O progresso passa de um para o
+// outro pelos WaypointPath (begin/end).
+//
+// Com a thread de desenho são duas instâncias: a da simulação compila e passa
+// o progresso (begin/end/sync, sem GL) e a do desenho recebe as Tables
+// prontas pelo snapshot (setTables) e só envia e despacha.
+class GpuPaths
+{
+public:
+	// Maior distância aceita entre a GPU e o PathSystem no mesmo instante
+	static constexpr float TOLERANCE = 1e-3f;
+
+	// std430: espelho do PathData do compute shader
+	struct PathData
+	{
+		GLuint entity;
+		GLuint firstSegment;
+		GLuint segmentCount;
+		PathSystem::Timing timing;
+	};
+
+	// a, b, c, d da cúbica; a.w é a distância do início do caminho ao do
+	// segmento e lengths[j] a do início do segmento à amostra t = (j + 1) / N
+	struct SegmentData
+	{
+		glm::vec4 a;
+		glm::vec4 b;
+		glm::vec4 c;
+		glm::vec4 d;
+		float lengths[PathSystem::LENGTH_SAMPLES];
+	};
+
+	// Tabelas compiladas de todos os caminhos. Depois de prontas não mudam:
+	// uma recompilação monta outras, então podem ir da simulação para a
+	// thread de desenho sem cópia
+	struct Tables
+	{
+		std::vector<PathData> paths;
+		std::vector<SegmentData> segments;
+	};
+
+	struct Stats
+	{
+		unsigned paths = 0;
+		unsigned segments = 0;
+		unsigned uploads = 0;
+		size_t bytes = 0;
+		double gpuMilliseconds = 0.0;
+		float maxError = 0.0f;   // GPU x conta do PathSystem, no último quadro
+	};
+
+	void init();
+	void destroy();
+
+	// Assume os caminhos a partir do progresso gravado nos WaypointPath
+	void begin(Scene& scene);
+	// Grava o progresso atual nos WaypointPath para a CPU continuar dali
+	void end(Scene& scene);
+	bool isActive() const { return m_active; }
+
+	// Recompila se os caminhos da cena mudaram (o envio fica para o animate)
+	void sync(Scene& scene);
+	// Do lado do desenho (RenderThread): usa as tabelas montadas pela
+	// instância da simulação, que não toca no GL; reenvia quando mudam
+	std::shared_ptr<const Tables> getTables() const { return m_tables; }
+	void setTables(std::shared_ptr<const Tables> tables);
+
+	// Tempo da simulação do próximo animate (SimulationClock); desenha entre
+	// os passos step - 1 e step, como o PathSystem::interpolate
+	void setTime(uint64_t step, float alpha);
+	// Escreve as posições no SSBO de ObjectData do GpuCuller
+	void animate(GLuint objectBuffer);
+
+	// Lê as posições de volta e compara com a conta do PathSystem
+	// (bloqueia; só para a tecla P)
+	const Stats& readStats();
+
+	// Custo por quadro na CPU do PathSystem x GPU e distância entre as
+	// posições lidas da GPU e as do PathSystem::interpolate em count caminhos
+	// aleatórios. Precisa de um contexto GL ativo (--benchmark-gpu-paths N)
+	static void benchmark(size_t count);
+private:
+	// Monta as tabelas na CPU a partir dos WaypointPath; animate() as envia
+	void compile(const Scene& scene);
+	void upload();
+	void saveProgress(Scene& scene) const;
+	// Segmento (absoluto) e t de uma distância do caminho
+	void locate(size_t path, float distance, uint32_t& segment, float& t) const;
+	// Posição no passo step + offset (offset em [-1, 0]), e a desenhada com
+	// alpha entre o passo anterior e step: a mesma do PathSystem
+	glm::vec3 positionAt(size_t path, uint32_t step, float offset) const;
+	glm::vec3 evaluate(size_t path, uint32_t step, float alpha) const;
+
+	GLuint m_program = 0;
+	// Locais dos uniforms, buscados uma vez no init
+	GLint m_pathCountLocation = -1;
+	GLint m_simulationStepLocation = -1;
+	GLint m_alphaLocation = -1;
+	GLuint m_pathSSBO = 0;
+	GLuint m_segmentSSBO = 0;
+	GLuint m_objectBuffer = 0;
+	GLuint m_timeQuery = 0;
+	bool m_queryPending = false;
+	bool m_active = false;
+
+	// Cópia do que está na GPU, para passar o progresso de volta à CPU, e as
+	// que foram enviadas por último
+	std::shared_ptr<const Tables> m_tables = std::make_shared<const Tables>();
+	std::shared_ptr<const Tables> m_uploaded;
+	uint64_t m_builtVersion = 0;
+	uint32_t m_step = 0;
+	float m_alpha = 0.0f;
+	Stats m_stats;
+};
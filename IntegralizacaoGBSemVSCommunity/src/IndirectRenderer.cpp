@@ -0,0 +1,318 @@
+#include "IndirectRenderer.h"
+#include "GlState.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <random>
+
+void IndirectRenderer::init(GeometryPool& geometry)
+{
+	m_geometry = &geometry;
+	m_geometry->init();
+	m_instanceCapacity = 0;
+	m_commandCapacity = 0;
+
+	glGenBuffers(1, &m_instanceVBO);
+	glGenBuffers(1, &m_indirectBuffer);
+
+	// O VAO do pool é o único do quadro, então os atributos por instância
+	// são configurados uma vez só; o baseInstance de cada comando escolhe a matriz
+	GlState::get().bindVertexArray(m_geometry->getVAO());
+	GlState::get().bindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+	for (GLuint column = 0; column < 4; ++column)
+	{
+		glVertexAttribPointer(INSTANCE_ATTRIB_LOCATION + column, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+			(void*)(offsetof(InstanceData, model) + column * sizeof(glm::vec4)));
+		glEnableVertexAttribArray(INSTANCE_ATTRIB_LOCATION + column);
+		glVertexAttribDivisor(INSTANCE_ATTRIB_LOCATION + column, 1);
+	}
+	glVertexAttribIPointer(MATERIAL_ATTRIB_LOCATION, 1, GL_UNSIGNED_INT, sizeof(InstanceData),
+		(void*)offsetof(InstanceData, materialIndex));
+	glEnableVertexAttribArray(MATERIAL_ATTRIB_LOCATION);
+	glVertexAttribDivisor(MATERIAL_ATTRIB_LOCATION, 1);
+	GlState::get().bindVertexArray(0);
+	GlState::get().bindBuffer(GL_ARRAY_BUFFER, 0);
+
+	if (!GLAD_GL_ARB_multi_draw_indirect)
+	{
+		std::cerr << "GL_ARB_multi_draw_indirect not supported, drawing one object at a time" << std::endl;
+		m_mode = Mode::PerObject;
+	}
+	if (!GLAD_GL_ARB_base_instance)
+	{
+		std::cerr << "GL_ARB_base_instance not supported, instance matrices will be wrong" << std::endl;
+	}
+}
+
+void IndirectRenderer::destroy()
+{
+	GlState::get().deleteBuffers(1, &m_instanceVBO);
+	GlState::get().deleteBuffers(1, &m_indirectBuffer);
+	m_instanceVBO = m_indirectBuffer = 0;
+	m_instanceCapacity = 0;
+	m_commandCapacity = 0;
+	m_geometry = nullptr;
+}
+
+GLuint IndirectRenderer::reserveInstances(size_t count)
+{
+	if (count > m_instanceCapacity)
+	{
+		m_instanceCapacity = std::max(count, m_instanceCapacity * 2);
+		GlState::get().bindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+		glBufferData(GL_ARRAY_BUFFER, m_instanceCapacity * sizeof(InstanceData), nullptr, GL_STREAM_DRAW);
+		GlState::get().bindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	return m_instanceVBO;
+}
+
+void IndirectRenderer::begin(const glm::mat4& view)
+{
+	m_view = view;
+	m_instances.clear();
+	m_queue.clear();
+}
+
+void IndirectRenderer::submit(const Scene& scene, Entity entity)
+{
+	const Renderable& renderable = scene.getRenderable(entity);
+	if (renderable.mesh)
+	{
+		submit(renderable.mesh.get(), renderable.getTextureID(), renderable.materialIndex, scene.getModelMatrix(entity));
+	}
+}
+
+void IndirectRenderer::submit(const GpuMesh* mesh, GLuint textureID, GLuint materialIndex, const glm::mat4& model)
+{
+	glm::vec4 center = model * glm::vec4(mesh->boundsCenter, 1.0f);
+	float viewDepth = -(m_view[0][2] * center.x + m_view[1][2] * center.y + m_view[2][2] * center.z + m_view[3][2]);
+	m_queue.push(m_program, textureID, mesh, viewDepth, static_cast<uint32_t>(m_instances.size()));
+	m_instances.push_back({ mesh, m_program, textureID, materialIndex, model });
+}
+
+void IndirectRenderer::flush()
+{
+	auto start = std::chrono::steady_clock::now();
+	m_stats = Stats();
+	if (m_instances.empty() || !m_geometry)
+	{
+		return;
+	}
+
+	buildCommands();
+	uploadBuffers();
+	if (m_mode == Mode::MultiDrawIndirect)
+	{
+		drawIndirect();
+	}
+	else
+	{
+		drawPerObject();
+	}
+
+	m_stats.instances = static_cast<unsigned>(m_instances.size());
+	m_stats.commands = static_cast<unsigned>(m_commands.size());
+	m_stats.buckets = static_cast<unsigned>(m_buckets.size());
+	m_stats.sortMilliseconds = m_queue.getStats().sortMilliseconds;
+	m_stats.submitMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void IndirectRenderer::buildCommands()
+{
+	// Programa e textura definem o balde, a malha o comando e a profundidade
+	// a ordem das instâncias dentro dele
+	const std::vector<uint32_t>& order = m_queue.sort();
+	m_sorted.resize(order.size());
+	m_instanceData.resize(order.size());
+	m_commands.clear();
+	m_buckets.clear();
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		const Instance& instance = m_instances[order[i]];
+		m_sorted[i] = &instance;
+		m_instanceData[i].model = instance.model;
+		m_instanceData[i].materialIndex = instance.materialIndex;
+
+		// Chaves podem colidir quando os ids saturam: compara os recursos em si
+		bool sameBucket = !m_buckets.empty() && m_buckets.back().program == instance.program
+			&& m_buckets.back().textureID == instance.textureID;
+		if (!sameBucket)
+		{
+			m_buckets.push_back({ instance.program, instance.textureID, m_commands.size(), 0 });
+		}
+		if (sameBucket && m_sorted[i - 1]->mesh == instance.mesh)
+		{
+			m_commands.back().instanceCount++;
+			continue;
+		}
+
+		const MeshRange& range = instance.mesh->range;
+		m_commands.push_back({ range.indexCount, 1, range.firstIndex, range.baseVertex, static_cast<GLuint>(i) });
+		m_buckets.back().commandCount++;
+	}
+}
+
+void IndirectRenderer::uploadBuffers()
+{
+	// Orphaning: o driver não precisa esperar o quadro anterior terminar
+	if (m_instanceData.size() > m_instanceCapacity)
+	{
+		m_instanceCapacity = std::max(m_instanceData.size(), m_instanceCapacity * 2);
+	}
+	GlState::get().bindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, m_instanceCapacity * sizeof(InstanceData), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, m_instanceData.size() * sizeof(InstanceData), m_instanceData.data());
+
+	if (m_mode != Mode::MultiDrawIndirect)
+	{
+		return;
+	}
+	if (m_commands.size() > m_commandCapacity)
+	{
+		m_commandCapacity = std::max(m_commands.size(), m_commandCapacity * 2);
+	}
+	GlState::get().bindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, m_commandCapacity * sizeof(DrawElementsIndirectCommand), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, m_commands.size() * sizeof(DrawElementsIndirectCommand), m_commands.data());
+}
+
+void IndirectRenderer::drawIndirect()
+{
+	for (const Bucket& bucket : m_buckets)
+	{
+		// O GlState descarta os binds que não mudam de um balde para o outro
+		if (bucket.program != 0)
+		{
+			GlState::get().useProgram(bucket.program);
+		}
+		GlState::get().bindTexture(GL_TEXTURE_2D, bucket.textureID);
+		GlState::get().bindVertexArray(m_geometry->getVAO());
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+			(void*)(bucket.firstCommand * sizeof(DrawElementsIndirectCommand)),
+			static_cast<GLsizei>(bucket.commandCount), 0);
+		m_stats.drawCalls++;
+	}
+}
+
+void IndirectRenderer::drawPerObject()
+{
+	// Um draw por objeto, como o renderer antigo, mas na ordem da fila; os
+	// binds que não mudam de um objeto para o outro não chegam ao driver
+	for (size_t i = 0; i < m_sorted.size(); ++i)
+	{
+		const Instance& instance = *m_sorted[i];
+		const MeshRange& range = instance.mesh->range;
+		if (instance.program != 0)
+		{
+			GlState::get().useProgram(instance.program);
+		}
+		GlState::get().bindTexture(GL_TEXTURE_2D, instance.textureID);
+		GlState::get().bindVertexArray(m_geometry->getVAO());
+		glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT,
+			(void*)(range.firstIndex * sizeof(GLuint)), 1, range.baseVertex, static_cast<GLuint>(i));
+		m_stats.drawCalls++;
+	}
+}
+
+
+void IndirectRenderer::benchmark(size_t frames, GLuint program)
+{
+	const size_t MESHES = 64;
+	const size_t TEXTURES = 8;
+	frames = std::max<size_t>(frames, 1);
+
+	// Malhas de um triângulo em faixas próprias do pool e texturas de 1
+	// pixel: no llvmpipe o vertex shader roda dentro do draw, então com
+	// modelos de verdade a medida seria a da GPU, não a da submissão
+	GeometryPool geometry;
+	std::vector<GpuMesh> meshes(MESHES);
+	for (size_t m = 0; m < MESHES; ++m)
+	{
+		const GLfloat vertices[3 * VERTEX_FLOATS] = {
+			-1.0f, -1.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f,
+			1.0f, -1.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
+			0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.5f, 1.0f
+		};
+		const GLuint indices[3] = { 0, 1, 2 };
+		geometry.allocate(vertices, 3, indices, 3, meshes[m].range);
+	}
+	GLuint textures[TEXTURES];
+	glGenTextures(TEXTURES, textures);
+	for (size_t t = 0; t < TEXTURES; ++t)
+	{
+		const unsigned char pixel[4] = { 255, static_cast<unsigned char>(t * 32), 0, 255 };
+		GlState::get().bindTexture(GL_TEXTURE_2D, textures[t]);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+	}
+	GlState::get().bindTexture(GL_TEXTURE_2D, 0);
+
+	IndirectRenderer renderer;
+	renderer.init(geometry);
+	renderer.setProgram(program);
+	if (!GLAD_GL_ARB_multi_draw_indirect)
+	{
+		renderer.destroy();
+		GlState::get().deleteTextures(TEXTURES, textures);
+		geometry.destroy();
+		return;
+	}
+
+	// O glFinish entre quadros fica fora da medida
+	const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 200.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	const size_t COUNTS[] = { 1000, 10000, 100000 };
+	std::cout << "Submit: " << MESHES << " meshes, " << TEXTURES << " textures, " << frames << " frames per size" << std::endl;
+	for (size_t count : COUNTS)
+	{
+		struct Object
+		{
+			const GpuMesh* mesh;
+			GLuint textureID;
+			glm::mat4 model;
+		};
+		std::mt19937 random(42);
+		std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+		std::uniform_int_distribution<size_t> mesh(0, MESHES - 1), texture(0, TEXTURES - 1);
+		std::vector<Object> objects(count);
+		for (Object& object : objects)
+		{
+			object = { &meshes[mesh(random)], textures[texture(random)],
+				glm::translate(glm::mat4(1.0f), glm::vec3(position(random), position(random), position(random))) };
+		}
+
+		double milliseconds[2] = {};
+		Stats stats[2];
+		const Mode MODES[2] = { Mode::PerObject, Mode::MultiDrawIndirect };
+		for (int m = 0; m < 2; ++m)
+		{
+			renderer.setMode(MODES[m]);
+			// Um quadro de aquecimento cresce os buffers antes da medida
+			for (size_t frame = 0; frame <= frames; ++frame)
+			{
+				glFinish();
+				auto start = std::chrono::steady_clock::now();
+				renderer.begin(view);
+				for (const Object& object : objects)
+				{
+					renderer.submit(object.mesh, object.textureID, 0, object.model);
+				}
+				renderer.flush();
+				if (frame > 0)
+				{
+					milliseconds[m] += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+				}
+			}
+			stats[m] = renderer.getStats();
+		}
+		glFinish();
+
+		std::cout << "  " << count << " objects: per object " << milliseconds[0] << " ms (" << stats[0].drawCalls
+			<< " draws), multi-draw indirect " << milliseconds[1] << " ms (" << stats[1].drawCalls << " draws, "
+			<< stats[1].commands << " commands), speedup " << milliseconds[0] / milliseconds[1] << "x" << std::endl;
+	}
+
+	renderer.destroy();
+	GlState::get().deleteTextures(TEXTURES, textures);
+	geometry.destroy();
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include "AssetRegistry.h"
+#include "GeometryPool.h"
+#include "RenderQueue.h"
+#include "Scene.h"
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Layout exigido pelo GL_DRAW_INDIRECT_BUFFER (glMultiDrawElementsIndirect)
+struct DrawElementsIndirectCommand
+{
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;
+};
+
+// Primeira das 4 localizações (uma por coluna) da matriz model por instância
+const GLuint INSTANCE_ATTRIB_LOCATION = 4;
+// Índice do material no MaterialTable, também por instância
+const GLuint MATERIAL_ATTRIB_LOCATION = 8;
+
+// Um elemento do buffer por instância
+struct InstanceData
+{
+	glm::mat4 model;
+	GLuint materialIndex;
+	GLuint padding[3];
+};
+
+// Desenha o quadro a partir do GeometryPool: os objetos passam por um
+// RenderQueue (programa, textura, malha e profundidade numa chave de 64 bits,
+// radix sort) e saem agrupados por estado e da frente para trás. Cada malha
+// de um balde (programa + textura) vira um DrawElementsIndirectCommand, e
+// cada balde é um único glMultiDrawElementsIndirect; os binds passam pelo
+// GlState, que descarta os repetidos entre baldes ou objetos seguidos. As matrizes model ficam num
+// buffer por instância (atributos 4..7, divisor 1) indexado pelo
+// baseInstance, junto com o índice do material (atributo 8).
+//
+// O modo PerObject mantém um draw por objeto (na mesma ordem) só para
+// comparar o custo de submissão na CPU (tecla M alterna, P mostra os tempos;
+// --benchmark-submit mede os dois modos).
+class IndirectRenderer
+{
+public:
+	enum class Mode
+	{
+		MultiDrawIndirect,
+		PerObject
+	};
+
+	struct Stats
+	{
+		unsigned drawCalls = 0;
+		unsigned instances = 0;
+		unsigned commands = 0;
+		unsigned buckets = 0;
+		double sortMilliseconds = 0.0;
+		double submitMilliseconds = 0.0;
+	};
+
+	void init(GeometryPool& geometry);
+	void destroy();
+
+	// view dá a profundidade usada para desenhar da frente para trás
+	void begin(const glm::mat4& view);
+	void submit(const Scene& scene, Entity entity);
+	void submit(const GpuMesh* mesh, GLuint textureID, GLuint materialIndex, const glm::mat4& model);
+	void flush();
+
+	// Caminho dirigido pela GPU (GpuCuller): garante espaço para count
+	// instâncias e devolve o buffer, que é escrito por um compute shader
+	GLuint reserveInstances(size_t count);
+
+	// Programa dos próximos submits (0: usa o que estiver em uso)
+	void setProgram(GLuint program) { m_program = program; }
+	void setMode(Mode mode) { m_mode = mode; }
+	Mode getMode() const { return m_mode; }
+	const Stats& getStats() const { return m_stats; }
+
+	// Tempo de submissão na CPU (submits + flush) dos dois modos com 1k, 10k
+	// e 100k objetos sintéticos, frames quadros cada, com o program dado.
+	// Precisa de um contexto GL ativo (--benchmark-submit N)
+	static void benchmark(size_t frames, GLuint program);
+private:
+	struct Instance
+	{
+		const GpuMesh* mesh;
+		GLuint program;
+		GLuint textureID;
+		GLuint materialIndex;
+		glm::mat4 model;
+	};
+
+	struct Bucket
+	{
+		GLuint program;
+		GLuint textureID;
+		size_t firstCommand;
+		size_t commandCount;
+	};
+
+	void buildCommands();
+	void uploadBuffers();
+	void drawIndirect();
+	void drawPerObject();
+
+	GeometryPool* m_geometry = nullptr;
+	Mode m_mode = Mode::MultiDrawIndirect;
+	GLuint m_program = 0;
+	glm::mat4 m_view = glm::mat4(1.0f);
+
+	RenderQueue m_queue;
+	std::vector<Instance> m_instances;
+	// Instâncias na ordem do RenderQueue
+	std::vector<const Instance*> m_sorted;
+	std::vector<InstanceData> m_instanceData;
+	std::vector<DrawElementsIndirectCommand> m_commands;
+	std::vector<Bucket> m_buckets;
+	GLuint m_instanceVBO = 0;
+	GLuint m_indirectBuffer = 0;
+	size_t m_instanceCapacity = 0;
+	size_t m_commandCapacity = 0;
+	Stats m_stats;
+};
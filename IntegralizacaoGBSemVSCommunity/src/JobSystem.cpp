@@ -0,0 +1,545 @@
+#include "JobSystem.h"
+#include "AssetRegistry.h"
+#include "FrustumCuller.h"
+#include "PathSystem.h"
+#include "Scene.h"
+#include "TransformSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+namespace
+{
+	// Índice do worker da thread atual (-1 fora dos workers)
+	thread_local int t_worker = -1;
+
+	double millisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+struct JobHandle::Group
+{
+	// Jobs que ainda não terminaram (+1 enquanto um open() não é fechado)
+	std::atomic<size_t> pending{ 0 };
+	std::mutex mutex;
+	bool done = false;
+	// Jobs esperando este grupo terminar
+	std::vector<JobSystem::Job*> continuations;
+};
+
+bool JobHandle::isDone() const
+{
+	return !m_group || m_group->pending.load(std::memory_order_acquire) == 0;
+}
+
+struct JobSystem::Job
+{
+	std::function<void()> work;
+	std::shared_ptr<JobHandle::Group> group;
+	// Dependências que faltam terminar, +1 até o job acabar de ser registrado
+	std::atomic<size_t> waiting{ 1 };
+};
+
+// Deque de Chase-Lev em anel de tamanho fixo (Lê et al., "Correct and
+// Efficient Work-Stealing for Weak Memory Models"). Só o dono chama push e
+// pop, no fundo; os outros roubam do topo, disputando com um CAS.
+class JobSystem::WorkDeque
+{
+public:
+	bool push(Job* job)
+	{
+		int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+		int64_t top = m_top.load(std::memory_order_acquire);
+		if (bottom - top >= static_cast<int64_t>(DEQUE_CAPACITY))
+		{
+			return false;
+		}
+		m_jobs[bottom & MASK].store(job, std::memory_order_relaxed);
+		m_bottom.store(bottom + 1, std::memory_order_release);
+		return true;
+	}
+
+	Job* pop()
+	{
+		int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+		m_bottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t top = m_top.load(std::memory_order_relaxed);
+		if (top > bottom)
+		{
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+		Job* job = m_jobs[bottom & MASK].load(std::memory_order_relaxed);
+		if (top == bottom)
+		{
+			// Último da deque: disputa com quem estiver roubando
+			if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				job = nullptr;
+			}
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		}
+		return job;
+	}
+
+	Job* steal()
+	{
+		int64_t top = m_top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t bottom = m_bottom.load(std::memory_order_acquire);
+		if (top >= bottom)
+		{
+			return nullptr;
+		}
+		Job* job = m_jobs[top & MASK].load(std::memory_order_relaxed);
+		if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			return nullptr;
+		}
+		return job;
+	}
+private:
+	static constexpr int64_t MASK = static_cast<int64_t>(DEQUE_CAPACITY) - 1;
+	static_assert((DEQUE_CAPACITY & (DEQUE_CAPACITY - 1)) == 0, "JobSystem deque capacity must be a power of two");
+
+	alignas(64) std::atomic<int64_t> m_top{ 0 };
+	alignas(64) std::atomic<int64_t> m_bottom{ 0 };
+	std::atomic<Job*> m_jobs[DEQUE_CAPACITY];
+};
+
+JobSystem& JobSystem::get()
+{
+	static JobSystem system;
+	return system;
+}
+
+JobSystem::JobSystem()
+{
+	setThreadCount(0);
+}
+
+JobSystem::~JobSystem()
+{
+	stop();
+}
+
+void JobSystem::setThreadCount(unsigned threads)
+{
+	if (threads == 0)
+	{
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	if (!m_workers.empty() && threads == getThreadCount())
+	{
+		return;
+	}
+	stop();
+	start(threads - 1);
+}
+
+void JobSystem::start(unsigned workers)
+{
+	m_stopping.store(false, std::memory_order_relaxed);
+	m_deques.clear();
+	for (unsigned i = 0; i < workers; ++i)
+	{
+		m_deques.push_back(std::make_unique<WorkDeque>());
+	}
+	for (unsigned i = 0; i < workers; ++i)
+	{
+		m_workers.emplace_back(&JobSystem::workerLoop, this, i);
+	}
+}
+
+void JobSystem::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_stopping.store(true, std::memory_order_seq_cst);
+	}
+	m_wake.notify_all();
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+	m_workers.clear();
+}
+
+void JobSystem::workerLoop(unsigned index)
+{
+	t_worker = static_cast<int>(index);
+	while (!m_stopping.load(std::memory_order_acquire))
+	{
+		if (runOne())
+		{
+			continue;
+		}
+		// Sem trabalho: dorme até alguém enfileirar. O contador de quem dorme
+		// sobe antes de olhar a fila, e push() olha o contador depois de
+		// enfileirar, então um dos dois sempre vê o outro
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_sleeping.fetch_add(1, std::memory_order_seq_cst);
+		m_wake.wait(lock, [this]()
+			{
+				return m_queued.load(std::memory_order_seq_cst) > 0 || m_stopping.load(std::memory_order_relaxed);
+			});
+		m_sleeping.fetch_sub(1, std::memory_order_relaxed);
+	}
+	t_worker = -1;
+}
+
+JobSystem::Job* JobSystem::createJob(std::function<void()> work, const std::shared_ptr<JobHandle::Group>& group,
+	const std::vector<JobHandle>& dependencies)
+{
+	Job* job = new Job();
+	job->work = std::move(work);
+	job->group = group;
+	for (const JobHandle& dependency : dependencies)
+	{
+		if (!dependency.m_group)
+		{
+			continue;
+		}
+		JobHandle::Group& other = *dependency.m_group;
+		std::lock_guard<std::mutex> lock(other.mutex);
+		if (!other.done)
+		{
+			job->waiting.fetch_add(1, std::memory_order_relaxed);
+			other.continuations.push_back(job);
+		}
+	}
+	return job;
+}
+
+void JobSystem::release(Job* job)
+{
+	if (job->waiting.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+		push(job);
+	}
+}
+
+void JobSystem::push(Job* job)
+{
+	bool queued = t_worker >= 0 && t_worker < static_cast<int>(m_deques.size()) && m_deques[t_worker]->push(job);
+	if (!queued && t_worker >= 0)
+	{
+		// Deque cheia: roda agora em vez de crescer
+		execute(job);
+		return;
+	}
+	if (!queued)
+	{
+		std::lock_guard<std::mutex> lock(m_injectedMutex);
+		m_injected.push_back(job);
+	}
+	m_queued.fetch_add(1, std::memory_order_seq_cst);
+	if (m_sleeping.load(std::memory_order_seq_cst) > 0)
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_wake.notify_one();
+	}
+}
+
+JobSystem::Job* JobSystem::take()
+{
+	if (m_queued.load(std::memory_order_acquire) <= 0)
+	{
+		return nullptr;
+	}
+	Job* job = nullptr;
+	if (t_worker >= 0)
+	{
+		job = m_deques[t_worker]->pop();
+	}
+	if (!job)
+	{
+		std::lock_guard<std::mutex> lock(m_injectedMutex);
+		if (!m_injected.empty())
+		{
+			job = m_injected.front();
+			m_injected.pop_front();
+		}
+	}
+	if (!job && !m_deques.empty())
+	{
+		// Uma volta pelas deques dos outros, começando num ponto qualquer
+		thread_local std::minstd_rand random(std::random_device{}());
+		size_t first = random() % m_deques.size();
+		for (size_t k = 0; k < m_deques.size() && !job; ++k)
+		{
+			size_t victim = (first + k) % m_deques.size();
+			if (static_cast<int>(victim) != t_worker)
+			{
+				job = m_deques[victim]->steal();
+			}
+		}
+		if (job)
+		{
+			m_stolen.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	if (job)
+	{
+		m_queued.fetch_sub(1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+bool JobSystem::runOne()
+{
+	Job* job = take();
+	if (!job)
+	{
+		return false;
+	}
+	execute(job);
+	return true;
+}
+
+void JobSystem::execute(Job* job)
+{
+	job->work();
+	std::shared_ptr<JobHandle::Group> group = std::move(job->group);
+	delete job;
+	m_executed.fetch_add(1, std::memory_order_relaxed);
+	finish(*group);
+}
+
+void JobSystem::finish(JobHandle::Group& group)
+{
+	if (group.pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+	{
+		return;
+	}
+	std::vector<Job*> continuations;
+	{
+		std::lock_guard<std::mutex> lock(group.mutex);
+		group.done = true;
+		continuations.swap(group.continuations);
+	}
+	for (Job* job : continuations)
+	{
+		release(job);
+	}
+}
+
+JobHandle JobSystem::schedule(std::function<void()> work, const std::vector<JobHandle>& dependencies)
+{
+	auto group = std::make_shared<JobHandle::Group>();
+	group->pending.store(1, std::memory_order_relaxed);
+	release(createJob(std::move(work), group, dependencies));
+	return JobHandle(group);
+}
+
+JobHandle JobSystem::parallelFor(size_t count, size_t grain, std::function<void(size_t, size_t)> work,
+	const std::vector<JobHandle>& dependencies)
+{
+	grain = std::max<size_t>(grain, 1);
+	size_t blocks = (count + grain - 1) / grain;
+	bool ready = std::all_of(dependencies.begin(), dependencies.end(), [](const JobHandle& dependency) { return dependency.isDone(); });
+	if (ready && (blocks <= 1 || m_workers.empty()))
+	{
+		for (size_t begin = 0; begin < count; begin += grain)
+		{
+			work(begin, std::min(count, begin + grain));
+		}
+		m_inline.fetch_add(1, std::memory_order_relaxed);
+		return JobHandle();
+	}
+
+	// Um job por bloco, todos no mesmo grupo. Com dependências pendentes os
+	// blocos só são criados quando elas terminam
+	auto group = std::make_shared<JobHandle::Group>();
+	group->pending.store(blocks, std::memory_order_relaxed);
+	auto body = std::make_shared<std::function<void(size_t, size_t)>>(std::move(work));
+	auto launch = [this, group, body, count, grain, blocks]()
+		{
+			for (size_t block = 0; block < blocks; ++block)
+			{
+				size_t begin = block * grain;
+				size_t end = std::min(count, begin + grain);
+				release(createJob([body, begin, end]() { (*body)(begin, end); }, group, {}));
+			}
+		};
+	if (ready)
+	{
+		launch();
+	}
+	else
+	{
+		// O job que lança os blocos conta no grupo até terminar
+		group->pending.fetch_add(1, std::memory_order_relaxed);
+		release(createJob(launch, group, dependencies));
+	}
+	return JobHandle(group);
+}
+
+void JobSystem::wait(const JobHandle& handle)
+{
+	while (!handle.isDone())
+	{
+		if (!runOne())
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+JobHandle JobSystem::open()
+{
+	auto group = std::make_shared<JobHandle::Group>();
+	group->pending.store(1, std::memory_order_relaxed);
+	return JobHandle(group);
+}
+
+void JobSystem::close(const JobHandle& handle)
+{
+	if (handle.m_group)
+	{
+		finish(*handle.m_group);
+	}
+}
+
+JobSystem::Stats JobSystem::getStats() const
+{
+	Stats stats;
+	stats.threads = getThreadCount();
+	stats.executed = m_executed.load(std::memory_order_relaxed);
+	stats.stolen = m_stolen.load(std::memory_order_relaxed);
+	stats.ranInline = m_inline.load(std::memory_order_relaxed);
+	return stats;
+}
+
+void JobSystem::resetStats()
+{
+	m_executed.store(0, std::memory_order_relaxed);
+	m_stolen.store(0, std::memory_order_relaxed);
+	m_inline.store(0, std::memory_order_relaxed);
+}
+
+namespace
+{
+	// Um quadro da simulação escrito como corrotina: cada etapa espera a
+	// anterior sem segurar nenhuma thread
+	JobTask simulateFrame(JobSystem& jobs, Scene& scene, PathSystem& paths, TransformSystem& transforms, FrustumCuller& culler)
+	{
+		co_await jobs.schedule([&]() { paths.update(scene); paths.interpolate(scene, 1.0f); });
+		co_await jobs.schedule([&]() { transforms.update(scene.getTransforms(), scene.getModels()); });
+		co_await jobs.schedule([&]() { culler.setBounds(scene); });
+	}
+}
+
+void JobSystem::benchmark(size_t count)
+{
+	const size_t FRAMES = 20;
+	const size_t WAYPOINTS = 4;
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f), offset(-10.0f, 10.0f), angle(-3.14159f, 3.14159f);
+
+	// Metade das entidades anda por caminhos; todas giram a cada quadro
+	auto mesh = std::make_shared<GpuMesh>();
+	mesh->boundsMin = glm::vec3(-1.0f);
+	mesh->boundsMax = glm::vec3(1.0f);
+	mesh->boundsRadius = std::sqrt(3.0f);
+	Scene scene;
+	std::vector<glm::vec3> angles(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		Entity entity = scene.createEntity();
+		glm::vec3 origin(position(random), position(random), position(random));
+		scene.getTransform(entity).setPosition(origin);
+		scene.getRenderable(entity).mesh = mesh;
+		angles[i] = glm::vec3(angle(random), angle(random), angle(random));
+		if (i % 2 == 0)
+		{
+			for (size_t w = 0; w < WAYPOINTS; ++w)
+			{
+				scene.addWaypoint(entity, origin + glm::vec3(offset(random), offset(random), offset(random)));
+			}
+		}
+	}
+	auto spin = [&](size_t frame)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				scene.getTransform(static_cast<Entity>(i)).setRotateAngle(angles[i] * float(frame + 1));
+			}
+		};
+
+	JobSystem& jobs = get();
+	unsigned previousThreads = jobs.getThreadCount();
+	unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<unsigned> threadCounts;
+	for (unsigned threads = 1; threads < cores; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(cores);
+
+	std::cout << "Jobs: " << count << " entities, " << count / 2 << " paths, " << cores << " hardware threads" << std::endl;
+	double baseTransforms = 0.0, basePaths = 0.0, baseBounds = 0.0, baseFrame = 0.0;
+	for (unsigned threads : threadCounts)
+	{
+		jobs.setThreadCount(threads);
+		TransformSystem transforms;
+		PathSystem paths;
+		FrustumCuller culler;
+		culler.resize(count);
+		paths.update(scene);
+		jobs.resetStats();
+
+		double transformMilliseconds = 0.0, pathMilliseconds = 0.0, boundsMilliseconds = 0.0;
+		for (size_t frame = 0; frame < FRAMES; ++frame)
+		{
+			spin(frame);
+			auto start = std::chrono::steady_clock::now();
+			paths.update(scene);
+			paths.interpolate(scene, 1.0f);
+			pathMilliseconds += millisecondsSince(start);
+
+			start = std::chrono::steady_clock::now();
+			transforms.update(scene.getTransforms(), scene.getModels());
+			transformMilliseconds += millisecondsSince(start);
+
+			start = std::chrono::steady_clock::now();
+			culler.setBounds(scene);
+			boundsMilliseconds += millisecondsSince(start);
+		}
+		Stats stats = jobs.getStats();
+
+		// As mesmas três etapas encadeadas pela corrotina
+		double frameMilliseconds = 0.0;
+		for (size_t frame = 0; frame < FRAMES; ++frame)
+		{
+			spin(frame);
+			auto start = std::chrono::steady_clock::now();
+			JobTask task = simulateFrame(jobs, scene, paths, transforms, culler);
+			jobs.wait(task.getHandle());
+			frameMilliseconds += millisecondsSince(start);
+		}
+
+		transformMilliseconds /= FRAMES;
+		pathMilliseconds /= FRAMES;
+		boundsMilliseconds /= FRAMES;
+		frameMilliseconds /= FRAMES;
+		if (threads == 1)
+		{
+			baseTransforms = transformMilliseconds;
+			basePaths = pathMilliseconds;
+			baseBounds = boundsMilliseconds;
+			baseFrame = frameMilliseconds;
+		}
+		std::cout << "  " << threads << " threads: transforms " << transformMilliseconds << " ms (" << baseTransforms / transformMilliseconds << "x)"
+			<< ", paths " << pathMilliseconds << " ms (" << basePaths / pathMilliseconds << "x)"
+			<< ", bounds " << boundsMilliseconds << " ms (" << baseBounds / boundsMilliseconds << "x)"
+			<< ", coroutine frame " << frameMilliseconds << " ms (" << baseFrame / frameMilliseconds << "x)"
+			<< ", jobs " << stats.executed << ", stolen " << stats.stolen << std::endl;
+	}
+	jobs.setThreadCount(previousThreads);
+}
@@ -0,0 +1,186 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobSystem;
+
+// Conjunto de jobs que terminam juntos (um schedule, todos os blocos de um
+// parallelFor ou uma JobTask). Vazio conta como já terminado.
+class JobHandle
+{
+public:
+	JobHandle() = default;
+
+	bool isDone() const;
+private:
+	friend class JobSystem;
+	struct Group;
+
+	explicit JobHandle(std::shared_ptr<Group> group) : m_group(std::move(group)) {}
+
+	std::shared_ptr<Group> m_group;
+};
+
+// Escalonador com roubo de trabalho. Cada worker tem a sua deque (Chase-Lev):
+// empilha e desempilha no fundo sem trava, e quem está sem trabalho rouba do
+// topo da de outro, escolhido ao acaso. Threads de fora (o loop principal, o
+// carregamento) entregam os jobs numa fila com mutex que os workers também
+// consomem, e em wait() ajudam a executar em vez de dormir, então com N
+// threads há N - 1 workers.
+//
+// Dependências: um job só entra numa fila quando todos os handles de que ele
+// depende terminaram. Quem termina o último job de um grupo solta os que
+// estavam esperando por ele; ninguém fica bloqueado esperando.
+class JobSystem
+{
+public:
+	// Capacidade da deque de cada worker; cheia, o job roda na hora
+	static constexpr size_t DEQUE_CAPACITY = 4096;
+
+	struct Stats
+	{
+		unsigned threads = 0;    // workers + quem chama wait()
+		uint64_t executed = 0;
+		uint64_t stolen = 0;     // tirados da deque de outro worker
+		uint64_t ranInline = 0;  // parallelFor rodados direto por não compensar dividir
+	};
+
+	static JobSystem& get();
+	~JobSystem();
+
+	// Troca o número de threads (workers + a que chama wait()); 0 usa o
+	// número de núcleos. Só sem jobs em andamento
+	void setThreadCount(unsigned threads);
+	unsigned getThreadCount() const { return static_cast<unsigned>(m_workers.size()) + 1; }
+
+	JobHandle schedule(std::function<void()> work, const std::vector<JobHandle>& dependencies = {});
+	// work(begin, end) sobre blocos de até grain itens de [0, count); os
+	// blocos começam em múltiplos de grain. Com um bloco só, ou nenhum
+	// worker, os blocos rodam em sequência na thread que chama (sem
+	// dependências pendentes)
+	JobHandle parallelFor(size_t count, size_t grain, std::function<void(size_t, size_t)> work,
+		const std::vector<JobHandle>& dependencies = {});
+	// Executa jobs até o handle terminar
+	void wait(const JobHandle& handle);
+	// Executa um job de qualquer fila, se houver (para quem espera por
+	// resultados que chegam fora de ordem); false se estavam todas vazias
+	bool help() { return runOne(); }
+
+	// Grupo sem jobs que só termina em close() (o fim de uma JobTask)
+	JobHandle open();
+	void close(const JobHandle& handle);
+
+	Stats getStats() const;
+	void resetStats();
+
+	// Transformações, caminhos e bounds de count entidades de 1 até N
+	// threads, e a mesma cadeia como corrotina (--benchmark-jobs N)
+	static void benchmark(size_t count);
+private:
+	friend class JobHandle;
+	struct Job;
+	class WorkDeque;
+
+	JobSystem();
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	void start(unsigned workers);
+	void stop();
+	void workerLoop(unsigned index);
+
+	Job* createJob(std::function<void()> work, const std::shared_ptr<JobHandle::Group>& group, const std::vector<JobHandle>& dependencies);
+	// Desconta uma dependência; na última o job vai para uma fila
+	void release(Job* job);
+	void push(Job* job);
+	// Um job de qualquer fila (a própria deque primeiro), ou nullptr
+	Job* take();
+	bool runOne();
+	void execute(Job* job);
+	void finish(JobHandle::Group& group);
+
+	std::vector<std::thread> m_workers;
+	std::vector<std::unique_ptr<WorkDeque>> m_deques;
+	std::mutex m_injectedMutex;
+	std::deque<Job*> m_injected;
+
+	// Jobs em alguma fila; os workers dormem quando chega a zero
+	std::atomic<int64_t> m_queued{ 0 };
+	std::atomic<unsigned> m_sleeping{ 0 };
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wake;
+	std::atomic<bool> m_stopping{ false };
+
+	std::atomic<uint64_t> m_executed{ 0 };
+	std::atomic<uint64_t> m_stolen{ 0 };
+	std::atomic<uint64_t> m_inline{ 0 };
+};
+
+// Espera um handle sem bloquear a thread: a corrotina é retomada num job
+// que depende dele
+struct JobAwaiter
+{
+	JobHandle handle;
+
+	bool await_ready() const { return handle.isDone(); }
+	void await_suspend(std::coroutine_handle<> coroutine)
+	{
+		JobSystem::get().schedule([coroutine]() { coroutine.resume(); }, { handle });
+	}
+	void await_resume() const {}
+};
+
+inline JobAwaiter operator co_await(JobHandle handle)
+{
+	return JobAwaiter{ std::move(handle) };
+}
+
+// Corrotina sobre o JobSystem: começa na thread que chama e, a cada
+// co_await de um JobHandle pendente, continua em quem terminar o último job
+// dele. getHandle() termina quando a corrotina chega ao fim, então pode ser
+// esperada com wait() ou dada como dependência de outros jobs.
+class JobTask
+{
+public:
+	struct promise_type
+	{
+		JobHandle handle = JobSystem::get().open();
+
+		JobTask get_return_object() { return JobTask(handle); }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		// Só depois que as variáveis locais foram destruídas; o quadro se libera sozinho
+		auto final_suspend() noexcept
+		{
+			struct Finish
+			{
+				promise_type* promise;
+				bool await_ready() noexcept
+				{
+					JobSystem::get().close(promise->handle);
+					return true;
+				}
+				void await_suspend(std::coroutine_handle<>) noexcept {}
+				void await_resume() noexcept {}
+			};
+			return Finish{ this };
+		}
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+	};
+
+	const JobHandle& getHandle() const { return m_handle; }
+private:
+	explicit JobTask(JobHandle handle) : m_handle(std::move(handle)) {}
+
+	JobHandle m_handle;
+};
@@ -4,16 +4,22 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+// Alcance usado quando o arquivo de luzes não informa "range"
+const float DEFAULT_LIGHT_RANGE = 20.0f;
+
+// Só guarda os dados; quem envia para a GPU é o LightClusters
 class Light
 {
 public:
-	Light(const glm::vec3& position, const glm::vec3& color, GLuint shaderID, int lightNumber);
+	Light(const glm::vec3& position, const glm::vec3& color, float range = DEFAULT_LIGHT_RANGE);
 	void setLightIntensity(const glm::vec3& color);
 	glm::vec3 getLightIntensity() const;
+	glm::vec3 getPosition() const { return m_position; }
+	// Distância a partir da qual a luz não contribui mais (atenuação chega a zero)
+	float getRange() const { return m_range; }
 private:
 	glm::vec3 m_position;
 	glm::vec3 m_color;
-	GLuint m_shaderID;
-	int m_lightNumber;
+	float m_range;
 };
 
@@ -0,0 +1,310 @@
+#include "LightClusters.h"
+#include "Camera.h"
+#include "GlState.h"
+#include "Light.h"
+#include "Simd.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+void LightClusters::init()
+{
+	glGenBuffers(1, &m_clusterUBO);
+	GlState::get().bindBuffer(GL_UNIFORM_BUFFER, m_clusterUBO);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(ClusterBlock), nullptr, GL_DYNAMIC_DRAW);
+	GlState::get().bindBufferBase(GL_UNIFORM_BUFFER, CLUSTER_UBO_BINDING, m_clusterUBO);
+	GlState::get().bindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	glGenBuffers(1, &m_lightSSBO);
+	glGenBuffers(1, &m_clusterSSBO);
+	glGenBuffers(1, &m_indexSSBO);
+
+	GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, m_clusterSSBO);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, CLUSTER_COUNT * sizeof(glm::uvec2), nullptr, GL_STREAM_DRAW);
+	GlState::get().bindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_SSBO_BINDING, m_clusterSSBO);
+	GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	m_lightCapacity = 0;
+	m_indexCapacity = 0;
+	m_lightsDirty = true;
+}
+
+void LightClusters::destroy()
+{
+	GlState::get().deleteBuffers(1, &m_clusterUBO);
+	GlState::get().deleteBuffers(1, &m_lightSSBO);
+	GlState::get().deleteBuffers(1, &m_clusterSSBO);
+	GlState::get().deleteBuffers(1, &m_indexSSBO);
+	m_clusterUBO = m_lightSSBO = m_clusterSSBO = m_indexSSBO = 0;
+}
+
+void LightClusters::setLights(const std::vector<Light>& lights)
+{
+	m_lights.resize(lights.size());
+	size_t padded = (lights.size() + 3) & ~size_t(3);
+	m_worldX.assign(padded, 0.0f);
+	m_worldY.assign(padded, 0.0f);
+	m_worldZ.assign(padded, 0.0f);
+	m_viewX.resize(padded);
+	m_viewY.resize(padded);
+	m_viewZ.resize(padded);
+	m_radius.assign(padded, 0.0f);
+
+	for (size_t i = 0; i < lights.size(); ++i)
+	{
+		glm::vec3 position = lights[i].getPosition();
+		m_lights[i].position = glm::vec4(position, lights[i].getRange());
+		m_lights[i].color = glm::vec4(lights[i].getLightIntensity(), 0.0f);
+		m_worldX[i] = position.x;
+		m_worldY[i] = position.y;
+		m_worldZ[i] = position.z;
+		m_radius[i] = lights[i].getRange();
+	}
+	m_lightsDirty = true;
+}
+
+void LightClusters::transformLights(const glm::mat4& view)
+{
+	// Só a posição importa: a view é rígida, então o raio não muda
+	size_t count = m_worldX.size();
+	size_t i = 0;
+#ifdef GB_USE_SSE
+	const __m128 r0 = _mm_set1_ps(view[0][0]), r1 = _mm_set1_ps(view[1][0]), r2 = _mm_set1_ps(view[2][0]), r3 = _mm_set1_ps(view[3][0]);
+	const __m128 u0 = _mm_set1_ps(view[0][1]), u1 = _mm_set1_ps(view[1][1]), u2 = _mm_set1_ps(view[2][1]), u3 = _mm_set1_ps(view[3][1]);
+	const __m128 f0 = _mm_set1_ps(view[0][2]), f1 = _mm_set1_ps(view[1][2]), f2 = _mm_set1_ps(view[2][2]), f3 = _mm_set1_ps(view[3][2]);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(&m_worldX[i]);
+		__m128 y = _mm_loadu_ps(&m_worldY[i]);
+		__m128 z = _mm_loadu_ps(&m_worldZ[i]);
+		_mm_storeu_ps(&m_viewX[i], _mm_add_ps(_mm_add_ps(_mm_mul_ps(r0, x), _mm_mul_ps(r1, y)), _mm_add_ps(_mm_mul_ps(r2, z), r3)));
+		_mm_storeu_ps(&m_viewY[i], _mm_add_ps(_mm_add_ps(_mm_mul_ps(u0, x), _mm_mul_ps(u1, y)), _mm_add_ps(_mm_mul_ps(u2, z), u3)));
+		_mm_storeu_ps(&m_viewZ[i], _mm_add_ps(_mm_add_ps(_mm_mul_ps(f0, x), _mm_mul_ps(f1, y)), _mm_add_ps(_mm_mul_ps(f2, z), f3)));
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		glm::vec4 p = view * glm::vec4(m_worldX[i], m_worldY[i], m_worldZ[i], 1.0f);
+		m_viewX[i] = p.x;
+		m_viewY[i] = p.y;
+		m_viewZ[i] = p.z;
+	}
+}
+
+unsigned LightClusters::depthSlice(float depth, float nearPlane, float farPlane) const
+{
+	float slice = std::log(depth / nearPlane) / std::log(farPlane / nearPlane) * GRID_Z;
+	return static_cast<unsigned>(std::clamp(slice, 0.0f, float(GRID_Z - 1)));
+}
+
+bool LightClusters::clusterRange(size_t light, const glm::mat4& projection, float nearPlane, float farPlane, ClusterRange& range) const
+{
+	float radius = m_lights[light].position.w;
+	float x = m_viewX[light], y = m_viewY[light];
+	// A câmera olha para -z; profundidade é positiva para frente
+	float minDepth = -m_viewZ[light] - radius;
+	float maxDepth = -m_viewZ[light] + radius;
+	if (maxDepth < nearPlane || minDepth > farPlane)
+	{
+		return false;
+	}
+	minDepth = std::max(minDepth, nearPlane);
+	maxDepth = std::min(maxDepth, farPlane);
+
+	// Projeção conservadora da caixa da esfera: x / profundidade é monótono na
+	// profundidade, então basta testar os dois extremos
+	auto project = [&](float low, float high, float scale, unsigned grid, unsigned& first, unsigned& last)
+		{
+			float ndcMin = std::min(scale * low / minDepth, scale * low / maxDepth);
+			float ndcMax = std::max(scale * high / minDepth, scale * high / maxDepth);
+			if (ndcMax < -1.0f || ndcMin > 1.0f)
+			{
+				return false;
+			}
+			first = static_cast<unsigned>(std::clamp((ndcMin + 1.0f) * 0.5f * grid, 0.0f, float(grid - 1)));
+			last = static_cast<unsigned>(std::clamp((ndcMax + 1.0f) * 0.5f * grid, 0.0f, float(grid - 1)));
+			return true;
+		};
+	if (!project(x - radius, x + radius, projection[0][0], GRID_X, range.minX, range.maxX)
+		|| !project(y - radius, y + radius, projection[1][1], GRID_Y, range.minY, range.maxY))
+	{
+		return false;
+	}
+	range.minZ = depthSlice(minDepth, nearPlane, farPlane);
+	range.maxZ = depthSlice(maxDepth, nearPlane, farPlane);
+	return true;
+}
+
+void LightClusters::clusterRanges(const glm::mat4& projection, float nearPlane, float farPlane)
+{
+	m_ranges.clear();
+	m_rangeLights.clear();
+	size_t count = m_lights.size();
+	size_t i = 0;
+#ifdef GB_USE_SSE
+	// A mesma conta do clusterRange com 4 luzes por vez. A fatia de uma
+	// profundidade é quantas fronteiras exponenciais ela já passou, o que
+	// troca o log por comparações
+	float logRatio = std::log(farPlane / nearPlane);
+	__m128 boundaries[GRID_Z - 1];
+	for (unsigned k = 1; k < GRID_Z; ++k)
+	{
+		boundaries[k - 1] = _mm_set1_ps(nearPlane * std::exp(logRatio * k / GRID_Z));
+	}
+	const __m128 nearDepth = _mm_set1_ps(nearPlane), farDepth = _mm_set1_ps(farPlane);
+	const __m128 one = _mm_set1_ps(1.0f), minusOne = _mm_set1_ps(-1.0f), half = _mm_set1_ps(0.5f), zero = _mm_setzero_ps();
+	const __m128 scaleX = _mm_set1_ps(projection[0][0]), scaleY = _mm_set1_ps(projection[1][1]);
+
+	// Devolve a máscara das luzes dentro da tela nesse eixo
+	auto project = [&](__m128 center, __m128 radius, __m128 scale, __m128 minDepth, __m128 maxDepth, unsigned grid,
+		__m128i& first, __m128i& last)
+		{
+			__m128 low = _mm_mul_ps(scale, _mm_sub_ps(center, radius));
+			__m128 high = _mm_mul_ps(scale, _mm_add_ps(center, radius));
+			__m128 ndcMin = _mm_min_ps(_mm_div_ps(low, minDepth), _mm_div_ps(low, maxDepth));
+			__m128 ndcMax = _mm_max_ps(_mm_div_ps(high, minDepth), _mm_div_ps(high, maxDepth));
+			const __m128 cells = _mm_set1_ps(0.5f * grid), lastCell = _mm_set1_ps(float(grid - 1));
+			first = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_add_ps(ndcMin, one), cells), zero), lastCell));
+			last = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_add_ps(ndcMax, one), cells), zero), lastCell));
+			return _mm_and_ps(_mm_cmpge_ps(ndcMax, minusOne), _mm_cmple_ps(ndcMin, one));
+		};
+
+	for (; i < count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(&m_viewX[i]);
+		__m128 y = _mm_loadu_ps(&m_viewY[i]);
+		__m128 depth = _mm_sub_ps(zero, _mm_loadu_ps(&m_viewZ[i]));
+		__m128 radius = _mm_loadu_ps(&m_radius[i]);
+		__m128 minDepth = _mm_sub_ps(depth, radius);
+		__m128 maxDepth = _mm_add_ps(depth, radius);
+		__m128 visible = _mm_and_ps(_mm_cmpge_ps(maxDepth, nearDepth), _mm_cmple_ps(minDepth, farDepth));
+		minDepth = _mm_max_ps(minDepth, nearDepth);
+		maxDepth = _mm_min_ps(maxDepth, farDepth);
+
+		__m128i minX, maxX, minY, maxY;
+		visible = _mm_and_ps(visible, project(x, radius, scaleX, minDepth, maxDepth, GRID_X, minX, maxX));
+		visible = _mm_and_ps(visible, project(y, radius, scaleY, minDepth, maxDepth, GRID_Y, minY, maxY));
+		// As sobras do último bloco de 4 não são luzes
+		unsigned mask = static_cast<unsigned>(_mm_movemask_ps(visible)) & ((1u << std::min<size_t>(4, count - i)) - 1);
+		if (mask == 0)
+		{
+			continue;
+		}
+
+		// Cada fronteira passada soma 1 (a comparação dá -1 na lane)
+		__m128i minZ = _mm_setzero_si128(), maxZ = _mm_setzero_si128();
+		for (const __m128& boundary : boundaries)
+		{
+			minZ = _mm_sub_epi32(minZ, _mm_castps_si128(_mm_cmpge_ps(minDepth, boundary)));
+			maxZ = _mm_sub_epi32(maxZ, _mm_castps_si128(_mm_cmpge_ps(maxDepth, boundary)));
+		}
+
+		alignas(16) unsigned lanes[6][4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(lanes[0]), minX);
+		_mm_store_si128(reinterpret_cast<__m128i*>(lanes[1]), maxX);
+		_mm_store_si128(reinterpret_cast<__m128i*>(lanes[2]), minY);
+		_mm_store_si128(reinterpret_cast<__m128i*>(lanes[3]), maxY);
+		_mm_store_si128(reinterpret_cast<__m128i*>(lanes[4]), minZ);
+		_mm_store_si128(reinterpret_cast<__m128i*>(lanes[5]), maxZ);
+		for (unsigned lane = 0; lane < 4; ++lane)
+		{
+			if (mask & (1u << lane))
+			{
+				m_ranges.push_back({ lanes[0][lane], lanes[1][lane], lanes[2][lane], lanes[3][lane], lanes[4][lane], lanes[5][lane] });
+				m_rangeLights.push_back(static_cast<unsigned>(i + lane));
+			}
+		}
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		ClusterRange range;
+		if (clusterRange(i, projection, nearPlane, farPlane, range))
+		{
+			m_ranges.push_back(range);
+			m_rangeLights.push_back(static_cast<unsigned>(i));
+		}
+	}
+}
+
+void LightClusters::update(const Camera& camera, int width, int height)
+{
+	auto start = std::chrono::steady_clock::now();
+	float nearPlane = camera.getNearPlane();
+	float farPlane = camera.getFarPlane();
+	glm::mat4 projection = camera.getProjectionMatrix();
+
+	if (m_lightsDirty)
+	{
+		GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, m_lightSSBO);
+		if (m_lights.size() > m_lightCapacity || m_lightCapacity == 0)
+		{
+			m_lightCapacity = std::max<size_t>(std::max(m_lights.size(), m_lightCapacity * 2), 1);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, m_lightCapacity * sizeof(LightData), nullptr, GL_DYNAMIC_DRAW);
+		}
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_lights.size() * sizeof(LightData), m_lights.data());
+		GlState::get().bindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_SSBO_BINDING, m_lightSSBO);
+		m_lightsDirty = false;
+	}
+
+	transformLights(camera.getViewMatrix());
+
+	// 1ª passada: intervalo de clusters de cada luz e contagem por cluster
+	clusterRanges(projection, nearPlane, farPlane);
+	m_clusters.assign(CLUSTER_COUNT, glm::uvec2(0));
+	for (const ClusterRange& range : m_ranges)
+	{
+		for (unsigned z = range.minZ; z <= range.maxZ; ++z)
+			for (unsigned y = range.minY; y <= range.maxY; ++y)
+				for (unsigned x = range.minX; x <= range.maxX; ++x)
+					m_clusters[x + GRID_X * (y + GRID_Y * z)].y++;
+	}
+
+	// Soma de prefixos vira o início de cada lista; a contagem é refeita no preenchimento
+	GLuint offset = 0;
+	m_stats.maxPerCluster = 0;
+	for (glm::uvec2& cluster : m_clusters)
+	{
+		m_stats.maxPerCluster = std::max(m_stats.maxPerCluster, cluster.y);
+		cluster.x = offset;
+		offset += cluster.y;
+		cluster.y = 0;
+	}
+	m_indices.resize(std::max<GLuint>(offset, 1));
+	for (size_t r = 0; r < m_ranges.size(); ++r)
+	{
+		const ClusterRange& range = m_ranges[r];
+		for (unsigned z = range.minZ; z <= range.maxZ; ++z)
+			for (unsigned y = range.minY; y <= range.maxY; ++y)
+				for (unsigned x = range.minX; x <= range.maxX; ++x)
+				{
+					glm::uvec2& cluster = m_clusters[x + GRID_X * (y + GRID_Y * z)];
+					m_indices[cluster.x + cluster.y++] = m_rangeLights[r];
+				}
+	}
+
+	ClusterBlock block;
+	block.gridSize = glm::uvec4(GRID_X, GRID_Y, GRID_Z, 0);
+	float logRatio = std::log(farPlane / nearPlane);
+	block.zParams = glm::vec4(GRID_Z / logRatio, -GRID_Z * std::log(nearPlane) / logRatio, nearPlane, farPlane);
+	block.tileSize = glm::vec4(float(width) / GRID_X, float(height) / GRID_Y, 0.0f, 0.0f);
+	GlState::get().bindBuffer(GL_UNIFORM_BUFFER, m_clusterUBO);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ClusterBlock), &block);
+
+	GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, m_clusterSSBO);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, CLUSTER_COUNT * sizeof(glm::uvec2), m_clusters.data(), GL_STREAM_DRAW);
+	GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, m_indexSSBO);
+	if (m_indices.size() > m_indexCapacity)
+	{
+		m_indexCapacity = std::max(m_indices.size(), m_indexCapacity * 2);
+	}
+	// Orphaning: a lista do quadro anterior pode ainda estar em uso
+	glBufferData(GL_SHADER_STORAGE_BUFFER, m_indexCapacity * sizeof(GLuint), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_indices.size() * sizeof(GLuint), m_indices.data());
+	GlState::get().bindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_INDEX_SSBO_BINDING, m_indexSSBO);
+
+	m_stats.lights = static_cast<unsigned>(m_lights.size());
+	m_stats.visibleLights = static_cast<unsigned>(m_ranges.size());
+	m_stats.references = offset;
+	m_stats.binMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+class Camera;
+class Light;
+
+// Pontos de ligação dos blocos usados pelo fragment shader
+const GLuint CLUSTER_UBO_BINDING = 1;
+const GLuint LIGHT_SSBO_BINDING = 3;
+const GLuint CLUSTER_SSBO_BINDING = 4;
+const GLuint LIGHT_INDEX_SSBO_BINDING = 5;
+
+// Espelho std430 de uma luz: position.w guarda o alcance
+struct LightData
+{
+	glm::vec4 position;
+	glm::vec4 color;
+};
+
+// Espelho std140 do bloco ClusterBlock
+struct ClusterBlock
+{
+	glm::uvec4 gridSize;
+	glm::vec4 zParams;    // escala e deslocamento do log da profundidade, near, far
+	glm::vec4 tileSize;   // tamanho de um cluster na tela, em pixels
+};
+
+// Forward clusterizado: o frustum da câmera é dividido em GRID_X x GRID_Y
+// blocos na tela e GRID_Z fatias de profundidade exponenciais. A cada quadro
+// as esferas de alcance das luzes são distribuídas nos clusters na CPU (a
+// transformação para o espaço da câmera e o intervalo de clusters de cada
+// luz usam SSE, 4 luzes por vez), e cada cluster recebe um intervalo numa
+// lista compacta de índices. O fragment shader só percorre as luzes do seu
+// cluster.
+class LightClusters
+{
+public:
+	static const unsigned GRID_X = 16;
+	static const unsigned GRID_Y = 9;
+	static const unsigned GRID_Z = 24;
+	static const unsigned CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+
+	struct Stats
+	{
+		unsigned lights = 0;
+		unsigned visibleLights = 0;
+		unsigned references = 0;
+		unsigned maxPerCluster = 0;
+		double binMilliseconds = 0.0;
+	};
+
+	void init();
+	void destroy();
+
+	// Só marca as luzes para upload; a distribuição acontece em update()
+	void setLights(const std::vector<Light>& lights);
+	// Distribui as luzes pelos clusters da câmera atual e envia tudo para a GPU
+	void update(const Camera& camera, int width, int height);
+
+	const Stats& getStats() const { return m_stats; }
+private:
+	struct ClusterRange
+	{
+		unsigned minX, maxX;
+		unsigned minY, maxY;
+		unsigned minZ, maxZ;
+	};
+
+	void transformLights(const glm::mat4& view);
+	// m_ranges e m_rangeLights das luzes que tocam algum cluster
+	void clusterRanges(const glm::mat4& projection, float nearPlane, float farPlane);
+	bool clusterRange(size_t light, const glm::mat4& projection, float nearPlane, float farPlane, ClusterRange& range) const;
+	unsigned depthSlice(float depth, float nearPlane, float farPlane) const;
+
+	std::vector<LightData> m_lights;
+	// Posições no mundo e no espaço da câmera em SoA (tamanho múltiplo de 4)
+	std::vector<float> m_worldX, m_worldY, m_worldZ;
+	std::vector<float> m_viewX, m_viewY, m_viewZ;
+	std::vector<float> m_radius;
+	std::vector<ClusterRange> m_ranges;
+	std::vector<unsigned> m_rangeLights;
+	std::vector<glm::uvec2> m_clusters;   // (início, quantidade) em m_indices
+	std::vector<GLuint> m_indices;
+
+	GLuint m_clusterUBO = 0;
+	GLuint m_lightSSBO = 0;
+	GLuint m_clusterSSBO = 0;
+	GLuint m_indexSSBO = 0;
+	size_t m_lightCapacity = 0;
+	size_t m_indexCapacity = 0;
+	bool m_lightsDirty = false;
+	Stats m_stats;
+};
@@ -0,0 +1,292 @@
+#include "LoadingBenchmark.h"
+#include "AssetRegistry.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <thread>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	double millisecondsBetween(Clock::time_point start, Clock::time_point end)
+	{
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+
+	// Esfera UV com rings faixas de 2 * rings quads, com coordenadas de
+	// textura e normais
+	void writeSphere(const std::string& path, const std::string& mtlName, unsigned rings)
+	{
+		const float PI = 3.14159265f;
+		unsigned segments = rings * 2;
+		std::ofstream obj(path);
+		obj << "mtllib " << mtlName << "\n";
+		for (unsigned r = 0; r <= rings; ++r)
+		{
+			for (unsigned s = 0; s <= segments; ++s)
+			{
+				float theta = PI * r / rings, phi = 2.0f * PI * s / segments;
+				glm::vec3 normal(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+				obj << "v " << normal.x << " " << normal.y << " " << normal.z << "\n";
+				obj << "vt " << float(s) / segments << " " << float(r) / rings << "\n";
+				obj << "vn " << normal.x << " " << normal.y << " " << normal.z << "\n";
+			}
+		}
+		for (unsigned r = 0; r < rings; ++r)
+		{
+			for (unsigned s = 0; s < segments; ++s)
+			{
+				unsigned a = r * (segments + 1) + s + 1, b = a + 1, c = a + segments + 1, d = c + 1;
+				obj << "f " << a << "/" << a << "/" << a << " " << c << "/" << c << "/" << c << " " << b << "/" << b << "/" << b << "\n";
+				obj << "f " << b << "/" << b << "/" << b << " " << c << "/" << c << "/" << c << " " << d << "/" << d << "/" << d << "\n";
+			}
+		}
+	}
+
+	// PNG RGB de 8 bits. O zlib tem um só bloco deflate de Huffman fixo, só
+	// com literais: o arquivo não encolhe, mas o stb_image ainda decodifica
+	// símbolo a símbolo, como num PNG de verdade
+	void writePng(const std::string& path, int width, int height, std::mt19937& random)
+	{
+		std::uniform_int_distribution<int> noise(0, 63);
+		std::vector<unsigned char> raw;
+		raw.reserve(static_cast<size_t>(width * 3 + 1) * height);
+		for (int y = 0; y < height; ++y)
+		{
+			raw.push_back(0);   // linha sem filtro
+			for (int x = 0; x < width; ++x)
+			{
+				raw.push_back(static_cast<unsigned char>(x * 192 / width + noise(random)));
+				raw.push_back(static_cast<unsigned char>(y * 192 / height + noise(random)));
+				raw.push_back(static_cast<unsigned char>(noise(random) * 4));
+			}
+		}
+
+		std::vector<unsigned char> zlib = { 0x78, 0x01 };
+		uint32_t bits = 0;
+		int bitCount = 0;
+		auto put = [&](uint32_t value, int count)
+			{
+				bits |= value << bitCount;
+				bitCount += count;
+				while (bitCount >= 8)
+				{
+					zlib.push_back(static_cast<unsigned char>(bits & 0xFF));
+					bits >>= 8;
+					bitCount -= 8;
+				}
+			};
+		// Os códigos de Huffman entram a partir do bit mais significativo
+		auto putCode = [&](uint32_t code, int length)
+			{
+				for (int i = length - 1; i >= 0; --i)
+				{
+					put((code >> i) & 1, 1);
+				}
+			};
+		put(1, 1);   // último bloco
+		put(1, 2);   // Huffman fixo
+		uint32_t a = 1, b = 0;
+		for (unsigned char byte : raw)
+		{
+			if (byte < 144)
+			{
+				putCode(0x30 + byte, 8);
+			}
+			else
+			{
+				putCode(0x190 + byte - 144, 9);
+			}
+			a = (a + byte) % 65521;
+			b = (b + a) % 65521;
+		}
+		putCode(0, 7);   // fim do bloco
+		if (bitCount > 0)
+		{
+			zlib.push_back(static_cast<unsigned char>(bits & 0xFF));
+		}
+		uint32_t adler = (b << 16) | a;
+		for (int shift = 24; shift >= 0; shift -= 8)
+		{
+			zlib.push_back(static_cast<unsigned char>(adler >> shift));
+		}
+
+		static uint32_t crcTable[256] = {};
+		if (crcTable[1] == 0)
+		{
+			for (uint32_t n = 0; n < 256; ++n)
+			{
+				uint32_t c = n;
+				for (int k = 0; k < 8; ++k)
+				{
+					c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+				}
+				crcTable[n] = c;
+			}
+		}
+
+		std::ofstream png(path, std::ios::binary);
+		auto put32 = [&](std::vector<unsigned char>& out, uint32_t value)
+			{
+				for (int shift = 24; shift >= 0; shift -= 8)
+				{
+					out.push_back(static_cast<unsigned char>(value >> shift));
+				}
+			};
+		auto chunk = [&](const char* type, const std::vector<unsigned char>& data)
+			{
+				std::vector<unsigned char> bytes;
+				put32(bytes, static_cast<uint32_t>(data.size()));
+				bytes.insert(bytes.end(), type, type + 4);
+				bytes.insert(bytes.end(), data.begin(), data.end());
+				uint32_t crc = 0xFFFFFFFFu;
+				for (size_t i = 4; i < bytes.size(); ++i)
+				{
+					crc = crcTable[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+				}
+				put32(bytes, crc ^ 0xFFFFFFFFu);
+				png.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+			};
+		const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		png.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+		std::vector<unsigned char> header;
+		put32(header, width);
+		put32(header, height);
+		header.insert(header.end(), { 8, 2, 0, 0, 0 });   // 8 bits, RGB
+		chunk("IHDR", header);
+		chunk("IDAT", zlib);
+		chunk("IEND", {});
+	}
+}
+
+void LoadingBenchmark::run(size_t count)
+{
+	namespace fs = std::filesystem;
+	std::mt19937 random(42);
+	std::uniform_int_distribution<unsigned> rings(8, 48);
+	std::uniform_int_distribution<int> textureScale(0, 3);
+
+	// Metade OBJ (cada um com o seu MTL), metade PNG de 64 a 512 pixels
+	fs::path directory = fs::temp_directory_path() / "gb_loading_benchmark";
+	std::error_code ec;
+	fs::remove_all(directory, ec);
+	fs::create_directories(directory);
+	size_t meshCount = std::max<size_t>(1, count / 2);
+	size_t textureCount = std::max<size_t>(1, count - meshCount);
+
+	auto generateStart = Clock::now();
+	for (size_t t = 0; t < textureCount; ++t)
+	{
+		int size = 64 << textureScale(random);
+		writePng((directory / ("texture" + std::to_string(t) + ".png")).generic_string(), size, size, random);
+	}
+	std::vector<std::string> paths;
+	for (size_t m = 0; m < meshCount; ++m)
+	{
+		std::string name = "model" + std::to_string(m);
+		std::ofstream mtl(directory / (name + ".mtl"));
+		mtl << "newmtl " << name << "\nKa 0.2 0.2 0.2\nKd 0.8 0.8 0.8\nKs 0.5 0.5 0.5\nNs 32\nmap_Kd texture"
+			<< m % textureCount << ".png\n";
+		paths.push_back((directory / (name + ".obj")).generic_string());
+		writeSphere(paths.back(), name + ".mtl", rings(random));
+	}
+	uintmax_t bytes = 0;
+	for (const fs::directory_entry& file : fs::directory_iterator(directory))
+	{
+		bytes += file.file_size();
+	}
+
+	JobSystem& jobs = JobSystem::get();
+	unsigned previousThreads = jobs.getThreadCount();
+	unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<unsigned> threadCounts;
+	for (unsigned threads = 1; threads < cores; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(cores);
+
+	std::cout << "Loading: " << meshCount << " OBJ + " << textureCount << " PNG (" << bytes / (1024.0 * 1024.0)
+		<< " MB) generated in " << millisecondsBetween(generateStart, Clock::now()) << " ms, " << cores
+		<< " hardware threads" << std::endl;
+	// Sem os .gbmesh da passada anterior: todas leem os OBJ
+	auto removeCaches = [&]()
+		{
+			for (const fs::directory_entry& file : fs::directory_iterator(directory))
+			{
+				if (file.path().extension() == ".gbmesh")
+				{
+					fs::remove(file.path(), ec);
+				}
+			}
+		};
+	double baseWall = 0.0;
+	double lastWall = 0.0;
+	for (unsigned threads : threadCounts)
+	{
+		removeCaches();
+
+		jobs.setThreadCount(threads);
+		AssetRegistry registry;
+		registry.setLogging(false);
+		std::vector<std::shared_ptr<GpuMesh>> meshes = registry.loadMeshes(paths);
+
+		const AssetRegistry::LoadReport& report = registry.getLoadReport();
+		if (baseWall == 0.0)
+		{
+			baseWall = report.wallMilliseconds;
+		}
+		registry.printLoadReport(3);
+		std::cout << "  " << threads << " threads: " << baseWall / report.wallMilliseconds << "x the single-threaded load, "
+			<< report.wallMilliseconds / report.criticalPathMilliseconds << "x the critical path" << std::endl;
+		lastWall = report.wallMilliseconds;
+
+		meshes.clear();
+		registry.clear();
+	}
+
+	// A mesma cena em streaming, com todas as threads: quanto o
+	// streamMeshes segura a thread (a primeira imagem espera isso mais o
+	// desenho) e quanto cada quadro gasta enviando, com 2 ms de orçamento
+	removeCaches();
+	{
+		AssetRegistry registry;
+		registry.setLogging(false);
+		auto streamStart = Clock::now();
+		std::vector<std::shared_ptr<GpuMesh>> meshes = registry.streamMeshes(paths);
+		double returned = millisecondsBetween(streamStart, Clock::now());
+		std::vector<AssetRegistry::MeshSwap> swaps;
+		while (registry.isStreaming())
+		{
+			registry.pumpStreaming(2.0);
+			glFinish();
+			// O vetor faz o papel da cena: as caixas trocadas podem ser liberadas
+			registry.takeSwaps(swaps);
+			for (const AssetRegistry::MeshSwap& swap : swaps)
+			{
+				std::replace(meshes.begin(), meshes.end(), swap.from, swap.to);
+			}
+			// Sem workers os jobs só andam quando alguém ajuda (no jogo, as
+			// esperas do grafo do quadro)
+			if (jobs.getThreadCount() == 1)
+			{
+				jobs.help();
+			}
+		}
+		const AssetRegistry::StreamStats& stats = registry.getStreamStats();
+		std::cout << "  streaming: streamMeshes returned after " << returned << " ms instead of " << lastWall << " ms, "
+			<< stats.stagedBytes / (1024.0 * 1024.0) << " MB through the staging ring in " << stats.frames
+			<< " frames, at most " << stats.maxPumpMilliseconds << " ms per frame" << std::endl;
+
+		meshes.clear();
+		registry.clear();
+	}
+	jobs.setThreadCount(previousThreads);
+	fs::remove_all(directory, ec);
+}
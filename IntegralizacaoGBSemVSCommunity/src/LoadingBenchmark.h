@@ -0,0 +1,13 @@
+#pragma once
+#include <cstddef>
+
+// Cena sintética para medir a carga do AssetRegistry: count assets (metade
+// OBJ com o seu MTL, metade PNG de 64 a 512 pixels) gerados numa pasta
+// temporária, carregados de 1 até N threads e depois em streaming. Usa só a
+// interface pública do registro e precisa de um contexto GL ativo
+// (--benchmark-loading N)
+class LoadingBenchmark
+{
+public:
+	static void run(size_t count);
+};
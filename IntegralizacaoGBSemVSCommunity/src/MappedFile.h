@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Mapeia um arquivo inteiro em memória somente leitura (mmap / MapViewOfFile).
+// O conteúdo fica válido enquanto o objeto existir.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	explicit MappedFile(const std::string& path) { open(path); }
+	~MappedFile() { close(); }
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	bool open(const std::string& path);
+	void close();
+
+	bool isOpen() const { return m_isOpen; }
+	const char* data() const { return m_data; }
+	size_t size() const { return m_size; }
+private:
+	const char* m_data = nullptr;
+	size_t m_size = 0;
+	bool m_isOpen = false;
+#ifdef _WIN32
+	void* m_file = nullptr;
+	void* m_mapping = nullptr;
+#else
+	int m_fd = -1;
+#endif
+};
@@ -0,0 +1,173 @@
+#include "MaterialTable.h"
+#include "GlState.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+	GpuMaterial pack(const Material& material)
+	{
+		GpuMaterial packed;
+		packed.ka = glm::vec4(material.ka, 1.0f);
+		packed.kd = glm::vec4(material.kd, 1.0f);
+		packed.ks = glm::vec4(material.ks, material.ns);
+		return packed;
+	}
+}
+
+MaterialTable::MaterialTable()
+{
+	m_materials.push_back(pack(Material()));
+}
+
+bool MaterialTable::parseLibrary(const std::string& mtlPath, std::vector<std::string>& names, std::vector<Material>& materials)
+{
+	std::ifstream mtlFile(mtlPath);
+	if (!mtlFile)
+	{
+		return false;
+	}
+
+	names.clear();
+	materials.clear();
+	std::string templine;
+	while (getline(mtlFile, templine))
+	{
+		std::istringstream iss(templine);
+		std::string keyword;
+		iss >> keyword;
+
+		if (keyword == "newmtl")
+		{
+			std::string name;
+			iss >> name;
+			names.push_back(name);
+			materials.push_back(Material());
+			continue;
+		}
+		if (keyword != "Ka" && keyword != "Kd" && keyword != "Ks" && keyword != "Ns" && keyword != "map_Kd")
+		{
+			continue;
+		}
+
+		// Propriedades antes de qualquer newmtl viram uma entrada sem nome
+		if (materials.empty())
+		{
+			names.push_back(std::string());
+			materials.push_back(Material());
+		}
+		Material& material = materials.back();
+		if (keyword == "Ka")
+		{
+			iss >> material.ka.r >> material.ka.g >> material.ka.b;
+		}
+		else if (keyword == "Kd")
+		{
+			iss >> material.kd.r >> material.kd.g >> material.kd.b;
+		}
+		else if (keyword == "Ks")
+		{
+			iss >> material.ks.r >> material.ks.g >> material.ks.b;
+		}
+		else if (keyword == "Ns")
+		{
+			iss >> material.ns;
+		}
+		else
+		{
+			iss >> material.diffuseTexture;
+		}
+	}
+	mtlFile.close();
+	return true;
+}
+
+bool MaterialTable::loadLibrary(const std::string& mtlPath, GLuint& firstIndex)
+{
+	auto found = m_libraries.find(mtlPath);
+	if (found != m_libraries.end())
+	{
+		firstIndex = found->second;
+		return true;
+	}
+
+	std::vector<std::string> names;
+	std::vector<Material> materials;
+	if (!parseLibrary(mtlPath, names, materials))
+	{
+		return false;
+	}
+	addLibrary(mtlPath, names, materials, firstIndex);
+	return true;
+}
+
+void MaterialTable::addLibrary(const std::string& mtlPath, const std::vector<std::string>& names, const std::vector<Material>& materials,
+	GLuint& firstIndex)
+{
+	auto found = m_libraries.find(mtlPath);
+	if (found != m_libraries.end())
+	{
+		firstIndex = found->second;
+		return;
+	}
+
+	// MTL sem entradas usa o material padrão
+	firstIndex = 0;
+	for (size_t i = 0; i < materials.size(); ++i)
+	{
+		GLuint index = add(materials[i]);
+		if (i == 0)
+		{
+			firstIndex = index;
+		}
+		m_byName[mtlPath + "#" + names[i]] = index;
+	}
+	m_libraries[mtlPath] = firstIndex;
+}
+
+GLuint MaterialTable::add(const Material& material)
+{
+	m_materials.push_back(pack(material));
+	m_dirty = true;
+	return static_cast<GLuint>(m_materials.size() - 1);
+}
+
+GLuint MaterialTable::find(const std::string& mtlPath, const std::string& name) const
+{
+	auto found = m_byName.find(mtlPath + "#" + name);
+	return found != m_byName.end() ? found->second : 0;
+}
+
+void MaterialTable::upload()
+{
+	if (!m_dirty)
+	{
+		return;
+	}
+
+	if (m_SSBO == 0)
+	{
+		glGenBuffers(1, &m_SSBO);
+	}
+	GlState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, m_SSBO);
+	if (m_materials.size() > m_capacity)
+	{
+		m_capacity = std::max(m_materials.size(), m_capacity * 2);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, m_capacity * sizeof(GpuMaterial), nullptr, GL_DYNAMIC_DRAW);
+	}
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_materials.size() * sizeof(GpuMaterial), m_materials.data());
+	GlState::get().bindBufferBase(GL_SHADER_STORAGE_BUFFER, MATERIAL_SSBO_BINDING, m_SSBO);
+	m_dirty = false;
+}
+
+void MaterialTable::destroy()
+{
+	GlState::get().deleteBuffers(1, &m_SSBO);
+	m_SSBO = 0;
+	m_capacity = 0;
+	m_materials.resize(1);
+	m_libraries.clear();
+	m_byName.clear();
+	m_dirty = true;
+}
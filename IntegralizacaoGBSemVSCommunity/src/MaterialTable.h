@@ -0,0 +1,54 @@
+#pragma once
+#include "Mesh.h"
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Ponto de ligação do bloco MaterialBlock no fragment shader
+const GLuint MATERIAL_SSBO_BINDING = 2;
+
+// Espelho std430 de um material no shader; ks.w guarda o expoente especular (Ns)
+struct GpuMaterial
+{
+	glm::vec4 ka;
+	glm::vec4 kd;
+	glm::vec4 ks;
+};
+
+// Todas as entradas de todos os MTL carregados, empacotadas num SSBO. Cada
+// objeto só carrega o índice do seu material (atributo por instância), então
+// desenhos em lote continuam com o material certo sem nenhum uniform por draw.
+// O índice 0 é sempre o material padrão, usado por malhas sem MTL.
+class MaterialTable
+{
+public:
+	MaterialTable();
+
+	// Lê todas as entradas newmtl do arquivo, na ordem em que aparecem
+	static bool parseLibrary(const std::string& mtlPath, std::vector<std::string>& names, std::vector<Material>& materials);
+
+	// Adiciona todas as entradas do MTL (só na primeira vez que o caminho aparece)
+	// e devolve o índice da primeira; false se o arquivo não abrir
+	bool loadLibrary(const std::string& mtlPath, GLuint& firstIndex);
+	// O mesmo com as entradas já lidas por parseLibrary (em outra thread)
+	void addLibrary(const std::string& mtlPath, const std::vector<std::string>& names, const std::vector<Material>& materials,
+		GLuint& firstIndex);
+	GLuint add(const Material& material);
+	// Índice de uma entrada já carregada, ou 0 se não existir
+	GLuint find(const std::string& mtlPath, const std::string& name) const;
+
+	// Envia a tabela para o SSBO se algo mudou desde o último upload
+	void upload();
+	void destroy();
+
+	size_t size() const { return m_materials.size(); }
+private:
+	std::vector<GpuMaterial> m_materials;
+	std::unordered_map<std::string, GLuint> m_libraries;   // caminho -> primeira entrada
+	std::unordered_map<std::string, GLuint> m_byName;      // caminho + "#" + nome -> entrada
+	GLuint m_SSBO = 0;
+	size_t m_capacity = 0;
+	bool m_dirty = true;
+};
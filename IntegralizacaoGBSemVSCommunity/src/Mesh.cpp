@@ -0,0 +1,70 @@
+#include "Mesh.h"
+#include "ObjParser.h"
+#include <cfloat>
+#include <cstdint>
+
+namespace
+{
+	inline uint64_t hashCorner(const ObjCorner& c)
+	{
+		uint64_t h = static_cast<uint32_t>(c.v);
+		h = h * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(c.vt);
+		return h ^ (h >> 29);
+	}
+
+	inline bool sameCorner(const ObjCorner& a, const ObjCorner& b)
+	{
+		return a.v == b.v && a.vt == b.vt;
+	}
+}
+
+namespace MeshBuilder
+{
+	void build(const ObjData& obj, MeshData& out)
+	{
+		out.vertices.clear();
+		out.indices.clear();
+		out.indices.reserve(obj.corners.size());
+
+		// Tabela hash de endereçamento aberto: canto -> índice do vértice único
+		size_t capacity = 16;
+		while (capacity < obj.corners.size() * 2) capacity <<= 1;
+		const size_t mask = capacity - 1;
+		std::vector<GLuint> table(capacity, UINT32_MAX);
+		std::vector<ObjCorner> unique;
+		unique.reserve(obj.corners.size() / 2);
+
+		for (const ObjCorner& corner : obj.corners)
+		{
+			size_t slot = hashCorner(corner) & mask;
+			while (table[slot] != UINT32_MAX && !sameCorner(unique[table[slot]], corner))
+			{
+				slot = (slot + 1) & mask;
+			}
+
+			if (table[slot] == UINT32_MAX)
+			{
+				table[slot] = static_cast<GLuint>(unique.size());
+				unique.push_back(corner);
+			}
+			out.indices.push_back(table[slot]);
+		}
+
+		out.vertices.reserve(unique.size() * VERTEX_FLOATS);
+		out.boundsMin = glm::vec3(unique.empty() ? 0.0f : FLT_MAX);
+		out.boundsMax = glm::vec3(unique.empty() ? 0.0f : -FLT_MAX);
+		for (const ObjCorner& corner : unique)
+		{
+			glm::vec3 vertex = corner.v >= 0 ? obj.positions[corner.v] : glm::vec3(0.0f);
+			glm::vec2 uv = corner.vt >= 0 ? obj.uvs[corner.vt] : glm::vec2(0.0f);
+			out.boundsMin = glm::min(out.boundsMin, vertex);
+			out.boundsMax = glm::max(out.boundsMax, vertex);
+
+			out.vertices.insert(out.vertices.end(), {
+				vertex.x, vertex.y, vertex.z,
+				1.0f, 0.0f, 0.0f,
+				uv.x, uv.y
+				});
+		}
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct ObjData;
+
+// Número de floats por vértice intercalado: posição (3), cor (3), textura (2)
+const int VERTEX_FLOATS = 8;
+
+// Parâmetros lidos do MTL
+struct Material
+{
+	glm::vec3 ka = glm::vec3(0.0f);
+	glm::vec3 kd = glm::vec3(0.0f);
+	glm::vec3 ks = glm::vec3(0.0f);
+	float ns = 32.0f;
+	std::string diffuseTexture;
+};
+
+// Malha indexada pronta para upload (VBO + EBO)
+struct MeshData
+{
+	std::vector<GLfloat> vertices;
+	std::vector<GLuint> indices;
+	glm::vec3 boundsMin = glm::vec3(0.0f);
+	glm::vec3 boundsMax = glm::vec3(0.0f);
+
+	size_t vertexCount() const { return vertices.size() / VERTEX_FLOATS; }
+};
+
+namespace MeshBuilder
+{
+	// Solda os cantos que compartilham o mesmo par (v, vt) em um único
+	// vértice e gera o buffer de índices correspondente. A normal (vn) não
+	// entra no formato de vértice, então não separa vértices
+	void build(const ObjData& obj, MeshData& out);
+}
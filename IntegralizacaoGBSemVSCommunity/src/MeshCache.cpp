@@ -0,0 +1,293 @@
+#include "MeshCache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace
+{
+	struct SourceStamp
+	{
+		uint64_t size = 0;
+		int64_t mtime = 0;
+	};
+
+	SourceStamp stampOf(const std::string& path)
+	{
+		SourceStamp stamp;
+		std::error_code ec;
+		std::filesystem::path p(path);
+		uint64_t size = std::filesystem::file_size(p, ec);
+		if (ec) return stamp;
+		auto time = std::filesystem::last_write_time(p, ec);
+		if (ec) return stamp;
+		stamp.size = size;
+		stamp.mtime = static_cast<int64_t>(time.time_since_epoch().count());
+		return stamp;
+	}
+
+	uint64_t alignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	// Formato conhecido e gravado a partir das fontes como estão agora
+	bool matchesSources(const MeshCache::Header& header, const std::string& objPath, const std::string& mtlPath)
+	{
+		if (header.magic != MeshCache::MAGIC || header.version != MeshCache::VERSION
+			|| header.headerSize != sizeof(MeshCache::Header) || header.vertexStride != VERTEX_FLOATS)
+		{
+			return false;
+		}
+
+		SourceStamp obj = stampOf(objPath);
+		SourceStamp mtl = stampOf(mtlPath);
+		return header.objSize == obj.size && header.objMtime == obj.mtime
+			&& header.mtlSize == mtl.size && header.mtlMtime == mtl.mtime;
+	}
+
+	// offset + bytes <= size sem estourar 64 bits com valores corrompidos
+	bool fits(uint64_t offset, uint64_t bytes, uint64_t size)
+	{
+		return offset <= size && bytes <= size - offset;
+	}
+}
+
+namespace MeshCache
+{
+	std::string cachePathFor(const std::string& objPath)
+	{
+		size_t dot = objPath.find_last_of('.');
+		size_t slash = objPath.find_last_of("/\\");
+		if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+		{
+			return objPath + ".gbmesh";
+		}
+		return objPath.substr(0, dot) + ".gbmesh";
+	}
+
+	bool CachedMesh::open(const std::string& cachePath, const std::string& objPath, const std::string& mtlPath)
+	{
+		m_header = nullptr;
+		if (!m_file.open(cachePath) || m_file.size() < sizeof(Header))
+		{
+			return false;
+		}
+
+		const Header* header = reinterpret_cast<const Header*>(m_file.data());
+		if (!matchesSources(*header, objPath, mtlPath))
+		{
+			return false;
+		}
+
+		if (header->indexType != GL_UNSIGNED_INT)
+		{
+			return false;
+		}
+
+		uint64_t fileSize = m_file.size();
+		if (!fits(header->vertexOffset, header->vertexBytes, fileSize)
+			|| !fits(header->indexOffset, header->indexBytes, fileSize)
+			|| !fits(header->materialOffset, header->materialBytes, fileSize)
+			|| !fits(header->stringOffset, header->stringBytes, fileSize)
+			|| !fits(header->occluderOffset, header->occluderBytes, fileSize)
+			|| header->vertexBytes != uint64_t(header->vertexCount) * VERTEX_FLOATS * sizeof(GLfloat)
+			|| header->indexBytes != uint64_t(header->indexCount) * sizeof(GLuint)
+			|| header->materialBytes != uint64_t(header->materialCount) * sizeof(MaterialRecord)
+			|| header->occluderBytes != uint64_t(header->occluderTriangles) * 9 * sizeof(float)
+			|| (header->vertexOffset | header->indexOffset | header->materialOffset | header->occluderOffset) % 16 != 0)
+		{
+			return false;
+		}
+
+		const MaterialRecord* records = reinterpret_cast<const MaterialRecord*>(m_file.data() + header->materialOffset);
+		for (uint32_t i = 0; i < header->materialCount; ++i)
+		{
+			if (!fits(records[i].nameOffset, records[i].nameBytes, header->stringBytes)
+				|| !fits(records[i].textureOffset, records[i].textureBytes, header->stringBytes))
+			{
+				return false;
+			}
+		}
+
+		// Um índice fora dos vértices faria o desenho ler além da faixa da malha
+		const GLuint* indices = reinterpret_cast<const GLuint*>(m_file.data() + header->indexOffset);
+		GLuint maxIndex = 0;
+		for (uint32_t i = 0; i < header->indexCount; ++i)
+		{
+			maxIndex = std::max(maxIndex, indices[i]);
+		}
+		if (header->indexCount > 0 && maxIndex >= header->vertexCount)
+		{
+			return false;
+		}
+
+		m_header = header;
+		return true;
+	}
+
+	bool readContentHash(const std::string& cachePath, const std::string& objPath, const std::string& mtlPath,
+		uint64_t& contentHash)
+	{
+		Header header;
+		std::ifstream in(cachePath, std::ios::binary);
+		if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || !matchesSources(header, objPath, mtlPath))
+		{
+			return false;
+		}
+		contentHash = header.contentHash;
+		return true;
+	}
+
+	void CachedMesh::library(std::vector<std::string>& names, std::vector<Material>& materials) const
+	{
+		const MaterialRecord* records = reinterpret_cast<const MaterialRecord*>(m_file.data() + m_header->materialOffset);
+		const char* strings = m_file.data() + m_header->stringOffset;
+		names.clear();
+		materials.clear();
+		names.reserve(m_header->materialCount);
+		materials.reserve(m_header->materialCount);
+		for (uint32_t i = 0; i < m_header->materialCount; ++i)
+		{
+			const MaterialRecord& record = records[i];
+			Material material;
+			material.ka = glm::vec3(record.ka[0], record.ka[1], record.ka[2]);
+			material.kd = glm::vec3(record.kd[0], record.kd[1], record.kd[2]);
+			material.ks = glm::vec3(record.ks[0], record.ks[1], record.ks[2]);
+			material.ns = record.ns;
+			material.diffuseTexture.assign(strings + record.textureOffset, record.textureBytes);
+			names.emplace_back(strings + record.nameOffset, record.nameBytes);
+			materials.push_back(std::move(material));
+		}
+	}
+
+	void CachedMesh::occluder(std::vector<glm::vec3>& triangles) const
+	{
+		const float* positions = reinterpret_cast<const float*>(m_file.data() + m_header->occluderOffset);
+		triangles.resize(size_t(m_header->occluderTriangles) * 3);
+		for (size_t i = 0; i < triangles.size(); ++i)
+		{
+			triangles[i] = glm::vec3(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]);
+		}
+	}
+
+	bool write(const std::string& cachePath, const std::string& objPath, const std::string& mtlPath,
+		uint64_t contentHash, const MeshData& mesh, float boundsRadius, const std::vector<glm::vec3>& occluder,
+		bool hasMaterial, const std::vector<std::string>& names, const std::vector<Material>& materials)
+	{
+		// Só triângulos inteiros, como floats soltos (glm::vec3 pode ter padding)
+		size_t occluderVertices = occluder.size() / 3 * 3;
+		std::vector<float> occluderPositions;
+		occluderPositions.reserve(occluderVertices * 3);
+		for (size_t i = 0; i < occluderVertices; ++i)
+		{
+			occluderPositions.insert(occluderPositions.end(), { occluder[i].x, occluder[i].y, occluder[i].z });
+		}
+
+		// Registros do MTL e as strings deles, uma depois da outra
+		std::vector<MaterialRecord> records(materials.size());
+		std::string strings;
+		for (size_t i = 0; i < materials.size(); ++i)
+		{
+			const Material& material = materials[i];
+			MaterialRecord& record = records[i];
+			for (int c = 0; c < 3; ++c)
+			{
+				record.ka[c] = material.ka[c];
+				record.kd[c] = material.kd[c];
+				record.ks[c] = material.ks[c];
+			}
+			record.ns = material.ns;
+			record.nameOffset = static_cast<uint32_t>(strings.size());
+			record.nameBytes = static_cast<uint32_t>(i < names.size() ? names[i].size() : 0);
+			if (i < names.size())
+			{
+				strings += names[i];
+			}
+			record.textureOffset = static_cast<uint32_t>(strings.size());
+			record.textureBytes = static_cast<uint32_t>(material.diffuseTexture.size());
+			strings += material.diffuseTexture;
+		}
+
+		Header header;
+		std::memset(&header, 0, sizeof(header));
+		header.magic = MAGIC;
+		header.version = VERSION;
+		header.headerSize = sizeof(Header);
+		header.vertexStride = VERTEX_FLOATS;
+
+		SourceStamp obj = stampOf(objPath);
+		SourceStamp mtl = stampOf(mtlPath);
+		header.objSize = obj.size;
+		header.objMtime = obj.mtime;
+		header.mtlSize = mtl.size;
+		header.mtlMtime = mtl.mtime;
+		header.contentHash = contentHash;
+
+		header.vertexCount = static_cast<uint32_t>(mesh.vertexCount());
+		header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+		header.indexType = GL_UNSIGNED_INT;
+		header.hasMaterial = hasMaterial ? 1 : 0;
+		header.materialCount = static_cast<uint32_t>(records.size());
+		header.occluderTriangles = static_cast<uint32_t>(occluder.size() / 3);
+
+		// Seções alinhadas em 16 bytes para o ponteiro mapeado ir direto ao driver
+		header.vertexOffset = alignUp(sizeof(Header), 16);
+		header.vertexBytes = mesh.vertices.size() * sizeof(GLfloat);
+		header.indexOffset = alignUp(header.vertexOffset + header.vertexBytes, 16);
+		header.indexBytes = mesh.indices.size() * sizeof(GLuint);
+		header.materialOffset = alignUp(header.indexOffset + header.indexBytes, 16);
+		header.materialBytes = records.size() * sizeof(MaterialRecord);
+		header.stringOffset = header.materialOffset + header.materialBytes;
+		header.stringBytes = strings.size();
+		header.occluderOffset = alignUp(header.stringOffset + header.stringBytes, 16);
+		header.occluderBytes = size_t(header.occluderTriangles) * 9 * sizeof(float);
+
+		for (int i = 0; i < 3; ++i)
+		{
+			header.boundsMin[i] = mesh.boundsMin[i];
+			header.boundsMax[i] = mesh.boundsMax[i];
+		}
+		header.boundsRadius = boundsRadius;
+
+		// Grava em um arquivo temporário e renomeia, para que uma execução
+		// interrompida nunca deixe um cache pela metade
+		std::string tempPath = cachePath + ".tmp";
+		{
+			std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+			if (!out)
+			{
+				return false;
+			}
+
+			const char padding[16] = {};
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			out.write(padding, header.vertexOffset - sizeof(header));
+			out.write(reinterpret_cast<const char*>(mesh.vertices.data()), header.vertexBytes);
+			out.write(padding, header.indexOffset - (header.vertexOffset + header.vertexBytes));
+			out.write(reinterpret_cast<const char*>(mesh.indices.data()), header.indexBytes);
+			out.write(padding, header.materialOffset - (header.indexOffset + header.indexBytes));
+			out.write(reinterpret_cast<const char*>(records.data()), header.materialBytes);
+			out.write(strings.data(), header.stringBytes);
+			out.write(padding, header.occluderOffset - (header.stringOffset + header.stringBytes));
+			out.write(reinterpret_cast<const char*>(occluderPositions.data()), header.occluderBytes);
+			if (!out)
+			{
+				out.close();
+				std::remove(tempPath.c_str());
+				return false;
+			}
+		}
+
+		std::error_code ec;
+		std::filesystem::rename(tempPath, cachePath, ec);
+		if (ec)
+		{
+			std::remove(tempPath.c_str());
+			return false;
+		}
+		return true;
+	}
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include "Mesh.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Cache binário (.gbmesh) gravado ao lado do OBJ depois da primeira carga.
+// Guarda os vértices intercalados e os índices já no formato final, os
+// limites da malha, a esfera envolvente, os triângulos oclusores e o MTL
+// inteiro, para que as próximas execuções só precisem mapear o arquivo e
+// passar os ponteiros direto para o glBufferData, sem percorrer a malha.
+namespace MeshCache
+{
+	const uint32_t MAGIC = 0x534D4247; // "GBMS"
+	const uint32_t VERSION = 5;
+
+	// Layout no disco (little endian, mesmo compilador que gravou)
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t headerSize;
+		uint32_t vertexStride;     // floats por vértice
+
+		// Identificação das fontes: se qualquer uma mudar, o cache é descartado
+		uint64_t objSize;
+		int64_t objMtime;
+		uint64_t mtlSize;          // 0 e mtime 0 quando não há MTL
+		int64_t mtlMtime;
+		// Hash do conteúdo do OBJ + MTL de quem gravou, para achar cópias em
+		// outros caminhos sem ler os arquivos de texto de novo
+		uint64_t contentHash;
+
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t indexType;        // GL_UNSIGNED_INT, como o EBO do GeometryPool
+		uint32_t hasMaterial;      // 1 se o MTL foi lido, mesmo sem entradas
+		uint32_t materialCount;
+		uint32_t occluderTriangles;
+
+		uint64_t vertexOffset;
+		uint64_t vertexBytes;
+		uint64_t indexOffset;
+		uint64_t indexBytes;
+		uint64_t materialOffset;   // materialCount MaterialRecord
+		uint64_t materialBytes;
+		uint64_t stringOffset;     // nomes e texturas dos materiais, sem '\0'
+		uint64_t stringBytes;
+		uint64_t occluderOffset;   // 3 vértices (x, y, z) por triângulo
+		uint64_t occluderBytes;
+
+		float boundsMin[3];
+		float boundsMax[3];
+		float boundsRadius;        // a partir do centro da AABB
+	};
+
+	// Uma entrada do MTL, na ordem do arquivo
+	struct MaterialRecord
+	{
+		float ka[3];
+		float kd[3];
+		float ks[3];
+		float ns;
+		// Faixas dentro da seção de strings
+		uint32_t nameOffset;
+		uint32_t nameBytes;
+		uint32_t textureOffset;
+		uint32_t textureBytes;
+	};
+
+	// Malha mapeada do disco. Os ponteiros valem enquanto o objeto existir.
+	class CachedMesh
+	{
+	public:
+		bool open(const std::string& cachePath, const std::string& objPath, const std::string& mtlPath);
+
+		const Header& header() const { return *m_header; }
+		const void* vertexData() const { return m_file.data() + m_header->vertexOffset; }
+		const GLuint* indexData() const { return reinterpret_cast<const GLuint*>(m_file.data() + m_header->indexOffset); }
+		bool hasMaterial() const { return m_header->hasMaterial != 0; }
+		// O MTL como o MaterialTable::parseLibrary o leria
+		void library(std::vector<std::string>& names, std::vector<Material>& materials) const;
+		glm::vec3 boundsMin() const { return glm::vec3(m_header->boundsMin[0], m_header->boundsMin[1], m_header->boundsMin[2]); }
+		glm::vec3 boundsMax() const { return glm::vec3(m_header->boundsMax[0], m_header->boundsMax[1], m_header->boundsMax[2]); }
+		float boundsRadius() const { return m_header->boundsRadius; }
+		uint64_t contentHash() const { return m_header->contentHash; }
+		void occluder(std::vector<glm::vec3>& triangles) const;
+	private:
+		MappedFile m_file;
+		const Header* m_header = nullptr;
+	};
+
+	// "pasta/Modelo.obj" -> "pasta/Modelo.gbmesh"
+	std::string cachePathFor(const std::string& objPath);
+
+	// Só o cabeçalho: o contentHash gravado, se o cache ainda vale para as
+	// fontes (mesmo teste de tamanho e mtime do open, sem validar as seções)
+	bool readContentHash(const std::string& cachePath, const std::string& objPath, const std::string& mtlPath,
+		uint64_t& contentHash);
+
+	// occluder tem 3 vértices por triângulo; hasMaterial diz se o MTL foi
+	// lido e names e materials são as entradas dele
+	bool write(const std::string& cachePath, const std::string& objPath, const std::string& mtlPath,
+		uint64_t contentHash, const MeshData& mesh, float boundsRadius, const std::vector<glm::vec3>& occluder,
+		bool hasMaterial, const std::vector<std::string>& names, const std::vector<Material>& materials);
+}
@@ -0,0 +1,427 @@
+#include "ObjParser.h"
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+	// Blocos menores que isso não compensam o custo de um job
+	const size_t MIN_CHUNK_BYTES = 256 * 1024;
+
+	// Resultado parcial de um bloco. Índices negativos do OBJ são relativos ao
+	// número de elementos lidos até a linha, então guardamos quais cantos
+	// precisam do deslocamento global para corrigir na junção dos blocos.
+	struct Chunk
+	{
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec2> uvs;
+		std::vector<glm::vec3> normals;
+		std::vector<ObjCorner> corners;
+		std::vector<uint32_t> relativeV;
+		std::vector<uint32_t> relativeVt;
+		std::vector<uint32_t> relativeVn;
+	};
+
+	inline bool isSpace(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	inline const char* skipSpaces(const char* p, const char* end)
+	{
+		while (p < end && isSpace(*p)) ++p;
+		return p;
+	}
+
+	inline const char* skipLine(const char* p, const char* end)
+	{
+		while (p < end && *p != '\n') ++p;
+		return p < end ? p + 1 : end;
+	}
+
+	inline const char* parseFloat(const char* p, const char* end, float& value)
+	{
+		p = skipSpaces(p, end);
+		if (p < end && *p == '+') ++p;
+		auto result = std::from_chars(p, end, value);
+		if (result.ec != std::errc())
+		{
+			value = 0.0f;
+			while (p < end && !isSpace(*p) && *p != '\n') ++p;
+			return p;
+		}
+		return result.ptr;
+	}
+
+	inline const char* parseInt(const char* p, const char* end, int& value)
+	{
+		if (p < end && *p == '+') ++p;
+		auto result = std::from_chars(p, end, value);
+		if (result.ec != std::errc())
+		{
+			value = 0;
+			return p;
+		}
+		return result.ptr;
+	}
+
+	// Converte um índice do OBJ (base 1, ou negativo relativo) para base 0 local
+	inline int resolveIndex(int index, size_t localCount, bool& relative)
+	{
+		relative = index < 0;
+		if (index > 0) return index - 1;
+		if (index < 0) return static_cast<int>(localCount) + index;
+		return -1;
+	}
+
+	struct FaceCorner
+	{
+		ObjCorner corner;
+		bool relV = false;
+		bool relVt = false;
+		bool relVn = false;
+	};
+
+	void pushCorner(Chunk& chunk, const FaceCorner& fc)
+	{
+		uint32_t slot = static_cast<uint32_t>(chunk.corners.size());
+		chunk.corners.push_back(fc.corner);
+		if (fc.relV) chunk.relativeV.push_back(slot);
+		if (fc.relVt) chunk.relativeVt.push_back(slot);
+		if (fc.relVn) chunk.relativeVn.push_back(slot);
+	}
+
+	void parseChunk(const char* p, const char* end, Chunk& chunk)
+	{
+		std::vector<FaceCorner> face;
+		face.reserve(8);
+
+		while (p < end)
+		{
+			p = skipSpaces(p, end);
+			if (p >= end) break;
+
+			if (p[0] == 'v' && p + 1 < end)
+			{
+				if (isSpace(p[1]))
+				{
+					glm::vec3 vertex;
+					p = parseFloat(p + 1, end, vertex.x);
+					p = parseFloat(p, end, vertex.y);
+					p = parseFloat(p, end, vertex.z);
+					chunk.positions.push_back(vertex);
+				}
+				else if (p[1] == 't' && p + 2 < end && isSpace(p[2]))
+				{
+					glm::vec2 uv;
+					p = parseFloat(p + 2, end, uv.x);
+					p = parseFloat(p, end, uv.y);
+					chunk.uvs.push_back(uv);
+				}
+				else if (p[1] == 'n' && p + 2 < end && isSpace(p[2]))
+				{
+					glm::vec3 normal;
+					p = parseFloat(p + 2, end, normal.x);
+					p = parseFloat(p, end, normal.y);
+					p = parseFloat(p, end, normal.z);
+					chunk.normals.push_back(normal);
+				}
+			}
+			else if (p[0] == 'f' && p + 1 < end && isSpace(p[1]))
+			{
+				face.clear();
+				p = skipSpaces(p + 1, end);
+				while (p < end && *p != '\n')
+				{
+					FaceCorner fc;
+					int index = 0;
+					const char* start = p;
+					p = parseInt(p, end, index);
+					if (p == start) break;
+					fc.corner.v = resolveIndex(index, chunk.positions.size(), fc.relV);
+
+					if (p < end && *p == '/')
+					{
+						++p;
+						if (p < end && *p != '/')
+						{
+							p = parseInt(p, end, index);
+							fc.corner.vt = resolveIndex(index, chunk.uvs.size(), fc.relVt);
+						}
+						if (p < end && *p == '/')
+						{
+							p = parseInt(p + 1, end, index);
+							fc.corner.vn = resolveIndex(index, chunk.normals.size(), fc.relVn);
+						}
+					}
+					face.push_back(fc);
+					p = skipSpaces(p, end);
+				}
+
+				// Polígonos com mais de 3 vértices viram um leque de triângulos
+				for (size_t i = 1; i + 1 < face.size(); ++i)
+				{
+					pushCorner(chunk, face[0]);
+					pushCorner(chunk, face[i]);
+					pushCorner(chunk, face[i + 1]);
+				}
+			}
+			p = skipLine(p, end);
+		}
+	}
+
+	// Cópia do laço que o Object::loadGeometry usava antes do ObjParser, só
+	// para o benchmark. Devolve o número de vértices expandidos
+	size_t legacyParse(const std::string& path)
+	{
+		std::vector<glm::vec3> v;
+		std::vector<glm::vec2> uvs;
+		std::vector<glm::vec3> normals;
+
+		std::ifstream file(path);
+
+		if (!file)
+		{
+			return 0;
+		}
+
+		std::vector<unsigned int> vertexIndices, uvIndices, normalIndices;
+		std::vector<glm::vec3> temp_vertices;
+		std::vector<glm::vec2> temp_uvs;
+		std::vector<glm::vec3> temp_normals;
+
+		std::string line;
+
+		while (std::getline(file, line))
+		{
+			std::istringstream iss(line);
+			std::string type;
+			iss >> type;
+
+			if (type == "v")
+			{
+				glm::vec3 vertex;
+				iss >> vertex.x >> vertex.y >> vertex.z;
+				temp_vertices.push_back(vertex);
+			}
+			else if (type == "vt")
+			{
+				glm::vec2 uv;
+				iss >> uv.x >> uv.y;
+				temp_uvs.push_back(uv);
+			}
+			else if (type == "vn")
+			{
+				glm::vec3 normal;
+				iss >> normal.x >> normal.y >> normal.z;
+				temp_normals.push_back(normal);
+			}
+			else if (type == "f")
+			{
+				unsigned int vertexIndex[3], uvIndex[3], normalIndex[3];
+				char slash;
+
+				for (int i = 0; i < 3; ++i)
+				{
+					iss >> vertexIndex[i] >> slash >> uvIndex[i] >> slash >> normalIndex[i];
+					vertexIndices.push_back(vertexIndex[i]);
+					uvIndices.push_back(uvIndex[i]);
+					normalIndices.push_back(normalIndex[i]);
+				}
+			}
+		}
+
+		for (unsigned int i = 0; i < vertexIndices.size(); ++i)
+		{
+			unsigned int vertexIndex = vertexIndices[i];
+			unsigned int uvIndex = uvIndices[i];
+			unsigned int normalIndex = normalIndices[i];
+
+			// O original lia fora do vetor com faces v//vn ou v; aqui o canto é pulado
+			if (vertexIndex - 1 >= temp_vertices.size() || uvIndex - 1 >= temp_uvs.size()
+				|| normalIndex - 1 >= temp_normals.size())
+			{
+				continue;
+			}
+
+			v.push_back(temp_vertices[vertexIndex - 1]);
+			uvs.push_back(temp_uvs[uvIndex - 1]);
+			normals.push_back(temp_normals[normalIndex - 1]);
+		}
+
+		return v.size();
+	}
+
+	double megabytesPerSecond(size_t bytes, double milliseconds)
+	{
+		return milliseconds > 0.0 ? (bytes / (1024.0 * 1024.0)) / (milliseconds / 1000.0) : 0.0;
+	}
+
+	// Um bloco por thread do JobSystem, desde que não fiquem pequenos demais
+	size_t chunkCountFor(size_t size)
+	{
+		return std::min<size_t>(JobSystem::get().getThreadCount(), std::max<size_t>(1, size / MIN_CHUNK_BYTES));
+	}
+}
+
+namespace ObjParser
+{
+	void parseBuffer(const char* data, size_t size, ObjData& out)
+	{
+		out = ObjData();
+		if (!data || size == 0)
+		{
+			return;
+		}
+
+		size_t chunkCount = chunkCountFor(size);
+
+		// Fronteiras dos blocos sempre logo após um '\n'
+		std::vector<const char*> bounds(chunkCount + 1);
+		const char* end = data + size;
+		bounds[0] = data;
+		bounds[chunkCount] = end;
+		for (size_t i = 1; i < chunkCount; ++i)
+		{
+			const char* p = std::max(data + size * i / chunkCount, bounds[i - 1]);
+			bounds[i] = skipLine(p, end);
+		}
+
+		std::vector<Chunk> chunks(chunkCount);
+		JobSystem& jobs = JobSystem::get();
+		jobs.wait(jobs.parallelFor(chunkCount, 1, [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					parseChunk(bounds[i], bounds[i + 1], chunks[i]);
+				}
+			}));
+
+		// Junta os blocos, somando o deslocamento global aos índices relativos
+		size_t totalV = 0, totalVt = 0, totalVn = 0, totalCorners = 0;
+		for (const Chunk& chunk : chunks)
+		{
+			totalV += chunk.positions.size();
+			totalVt += chunk.uvs.size();
+			totalVn += chunk.normals.size();
+			totalCorners += chunk.corners.size();
+		}
+		out.positions.reserve(totalV);
+		out.uvs.reserve(totalVt);
+		out.normals.reserve(totalVn);
+		out.corners.reserve(totalCorners);
+
+		for (const Chunk& chunk : chunks)
+		{
+			int baseV = static_cast<int>(out.positions.size());
+			int baseVt = static_cast<int>(out.uvs.size());
+			int baseVn = static_cast<int>(out.normals.size());
+			size_t baseCorner = out.corners.size();
+
+			out.positions.insert(out.positions.end(), chunk.positions.begin(), chunk.positions.end());
+			out.uvs.insert(out.uvs.end(), chunk.uvs.begin(), chunk.uvs.end());
+			out.normals.insert(out.normals.end(), chunk.normals.begin(), chunk.normals.end());
+			out.corners.insert(out.corners.end(), chunk.corners.begin(), chunk.corners.end());
+
+			for (uint32_t slot : chunk.relativeV) out.corners[baseCorner + slot].v += baseV;
+			for (uint32_t slot : chunk.relativeVt) out.corners[baseCorner + slot].vt += baseVt;
+			for (uint32_t slot : chunk.relativeVn) out.corners[baseCorner + slot].vn += baseVn;
+		}
+
+		// Índices fora do intervalo são tratados como ausentes
+		const int countV = static_cast<int>(out.positions.size());
+		const int countVt = static_cast<int>(out.uvs.size());
+		const int countVn = static_cast<int>(out.normals.size());
+		for (ObjCorner& corner : out.corners)
+		{
+			if (corner.v >= countV || corner.v < 0) corner.v = -1;
+			if (corner.vt >= countVt || corner.vt < 0) corner.vt = -1;
+			if (corner.vn >= countVn || corner.vn < 0) corner.vn = -1;
+		}
+	}
+
+	bool parseFile(const std::string& path, ObjData& out, ObjParseStats* stats)
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		MappedFile file;
+		if (!file.open(path))
+		{
+			return false;
+		}
+
+		parseBuffer(file.data(), file.size(), out);
+
+		if (stats)
+		{
+			stats->bytes = file.size();
+			stats->jobs = static_cast<unsigned>(chunkCountFor(file.size()));
+			stats->milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+		return true;
+	}
+
+	void benchmark(size_t rounds)
+	{
+		const std::string directory = "../assets/Modelos3D";
+		std::vector<std::string> paths;
+		std::error_code ec;
+		for (const auto& entry : std::filesystem::directory_iterator(directory, ec))
+		{
+			if (entry.is_regular_file() && entry.path().extension() == ".obj")
+			{
+				paths.push_back(entry.path().string());
+			}
+		}
+		std::sort(paths.begin(), paths.end());
+		if (paths.empty())
+		{
+			std::cerr << "No OBJ files found in " << directory << std::endl;
+			return;
+		}
+		rounds = std::max<size_t>(rounds, 1);
+
+		size_t totalBytes = 0;
+		double totalLegacy = 0.0, totalParser = 0.0;
+		for (const std::string& path : paths)
+		{
+			size_t bytes = std::filesystem::file_size(path, ec);
+			size_t legacyVertices = 0;
+			auto start = std::chrono::steady_clock::now();
+			for (size_t round = 0; round < rounds; ++round)
+			{
+				legacyVertices = legacyParse(path);
+			}
+			double legacyMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			ObjData obj;
+			start = std::chrono::steady_clock::now();
+			for (size_t round = 0; round < rounds; ++round)
+			{
+				parseFile(path, obj);
+			}
+			double parserMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			std::cout << path << ": " << bytes / 1024.0 << " KB, istringstream " << megabytesPerSecond(bytes * rounds, legacyMilliseconds)
+				<< " MB/s, parser " << megabytesPerSecond(bytes * rounds, parserMilliseconds) << " MB/s ("
+				<< chunkCountFor(bytes) << " jobs), speedup " << legacyMilliseconds / parserMilliseconds << "x" << std::endl;
+			if (legacyVertices != obj.corners.size())
+			{
+				std::cout << "  vertex count differs: istringstream " << legacyVertices << ", parser " << obj.corners.size() << std::endl;
+			}
+			totalBytes += bytes * rounds;
+			totalLegacy += legacyMilliseconds;
+			totalParser += parserMilliseconds;
+		}
+		std::cout << "OBJ total (" << paths.size() << " files x " << rounds << " rounds): istringstream "
+			<< megabytesPerSecond(totalBytes, totalLegacy) << " MB/s, parser " << megabytesPerSecond(totalBytes, totalParser)
+			<< " MB/s on " << JobSystem::get().getThreadCount() << " threads" << std::endl;
+	}
+}
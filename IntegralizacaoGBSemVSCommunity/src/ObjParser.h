@@ -0,0 +1,51 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Um canto de face do OBJ já convertido para índices base 0.
+// Componentes ausentes (ex.: "f 1//3") ficam com -1.
+struct ObjCorner
+{
+	int v = -1;
+	int vt = -1;
+	int vn = -1;
+};
+
+// Resultado do parsing: atributos na ordem do arquivo e faces trianguladas
+// (3 cantos por triângulo).
+struct ObjData
+{
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> normals;
+	std::vector<ObjCorner> corners;
+};
+
+struct ObjParseStats
+{
+	size_t bytes = 0;
+	unsigned jobs = 0;
+	double milliseconds = 0.0;
+
+	double megabytesPerSecond() const
+	{
+		return milliseconds > 0.0 ? (bytes / (1024.0 * 1024.0)) / (milliseconds / 1000.0) : 0.0;
+	}
+};
+
+namespace ObjParser
+{
+	// Mapeia o arquivo em memória, divide em blocos alinhados em '\n' (um por
+	// thread do JobSystem) e faz o parsing de cada bloco num job.
+	bool parseFile(const std::string& path, ObjData& out, ObjParseStats* stats = nullptr);
+
+	// Mesmo algoritmo sobre um buffer já carregado.
+	void parseBuffer(const char* data, size_t size, ObjData& out);
+
+	// Lê rounds vezes cada OBJ de ../assets/Modelos3D com o laço antigo
+	// (getline + istringstream) e com o parser atual e compara os MB/s
+	// (--benchmark-obj N)
+	void benchmark(size_t rounds);
+}
@@ -0,0 +1,305 @@
+#include "OcclusionCuller.h"
+#include "DynamicTree.h"
+#include "JobSystem.h"
+#include "Scene.h"
+#include "Simd.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+	// Vértice em clip space para a tela; falso se estiver antes do plano near
+	bool toScreen(const glm::vec4& clip, glm::vec3& screen)
+	{
+		if (clip.w <= 0.0f || clip.z < -clip.w)
+		{
+			return false;
+		}
+		glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		screen = glm::vec3((ndc.x * 0.5f + 0.5f) * OcclusionCuller::WIDTH,
+			(ndc.y * 0.5f + 0.5f) * OcclusionCuller::HEIGHT,
+			ndc.z * 0.5f + 0.5f);
+		return true;
+	}
+}
+
+OcclusionCuller::OcclusionCuller()
+{
+	int width = WIDTH, height = HEIGHT;
+	for (int level = 0; level < LEVELS; ++level)
+	{
+		m_levelWidth[level] = width;
+		m_levelHeight[level] = height;
+		m_levels[level].assign(size_t(width) * height, 1.0f);
+		width = std::max(1, (width + 1) / 2);
+		height = std::max(1, (height + 1) / 2);
+	}
+}
+
+const std::vector<uint32_t>& OcclusionCuller::cull(const Scene& scene, const std::vector<uint32_t>& candidates,
+	const glm::mat4& viewProjection, const glm::vec3& cameraPosition)
+{
+	auto start = std::chrono::steady_clock::now();
+	selectOccluders(scene, candidates, cameraPosition);
+	setupTriangles(scene, viewProjection);
+
+	// Cada job limpa e rasteriza a sua faixa de linhas; não há escrita compartilhada
+	if (!m_triangles.empty())
+	{
+		JobSystem& jobs = JobSystem::get();
+		jobs.wait(jobs.parallelFor(HEIGHT, ROWS_PER_JOB, [this](size_t begin, size_t end)
+			{
+				rasterizeRows(static_cast<int>(begin), static_cast<int>(end));
+			}));
+		buildPyramid();
+	}
+
+	auto rasterEnd = std::chrono::steady_clock::now();
+	m_visible.clear();
+	for (uint32_t index : candidates)
+	{
+		if (!isOccluded(scene, index, viewProjection))
+		{
+			m_visible.push_back(index);
+		}
+	}
+
+	m_stats.occluders = static_cast<unsigned>(m_occluders.size());
+	m_stats.triangles = static_cast<unsigned>(m_triangles.size());
+	m_stats.tested = static_cast<unsigned>(candidates.size());
+	m_stats.occluded = static_cast<unsigned>(candidates.size() - m_visible.size());
+	m_stats.jobs = m_triangles.empty() ? 0 : static_cast<unsigned>((HEIGHT + ROWS_PER_JOB - 1) / ROWS_PER_JOB);
+	m_stats.rasterMilliseconds = std::chrono::duration<double, std::milli>(rasterEnd - start).count();
+	m_stats.testMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - rasterEnd).count();
+	return m_visible;
+}
+
+void OcclusionCuller::selectOccluders(const Scene& scene, const std::vector<uint32_t>& candidates, const glm::vec3& cameraPosition)
+{
+	// Tamanho aparente aproximado pelo raio da esfera sobre a distância à câmera
+	std::vector<std::pair<float, uint32_t>> sizes;
+	for (uint32_t index : candidates)
+	{
+		const GpuMesh* mesh = scene.getMesh(index);
+		if (!mesh || mesh->occluder.empty())
+		{
+			continue;
+		}
+		const glm::mat4& model = scene.getModelMatrix(index);
+		float maxScale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+		glm::vec3 center = glm::vec3(model * glm::vec4(mesh->boundsCenter, 1.0f));
+		float size = mesh->boundsRadius * maxScale / std::max(glm::length(center - cameraPosition), 1e-3f);
+		if (size >= MIN_OCCLUDER_SIZE)
+		{
+			sizes.emplace_back(size, index);
+		}
+	}
+	size_t count = std::min(sizes.size(), MAX_OCCLUDERS);
+	std::partial_sort(sizes.begin(), sizes.begin() + count, sizes.end(),
+		[](const std::pair<float, uint32_t>& a, const std::pair<float, uint32_t>& b) { return a.first > b.first; });
+
+	m_occluders.clear();
+	for (size_t i = 0; i < count; ++i)
+	{
+		m_occluders.push_back(sizes[i].second);
+	}
+}
+
+void OcclusionCuller::setupTriangles(const Scene& scene, const glm::mat4& viewProjection)
+{
+	m_triangles.clear();
+	for (uint32_t index : m_occluders)
+	{
+		const std::vector<glm::vec3>& occluder = scene.getMesh(index)->occluder;
+		glm::mat4 modelViewProjection = viewProjection * scene.getModelMatrix(index);
+		for (size_t i = 0; i + 2 < occluder.size(); i += 3)
+		{
+			// Triângulos que cruzam o near são descartados: a GPU cortaria a parte
+			// da frente e eles deixariam de ser conservadores
+			glm::vec3 v[3];
+			if (!toScreen(modelViewProjection * glm::vec4(occluder[i], 1.0f), v[0])
+				|| !toScreen(modelViewProjection * glm::vec4(occluder[i + 1], 1.0f), v[1])
+				|| !toScreen(modelViewProjection * glm::vec4(occluder[i + 2], 1.0f), v[2]))
+			{
+				continue;
+			}
+
+			// Os dois lados da superfície ocluem: só a orientação é normalizada
+			float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[1].y - v[0].y) * (v[2].x - v[0].x);
+			if (area < 0.0f)
+			{
+				std::swap(v[1], v[2]);
+				area = -area;
+			}
+			if (area < 1e-6f)
+			{
+				continue;
+			}
+
+			ScreenTriangle triangle;
+			triangle.minX = std::max(0, int(std::floor(std::min({ v[0].x, v[1].x, v[2].x }))));
+			triangle.maxX = std::min(WIDTH - 1, int(std::floor(std::max({ v[0].x, v[1].x, v[2].x }))));
+			triangle.minY = std::max(0, int(std::floor(std::min({ v[0].y, v[1].y, v[2].y }))));
+			triangle.maxY = std::min(HEIGHT - 1, int(std::floor(std::max({ v[0].y, v[1].y, v[2].y }))));
+			if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+			{
+				continue;
+			}
+
+			// A aresta oposta ao vértice k vale area sobre k e 0 sobre a própria
+			// aresta, então dividida pela área é a coordenada baricêntrica de k
+			for (int k = 0; k < 3; ++k)
+			{
+				const glm::vec3& a = v[(k + 1) % 3];
+				const glm::vec3& b = v[(k + 2) % 3];
+				triangle.edgeA[k] = a.y - b.y;
+				triangle.edgeB[k] = b.x - a.x;
+				triangle.edgeC[k] = a.x * b.y - a.y * b.x;
+			}
+			triangle.depthA = (triangle.edgeA[0] * v[0].z + triangle.edgeA[1] * v[1].z + triangle.edgeA[2] * v[2].z) / area;
+			triangle.depthB = (triangle.edgeB[0] * v[0].z + triangle.edgeB[1] * v[1].z + triangle.edgeB[2] * v[2].z) / area;
+			triangle.depthC = (triangle.edgeC[0] * v[0].z + triangle.edgeC[1] * v[1].z + triangle.edgeC[2] * v[2].z) / area;
+			m_triangles.push_back(triangle);
+		}
+	}
+}
+
+void OcclusionCuller::rasterizeRows(int firstRow, int endRow)
+{
+	float* depth = m_levels[0].data();
+	std::fill(depth + firstRow * WIDTH, depth + endRow * WIDTH, 1.0f);
+
+	for (const ScreenTriangle& triangle : m_triangles)
+	{
+		int minY = std::max(triangle.minY, firstRow);
+		int maxY = std::min(triangle.maxY, endRow - 1);
+		// Começa alinhado em 4; WIDTH é múltiplo de 4, então a linha nunca estoura
+		int startX = triangle.minX & ~3;
+		for (int y = minY; y <= maxY; ++y)
+		{
+			float* row = depth + y * WIDTH;
+			float py = y + 0.5f;
+			int x = startX;
+#ifdef GB_USE_SSE
+			__m128 px = _mm_add_ps(_mm_set1_ps(float(x)), _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f));
+			__m128 edge[3], step[3];
+			for (int k = 0; k < 3; ++k)
+			{
+				edge[k] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.edgeA[k]), px), _mm_set1_ps(triangle.edgeB[k] * py + triangle.edgeC[k]));
+				step[k] = _mm_set1_ps(triangle.edgeA[k] * 4.0f);
+			}
+			__m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.depthA), px), _mm_set1_ps(triangle.depthB * py + triangle.depthC));
+			__m128 zStep = _mm_set1_ps(triangle.depthA * 4.0f);
+			const __m128 zero = _mm_setzero_ps();
+			for (; x <= triangle.maxX; x += 4)
+			{
+				__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edge[0], zero), _mm_cmpge_ps(edge[1], zero)), _mm_cmpge_ps(edge[2], zero));
+				if (_mm_movemask_ps(inside))
+				{
+					__m128 current = _mm_loadu_ps(row + x);
+					__m128 nearest = _mm_min_ps(current, z);
+					_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+				}
+				for (int k = 0; k < 3; ++k)
+				{
+					edge[k] = _mm_add_ps(edge[k], step[k]);
+				}
+				z = _mm_add_ps(z, zStep);
+			}
+#else
+			for (; x <= triangle.maxX; ++x)
+			{
+				float px = x + 0.5f;
+				bool inside = true;
+				for (int k = 0; k < 3; ++k)
+				{
+					inside = inside && triangle.edgeA[k] * px + triangle.edgeB[k] * py + triangle.edgeC[k] >= 0.0f;
+				}
+				if (inside)
+				{
+					row[x] = std::min(row[x], triangle.depthA * px + triangle.depthB * py + triangle.depthC);
+				}
+			}
+#endif
+		}
+	}
+}
+
+void OcclusionCuller::buildPyramid()
+{
+	for (int level = 1; level < LEVELS; ++level)
+	{
+		const std::vector<float>& below = m_levels[level - 1];
+		int belowWidth = m_levelWidth[level - 1], belowHeight = m_levelHeight[level - 1];
+		std::vector<float>& current = m_levels[level];
+		for (int y = 0; y < m_levelHeight[level]; ++y)
+		{
+			int y0 = 2 * y, y1 = std::min(2 * y + 1, belowHeight - 1);
+			for (int x = 0; x < m_levelWidth[level]; ++x)
+			{
+				int x0 = 2 * x, x1 = std::min(2 * x + 1, belowWidth - 1);
+				current[y * m_levelWidth[level] + x] = std::max(
+					std::max(below[y0 * belowWidth + x0], below[y0 * belowWidth + x1]),
+					std::max(below[y1 * belowWidth + x0], below[y1 * belowWidth + x1]));
+			}
+		}
+	}
+}
+
+bool OcclusionCuller::isOccluded(const Scene& scene, uint32_t index, const glm::mat4& viewProjection) const
+{
+	const GpuMesh* mesh = scene.getMesh(index);
+	if (!mesh || m_triangles.empty())
+	{
+		return false;
+	}
+
+	// Retângulo na tela e profundidade mais próxima dos 8 cantos da AABB no mundo
+	Aabb bounds = Aabb::transform({ mesh->boundsMin, mesh->boundsMax }, scene.getModelMatrix(index));
+	glm::vec2 screenMin(1e30f), screenMax(-1e30f);
+	float nearest = 1.0f;
+	for (int corner = 0; corner < 8; ++corner)
+	{
+		glm::vec3 point((corner & 1) ? bounds.upperBound.x : bounds.lowerBound.x,
+			(corner & 2) ? bounds.upperBound.y : bounds.lowerBound.y,
+			(corner & 4) ? bounds.upperBound.z : bounds.lowerBound.z);
+		glm::vec3 screen;
+		if (!toScreen(viewProjection * glm::vec4(point, 1.0f), screen))
+		{
+			// Cruza o near: nada pode estar na frente dele
+			return false;
+		}
+		screenMin = glm::min(screenMin, glm::vec2(screen));
+		screenMax = glm::max(screenMax, glm::vec2(screen));
+		nearest = std::min(nearest, screen.z);
+	}
+
+	int x0 = std::max(0, int(std::floor(screenMin.x)));
+	int x1 = std::min(WIDTH - 1, int(std::floor(screenMax.x)));
+	int y0 = std::max(0, int(std::floor(screenMin.y)));
+	int y1 = std::min(HEIGHT - 1, int(std::floor(screenMax.y)));
+	if (x0 > x1 || y0 > y1)
+	{
+		return false;
+	}
+
+	// Nível em que o retângulo cobre no máximo 2x2 texels
+	int level = 0;
+	while (level < LEVELS - 1 && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1))
+	{
+		++level;
+	}
+	const std::vector<float>& depth = m_levels[level];
+	for (int y = y0 >> level; y <= (y1 >> level); ++y)
+	{
+		for (int x = x0 >> level; x <= (x1 >> level); ++x)
+		{
+			if (depth[y * m_levelWidth[level] + x] >= nearest)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
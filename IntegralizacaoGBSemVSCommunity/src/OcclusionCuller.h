@@ -0,0 +1,72 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+class Scene;
+
+// Culling por oclusão em software. Os maiores objetos visíveis entram como
+// oclusores: os triângulos de GpuMesh::occluder são rasterizados num buffer
+// de profundidade pequeno (SSE, 4 pixels por vez, com a tela dividida em
+// faixas horizontais, uma por job). Desse buffer sai uma pirâmide em que
+// cada texel guarda a maior profundidade dos quatro de baixo. Um objeto é
+// descartado quando o ponto mais próximo da sua AABB fica atrás da maior
+// profundidade de todos os texels que o retângulo dele cobre na tela.
+class OcclusionCuller
+{
+public:
+	static constexpr int WIDTH = 256;
+	static constexpr int HEIGHT = 192;
+	static constexpr int LEVELS = 7;
+	// Até quantos objetos por quadro são rasterizados, e o tamanho mínimo na
+	// tela (raio / distância) para um objeto ser oclusor
+	static constexpr size_t MAX_OCCLUDERS = 64;
+	static constexpr float MIN_OCCLUDER_SIZE = 0.05f;
+	// Linhas do buffer por job de rasterização
+	static constexpr size_t ROWS_PER_JOB = 16;
+
+	struct Stats
+	{
+		unsigned occluders = 0;
+		unsigned triangles = 0;
+		unsigned tested = 0;
+		unsigned occluded = 0;
+		unsigned jobs = 0;
+		double rasterMilliseconds = 0.0;
+		double testMilliseconds = 0.0;
+	};
+
+	OcclusionCuller();
+
+	// Índices (em ordem) dos candidatos que não estão escondidos atrás dos oclusores
+	const std::vector<uint32_t>& cull(const Scene& scene, const std::vector<uint32_t>& candidates,
+		const glm::mat4& viewProjection, const glm::vec3& cameraPosition);
+
+	const std::vector<uint32_t>& getVisible() const { return m_visible; }
+	const Stats& getStats() const { return m_stats; }
+private:
+	// Triângulo já na tela, em forma de equações de plano em (x, y) de pixel:
+	// as três funções de aresta (>= 0 dentro) e a profundidade em [0, 1]
+	struct ScreenTriangle
+	{
+		float edgeA[3], edgeB[3], edgeC[3];
+		float depthA, depthB, depthC;
+		int minX, maxX, minY, maxY;
+	};
+
+	void selectOccluders(const Scene& scene, const std::vector<uint32_t>& candidates, const glm::vec3& cameraPosition);
+	void setupTriangles(const Scene& scene, const glm::mat4& viewProjection);
+	// Rasteriza todos os triângulos só nas linhas [firstRow, endRow)
+	void rasterizeRows(int firstRow, int endRow);
+	void buildPyramid();
+	bool isOccluded(const Scene& scene, uint32_t index, const glm::mat4& viewProjection) const;
+
+	std::vector<uint32_t> m_occluders;
+	std::vector<ScreenTriangle> m_triangles;
+	// Nível 0 é o buffer rasterizado; cada nível seguinte tem metade da resolução
+	std::vector<float> m_levels[LEVELS];
+	int m_levelWidth[LEVELS];
+	int m_levelHeight[LEVELS];
+	std::vector<uint32_t> m_visible;
+	Stats m_stats;
+};
@@ -0,0 +1,602 @@
+#include "PathSystem.h"
+#include "JobSystem.h"
+#include "Simd.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+namespace
+{
+	const size_t LANES = 4;
+
+	double millisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// Desvio padrão / média do deslocamento de cada quadro, na média dos caminhos
+	float stepVariation(const std::vector<std::vector<glm::vec3>>& tracks)
+	{
+		float total = 0.0f;
+		for (const std::vector<glm::vec3>& track : tracks)
+		{
+			std::vector<float> steps;
+			for (size_t frame = 1; frame < track.size(); ++frame)
+			{
+				steps.push_back(glm::length(track[frame] - track[frame - 1]));
+			}
+			float mean = 0.0f, variance = 0.0f;
+			for (float step : steps)
+			{
+				mean += step / steps.size();
+			}
+			for (float step : steps)
+			{
+				variance += (step - mean) * (step - mean) / steps.size();
+			}
+			total += mean > 0.0f ? std::sqrt(variance) / mean : 0.0f;
+		}
+		return tracks.empty() ? 0.0f : total / tracks.size();
+	}
+
+#ifdef GB_USE_SSE
+	__m128 select(__m128 mask, __m128 a, __m128 b)
+	{
+		return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+	}
+#endif
+}
+
+glm::vec3 PathSystem::catmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float t)
+{
+	float t2 = t * t;
+	float t3 = t2 * t;
+
+	return 0.5f * ((2.0f * p1) +
+		(-p0 + p2) * t +
+		(2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
+		(-p0 + 3.0f * p1 - 3.0f * p2 + p3) * t3);
+}
+
+PathSystem::Segment PathSystem::makeSegment(const std::vector<glm::vec3>& waypoints, size_t k)
+{
+	// Mesmos 4 pontos de antes, com volta no fim da lista
+	size_t count = waypoints.size();
+	glm::vec3 p0 = waypoints[(k + count - 1) % count];
+	glm::vec3 p1 = waypoints[k];
+	glm::vec3 p2 = waypoints[(k + 1) % count];
+	glm::vec3 p3 = waypoints[(k + 2) % count];
+	Segment segment;
+	segment.a = 0.5f * (-p0 + 3.0f * p1 - 3.0f * p2 + p3);
+	segment.b = 0.5f * (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3);
+	segment.c = 0.5f * (-p0 + p2);
+	segment.d = p1;
+	return segment;
+}
+
+float PathSystem::sampleLengths(const Segment& segment, float lengths[LENGTH_SAMPLES])
+{
+	// Integral de |P'(t)| em cada intervalo por Gauss-Legendre de 2 pontos
+	// (a soma das cordas fica curta nas curvas fechadas)
+	const float h = 1.0f / LENGTH_SAMPLES;
+	const float offset = h * 0.5f / std::sqrt(3.0f);
+	auto speedAt = [&](float t)
+		{
+			return glm::length((3.0f * segment.a * t + 2.0f * segment.b) * t + segment.c);
+		};
+	float length = 0.0f;
+	for (unsigned sample = 0; sample < LENGTH_SAMPLES; ++sample)
+	{
+		float middle = (sample + 0.5f) * h;
+		length += 0.5f * h * (speedAt(middle - offset) + speedAt(middle + offset));
+		lengths[sample] = length;
+	}
+	return length;
+}
+
+PathSystem::Timing PathSystem::makeTiming(float length, float step, uint32_t startStep, float startDistance)
+{
+	Timing timing;
+	timing.startStep = startStep;
+	timing.length = length;
+	timing.step = step;
+	timing.stepsPerLap = step > 0.0f ? length / step : 1.0f;
+	timing.startDistance = startDistance < length ? startDistance : 0.0f;
+	return timing;
+}
+
+float PathSystem::distanceAt(const Timing& timing, uint32_t step, float offset)
+{
+	// As voltas inteiras saem antes de multiplicar, para não perder precisão
+	float elapsed = float(step - timing.startStep);
+	float steps = elapsed - timing.stepsPerLap * std::floor(elapsed / timing.stepsPerLap) + offset;
+	if (steps < 0.0f)
+	{
+		steps += timing.stepsPerLap;
+	}
+	float distance = timing.startDistance + timing.step * steps;
+	return distance >= timing.length ? distance - timing.length : distance;
+}
+
+float PathSystem::sampleT(const float lengths[LENGTH_SAMPLES], float local)
+{
+	// Primeira amostra que chega em local; entre ela e a anterior, t linear
+	unsigned first = static_cast<unsigned>(std::lower_bound(lengths, lengths + LENGTH_SAMPLES - 1, local) - lengths);
+	float before = first > 0 ? lengths[first - 1] : 0.0f;
+	float span = lengths[first] - before;
+	return (float(first) + (span > 0.0f ? std::clamp((local - before) / span, 0.0f, 1.0f) : 0.0f)) / LENGTH_SAMPLES;
+}
+
+float PathSystem::sampleDistance(const float lengths[LENGTH_SAMPLES], float t)
+{
+	float scaled = std::clamp(t, 0.0f, 1.0f) * LENGTH_SAMPLES;
+	unsigned sample = std::min(static_cast<unsigned>(scaled), LENGTH_SAMPLES - 1);
+	float before = sample > 0 ? lengths[sample - 1] : 0.0f;
+	return before + (scaled - sample) * (lengths[sample] - before);
+}
+
+void PathSystem::saveProgress(Scene& scene) const
+{
+	ComponentArray<WaypointPath>& components = scene.getPaths();
+	for (size_t i = 0; i < m_entities.size(); ++i)
+	{
+		if (WaypointPath* path = components.find(m_entities[i]))
+		{
+			uint32_t segment = 0;
+			float t = 0.0f;
+			locate(i, segment, t);
+			path->currentWaypoint = segment - m_firstSegments[i];
+			path->t = t;
+		}
+	}
+}
+
+void PathSystem::reload()
+{
+	m_entities.clear();
+	m_builtVersion = 0;
+}
+
+void PathSystem::build(Scene& scene)
+{
+	// Devolve o progresso aos componentes antes de recompilar
+	saveProgress(scene);
+
+	ComponentArray<WaypointPath>& components = scene.getPaths();
+	const std::vector<WaypointPath>& paths = components.getValues();
+	m_entities = components.getEntities();
+	m_segments.clear();
+	m_segmentStarts.clear();
+	m_segmentLengths.clear();
+	m_firstSegments.clear();
+	m_segmentCounts.clear();
+	m_startSteps.clear();
+	m_lapLengths.clear();
+	m_stepLengths.clear();
+	m_stepsPerLap.clear();
+	m_startDistances.clear();
+	m_cursorSegments.clear();
+	m_cursorSamples.clear();
+	m_cursorStarts.clear();
+	m_cursorEnds.clear();
+	m_cursorLows.clear();
+	m_cursorHighs.clear();
+	m_cursorSpans.clear();
+	m_positions.clear();
+	m_previousPositions.clear();
+	for (size_t i = 0; i < paths.size(); ++i)
+	{
+		const std::vector<glm::vec3>& waypoints = paths[i].waypoints;
+		uint32_t first = static_cast<uint32_t>(m_segments.size());
+		size_t count = waypoints.size();
+		float length = 0.0f;
+		float lengths[LENGTH_SAMPLES] = {};
+		if (count == 0)
+		{
+			// Sem waypoints: fica parado onde está (comprimento e passo zero)
+			glm::vec3 position = scene.getTransform(m_entities[i]).position;
+			m_segments.push_back({ glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f), position });
+			m_segmentStarts.push_back(0.0f);
+			m_segmentLengths.insert(m_segmentLengths.end(), lengths, lengths + LENGTH_SAMPLES);
+			count = 1;
+		}
+
+		for (size_t k = 0; k < waypoints.size(); ++k)
+		{
+			m_segments.push_back(makeSegment(waypoints, k));
+			m_segmentStarts.push_back(length);
+			length += sampleLengths(m_segments.back(), lengths);
+			m_segmentLengths.insert(m_segmentLengths.end(), lengths, lengths + LENGTH_SAMPLES);
+		}
+
+		// O progresso (segmento, t) vira distância pela mesma tabela
+		uint32_t current = first + static_cast<uint32_t>(std::min<size_t>(paths[i].currentWaypoint, count - 1));
+		float startDistance = m_segmentStarts[current] + sampleDistance(&m_segmentLengths[current * LENGTH_SAMPLES], paths[i].t);
+		m_firstSegments.push_back(first);
+		m_segmentCounts.push_back(static_cast<uint32_t>(count));
+		Timing timing = makeTiming(length, paths[i].speed * length / count, m_step, startDistance);
+		m_startSteps.push_back(timing.startStep);
+		m_lapLengths.push_back(timing.length);
+		m_stepLengths.push_back(timing.step);
+		m_stepsPerLap.push_back(timing.stepsPerLap);
+		m_startDistances.push_back(timing.startDistance);
+		// Cursor vazio: o primeiro passo procura a partir do primeiro segmento
+		m_cursorSegments.push_back(first);
+		m_cursorSamples.push_back(0.0f);
+		m_cursorStarts.push_back(INFINITY);
+		m_cursorEnds.push_back(INFINITY);
+		m_cursorLows.push_back(-INFINITY);
+		m_cursorHighs.push_back(INFINITY);
+		m_cursorSpans.push_back(0.0f);
+		// Até o primeiro passo, fica onde está desenhado
+		glm::vec3 position = scene.getTransform(m_entities[i]).position;
+		m_positions.push_back(position);
+		m_previousPositions.push_back(position);
+	}
+	m_segments.push_back(Segment());
+
+	m_builtVersion = scene.getPathVersion();
+	m_stats.rebuilds++;
+}
+
+PathSystem::Timing PathSystem::timingOf(size_t path) const
+{
+	Timing timing;
+	timing.startStep = m_startSteps[path];
+	timing.length = m_lapLengths[path];
+	timing.step = m_stepLengths[path];
+	timing.stepsPerLap = m_stepsPerLap[path];
+	timing.startDistance = m_startDistances[path];
+	return timing;
+}
+
+void PathSystem::locate(size_t path, uint32_t& segment, float& t) const
+{
+	// Mesma busca do compute shader do GpuPaths: o último segmento que começa
+	// antes da distância, e o t pela tabela dele
+	float distance = distanceAt(timingOf(path), m_step, 0.0f);
+	uint32_t lower = m_firstSegments[path], upper = m_firstSegments[path] + m_segmentCounts[path] - 1;
+	while (lower < upper)
+	{
+		uint32_t middle = (lower + upper + 1) / 2;
+		if (m_segmentStarts[middle] <= distance)
+		{
+			lower = middle;
+		}
+		else
+		{
+			upper = middle - 1;
+		}
+	}
+	segment = lower;
+	t = sampleT(&m_segmentLengths[size_t(lower) * LENGTH_SAMPLES], distance - m_segmentStarts[lower]);
+}
+
+glm::vec3 PathSystem::advance(size_t path) const
+{
+	uint32_t index = 0;
+	float t = 0.0f;
+	locate(path, index, t);
+	const Segment& segment = m_segments[index];
+	return ((segment.a * t + segment.b) * t + segment.c) * t + segment.d;
+}
+
+void PathSystem::seek(size_t path, float distance)
+{
+	// Chega no mesmo segmento e na mesma amostra do locate (o último segmento
+	// que começa até a distância, a primeira amostra que chega nela), mas
+	// andando a partir de onde o cursor estava. A distância só diminui na
+	// virada da volta, e aí o cursor recomeça do primeiro segmento
+	uint32_t segment = m_cursorSegments[path];
+	unsigned sample = static_cast<unsigned>(m_cursorSamples[path]);
+	uint32_t last = m_firstSegments[path] + m_segmentCounts[path] - 1;
+	if (!(distance >= m_cursorStarts[path]))
+	{
+		segment = m_firstSegments[path];
+		sample = 0;
+	}
+	while (segment < last && m_segmentStarts[segment + 1] <= distance)
+	{
+		++segment;
+		sample = 0;
+	}
+	const float* lengths = &m_segmentLengths[size_t(segment) * LENGTH_SAMPLES];
+	float local = distance - m_segmentStarts[segment];
+	if (sample > 0 && !(local > lengths[sample - 1]))
+	{
+		sample = 0;
+	}
+	while (sample < LENGTH_SAMPLES - 1 && lengths[sample] < local)
+	{
+		++sample;
+	}
+
+	float before = sample > 0 ? lengths[sample - 1] : 0.0f;
+	m_cursorSegments[path] = segment;
+	m_cursorSamples[path] = float(sample);
+	m_cursorStarts[path] = m_segmentStarts[segment];
+	m_cursorEnds[path] = segment < last ? m_segmentStarts[segment + 1] : INFINITY;
+	m_cursorLows[path] = sample > 0 ? before : -INFINITY;
+	m_cursorHighs[path] = sample < LENGTH_SAMPLES - 1 ? lengths[sample] : INFINITY;
+	m_cursorSpans[path] = lengths[sample] - before;
+}
+
+glm::vec3 PathSystem::follow(size_t path)
+{
+	float distance = distanceAt(timingOf(path), m_step, 0.0f);
+	float local = distance - m_cursorStarts[path];
+	if (!(distance >= m_cursorStarts[path] && distance < m_cursorEnds[path] && local > m_cursorLows[path] && local <= m_cursorHighs[path]))
+	{
+		seek(path, distance);
+		local = distance - m_cursorStarts[path];
+	}
+	// O mesmo t do sampleT, com a amostra e os limites vindos do cursor
+	float before = std::max(m_cursorLows[path], 0.0f);
+	float span = m_cursorSpans[path];
+	float t = (m_cursorSamples[path] + (span > 0.0f ? std::clamp((local - before) / span, 0.0f, 1.0f) : 0.0f)) / LENGTH_SAMPLES;
+	const Segment& segment = m_segments[m_cursorSegments[path]];
+	return ((segment.a * t + segment.b) * t + segment.c) * t + segment.d;
+}
+
+void PathSystem::updateRange(size_t begin, size_t end)
+{
+	glm::vec4 positions[BLOCK];
+	for (size_t first = begin; first < end; first += BLOCK)
+	{
+		size_t count = std::min(BLOCK, end - first);
+		size_t k = 0;
+#ifdef GB_USE_SSE
+		// 4 caminhos por iteração, com as mesmas operações do follow: a
+		// distância, o teste do cursor e o t em registradores; só as lanes
+		// que saíram do cursor chamam o seek. Os coeficientes dos 4 segmentos
+		// são transpostos para um registrador por componente e a posição sai
+		// por Horner
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 exact = _mm_set1_ps(8388608.0f);
+		const __m128i step = _mm_set1_epi32(static_cast<int>(m_step));
+		for (; k + LANES <= count; k += LANES)
+		{
+			size_t i = first + k;
+			// distanceAt; os passos desde a compilação cabem em 31 bits, e
+			// o floor de um valor positivo é o truncamento abaixo de 2^23
+			// (acima disso o float já é inteiro)
+			__m128 stepsPerLap = _mm_loadu_ps(&m_stepsPerLap[i]);
+			__m128 elapsed = _mm_cvtepi32_ps(_mm_sub_epi32(step, _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_startSteps[i]))));
+			__m128 laps = _mm_div_ps(elapsed, stepsPerLap);
+			laps = select(_mm_cmplt_ps(laps, exact), _mm_cvtepi32_ps(_mm_cvttps_epi32(laps)), laps);
+			__m128 steps = _mm_sub_ps(elapsed, _mm_mul_ps(stepsPerLap, laps));
+			steps = _mm_add_ps(steps, _mm_and_ps(_mm_cmplt_ps(steps, zero), stepsPerLap));
+			__m128 lapLength = _mm_loadu_ps(&m_lapLengths[i]);
+			__m128 distance = _mm_add_ps(_mm_loadu_ps(&m_startDistances[i]), _mm_mul_ps(_mm_loadu_ps(&m_stepLengths[i]), steps));
+			distance = _mm_sub_ps(distance, _mm_and_ps(_mm_cmpge_ps(distance, lapLength), lapLength));
+
+			__m128 start = _mm_loadu_ps(&m_cursorStarts[i]);
+			__m128 local = _mm_sub_ps(distance, start);
+			__m128 inside = _mm_and_ps(
+				_mm_and_ps(_mm_cmpge_ps(distance, start), _mm_cmplt_ps(distance, _mm_loadu_ps(&m_cursorEnds[i]))),
+				_mm_and_ps(_mm_cmpgt_ps(local, _mm_loadu_ps(&m_cursorLows[i])), _mm_cmple_ps(local, _mm_loadu_ps(&m_cursorHighs[i]))));
+			unsigned moved = ~static_cast<unsigned>(_mm_movemask_ps(inside)) & 0xF;
+			if (moved)
+			{
+				alignas(16) float distances[LANES];
+				_mm_store_ps(distances, distance);
+				for (size_t lane = 0; lane < LANES; ++lane)
+				{
+					if (moved & (1u << lane))
+					{
+						seek(i + lane, distances[lane]);
+					}
+				}
+				local = _mm_sub_ps(distance, _mm_loadu_ps(&m_cursorStarts[i]));
+			}
+			__m128 before = _mm_max_ps(_mm_loadu_ps(&m_cursorLows[i]), zero);
+			__m128 span = _mm_loadu_ps(&m_cursorSpans[i]);
+			__m128 fraction = _mm_min_ps(_mm_max_ps(_mm_div_ps(_mm_sub_ps(local, before), span), zero), one);
+			fraction = _mm_and_ps(_mm_cmpgt_ps(span, zero), fraction);
+			__m128 t = _mm_div_ps(_mm_add_ps(_mm_loadu_ps(&m_cursorSamples[i]), fraction), _mm_set1_ps(float(LENGTH_SAMPLES)));
+
+			const Segment* s0 = &m_segments[m_cursorSegments[i]];
+			const Segment* s1 = &m_segments[m_cursorSegments[i + 1]];
+			const Segment* s2 = &m_segments[m_cursorSegments[i + 2]];
+			const Segment* s3 = &m_segments[m_cursorSegments[i + 3]];
+			__m128 ax = _mm_loadu_ps(&s0->a.x), ay = _mm_loadu_ps(&s1->a.x), az = _mm_loadu_ps(&s2->a.x), aw = _mm_loadu_ps(&s3->a.x);
+			__m128 bx = _mm_loadu_ps(&s0->b.x), by = _mm_loadu_ps(&s1->b.x), bz = _mm_loadu_ps(&s2->b.x), bw = _mm_loadu_ps(&s3->b.x);
+			__m128 cx = _mm_loadu_ps(&s0->c.x), cy = _mm_loadu_ps(&s1->c.x), cz = _mm_loadu_ps(&s2->c.x), cw = _mm_loadu_ps(&s3->c.x);
+			__m128 dx = _mm_loadu_ps(&s0->d.x), dy = _mm_loadu_ps(&s1->d.x), dz = _mm_loadu_ps(&s2->d.x), dw = _mm_loadu_ps(&s3->d.x);
+			_MM_TRANSPOSE4_PS(ax, ay, az, aw);
+			_MM_TRANSPOSE4_PS(bx, by, bz, bw);
+			_MM_TRANSPOSE4_PS(cx, cy, cz, cw);
+			_MM_TRANSPOSE4_PS(dx, dy, dz, dw);
+
+			__m128 px = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(ax, t), bx), t), cx), t), dx);
+			__m128 py = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(ay, t), by), t), cy), t), dy);
+			__m128 pz = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(az, t), bz), t), cz), t), dz);
+			__m128 pw = _mm_setzero_ps();
+			_MM_TRANSPOSE4_PS(px, py, pz, pw);
+			_mm_storeu_ps(&positions[k].x, px);
+			_mm_storeu_ps(&positions[k + 1].x, py);
+			_mm_storeu_ps(&positions[k + 2].x, pz);
+			_mm_storeu_ps(&positions[k + 3].x, pw);
+		}
+#endif
+		for (; k < count; ++k)
+		{
+			positions[k] = glm::vec4(follow(first + k), 0.0f);
+		}
+
+		for (k = 0; k < count; ++k)
+		{
+			m_previousPositions[first + k] = m_positions[first + k];
+			m_positions[first + k] = glm::vec3(positions[k]);
+		}
+	}
+}
+
+void PathSystem::update(Scene& scene)
+{
+	auto start = std::chrono::steady_clock::now();
+	if (scene.getPathVersion() != m_builtVersion)
+	{
+		build(scene);
+	}
+	++m_step;
+
+	// Cada job fica com um trecho contínuo (múltiplo de 4) dos caminhos;
+	// as entidades de cada trecho são distintas, então não há escrita compartilhada
+	size_t count = m_entities.size();
+	size_t grain = m_useJobs ? PATHS_PER_JOB : std::max<size_t>(count, 1);
+	JobSystem& jobs = JobSystem::get();
+	jobs.wait(jobs.parallelFor(count, grain, [this](size_t begin, size_t end) { updateRange(begin, end); }));
+
+	m_stats.paths = static_cast<unsigned>(count);
+	m_stats.segments = static_cast<unsigned>(m_segments.empty() ? 0 : m_segments.size() - 1);
+	m_stats.jobs = static_cast<unsigned>((count + grain - 1) / grain);
+	m_stats.updateMilliseconds = millisecondsSince(start);
+}
+
+void PathSystem::interpolate(Scene& scene, float alpha)
+{
+	for (size_t i = 0; i < m_entities.size(); ++i)
+	{
+		scene.getTransform(m_entities[i]).setPosition(glm::mix(m_previousPositions[i], m_positions[i], alpha));
+	}
+}
+
+void PathSystem::benchmark(size_t count)
+{
+	const size_t FRAMES = 10;
+	const size_t WAYPOINTS = 4;
+	const size_t TRACKED = std::min<size_t>(count, 1000);
+	const size_t TRACK_FRAMES = 400;
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f), offset(-10.0f, 10.0f);
+	Scene scene;
+	for (size_t i = 0; i < count; ++i)
+	{
+		Entity entity = scene.createEntity();
+		glm::vec3 origin(position(random), position(random), position(random));
+		for (size_t w = 0; w < WAYPOINTS; ++w)
+		{
+			// Espaçamento desigual: é aí que o t uniforme acelera e freia
+			scene.addWaypoint(entity, origin + glm::vec3(offset(random), offset(random), offset(random)) * float(w + 1));
+		}
+	}
+
+	// Antes: Catmull-Rom por objeto, com os 4 índices por módulo a cada quadro
+	struct LegacyState
+	{
+		size_t currentWaypoint = 0;
+		float t = 0.0f;
+	};
+	std::vector<LegacyState> legacy(count);
+	auto legacyUpdate = [&]()
+		{
+			const std::vector<WaypointPath>& paths = scene.getPaths().getValues();
+			const std::vector<Entity>& entities = scene.getPaths().getEntities();
+			for (size_t i = 0; i < paths.size(); ++i)
+			{
+				const std::vector<glm::vec3>& waypoints = paths[i].waypoints;
+				LegacyState& state = legacy[i];
+				state.t += paths[i].speed;
+				if (state.t >= 1.0f)
+				{
+					state.t = 0.0f;
+					state.currentWaypoint = (state.currentWaypoint + 1) % waypoints.size();
+				}
+				size_t n = waypoints.size();
+				scene.getTransform(entities[i]).setPosition(catmullRom(
+					waypoints[(state.currentWaypoint - 1 + n) % n],
+					waypoints[state.currentWaypoint],
+					waypoints[(state.currentWaypoint + 1) % n],
+					waypoints[(state.currentWaypoint + 2) % n],
+					state.t));
+			}
+		};
+	auto start = std::chrono::steady_clock::now();
+	for (size_t frame = 0; frame < FRAMES; ++frame)
+	{
+		legacyUpdate();
+	}
+	double legacyMilliseconds = millisecondsSince(start) / FRAMES;
+
+	PathSystem system;
+	start = std::chrono::steady_clock::now();
+	system.update(scene);
+	double buildMilliseconds = millisecondsSince(start);
+
+	// Mesmo avanço por comprimento de arco, um caminho por vez: pela busca
+	// binária do locate e pelo cursor
+	start = std::chrono::steady_clock::now();
+	for (size_t frame = 0; frame < FRAMES; ++frame)
+	{
+		++system.m_step;
+		for (size_t i = 0; i < system.m_entities.size(); ++i)
+		{
+			scene.getTransform(system.m_entities[i]).setPosition(system.advance(i));
+		}
+	}
+	double searchMilliseconds = millisecondsSince(start) / FRAMES;
+
+	start = std::chrono::steady_clock::now();
+	for (size_t frame = 0; frame < FRAMES; ++frame)
+	{
+		++system.m_step;
+		for (size_t i = 0; i < system.m_entities.size(); ++i)
+		{
+			scene.getTransform(system.m_entities[i]).setPosition(system.follow(i));
+		}
+	}
+	double cursorMilliseconds = millisecondsSince(start) / FRAMES;
+
+	system.setUseJobs(false);
+	start = std::chrono::steady_clock::now();
+	for (size_t frame = 0; frame < FRAMES; ++frame)
+	{
+		system.update(scene);
+		system.interpolate(scene, 1.0f);
+	}
+	double singleMilliseconds = millisecondsSince(start) / FRAMES;
+
+	system.setUseJobs(true);
+	start = std::chrono::steady_clock::now();
+	for (size_t frame = 0; frame < FRAMES; ++frame)
+	{
+		system.update(scene);
+		system.interpolate(scene, 1.0f);
+	}
+	double threadedMilliseconds = millisecondsSince(start) / FRAMES;
+	unsigned jobCount = system.getStats().jobs;
+
+	// Uniformidade da velocidade numa amostra dos caminhos, ao longo de várias voltas
+	std::vector<std::vector<glm::vec3>> legacyTracks(TRACKED), arcTracks(TRACKED);
+	std::fill(legacy.begin(), legacy.end(), LegacyState());
+	for (size_t frame = 0; frame < TRACK_FRAMES; ++frame)
+	{
+		legacyUpdate();
+		for (size_t i = 0; i < TRACKED; ++i)
+		{
+			legacyTracks[i].push_back(scene.getTransform(scene.getPaths().getEntities()[i]).position);
+		}
+	}
+	for (size_t frame = 0; frame < TRACK_FRAMES; ++frame)
+	{
+		system.update(scene);
+		system.interpolate(scene, 1.0f);
+		for (size_t i = 0; i < TRACKED; ++i)
+		{
+			arcTracks[i].push_back(scene.getTransform(scene.getPaths().getEntities()[i]).position);
+		}
+	}
+
+	std::cout << "Paths: " << count << " (" << WAYPOINTS << " waypoints each), per object uniform t: " << legacyMilliseconds << " ms"
+		<< ", arc length scalar (binary search): " << searchMilliseconds << " ms"
+		<< ", scalar cursor: " << cursorMilliseconds << " ms"
+		<< ", batched 1 thread: " << singleMilliseconds << " ms"
+		<< ", batched " << jobCount << " jobs on " << JobSystem::get().getThreadCount() << " threads: " << threadedMilliseconds << " ms"
+		<< ", build: " << buildMilliseconds << " ms" << std::endl;
+	std::cout << "Step length variation (stddev / mean): uniform t " << stepVariation(legacyTracks) * 100.0f
+		<< "%, arc length " << stepVariation(arcTracks) * 100.0f << "%" << std::endl;
+}
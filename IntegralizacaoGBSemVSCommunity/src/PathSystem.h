@@ -0,0 +1,135 @@
+#pragma once
+#include "Scene.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+// Avança as entidades que têm WaypointPath pela Catmull-Rom dos seus
+// waypoints. Quando os caminhos mudam, todos são compilados de uma vez num
+// array contíguo de segmentos com os coeficientes da cúbica já calculados
+// (a*t³ + b*t² + c*t + d) e a tabela de comprimento acumulado de cada um, e
+// o estado de cada caminho fica em arrays separados. A velocidade é
+// constante pelo comprimento de arco, em forma fechada: a distância sai do
+// número de passos desde a compilação, o segmento e o t saem da tabela e a
+// posição sai por Horner. É a mesma conta do compute shader do GpuPaths
+// (Timing, distanceAt, sampleT), então a CPU e a GPU põem os objetos no
+// mesmo lugar.
+//
+// Cada caminho guarda um cursor (segmento e amostra da tabela em que está,
+// com os limites dela). Como a distância só anda para frente, quase todo
+// passo cai no mesmo intervalo: a distância, o teste do cursor, o t e o
+// Horner rodam 4 caminhos por vez com SSE, e só as lanes que saíram do
+// intervalo andam o cursor para frente (ou voltam ao início na volta
+// completa). Os caminhos são divididos em blocos no JobSystem.
+//
+// O progresso volta para o WaypointPath (segmento e t) quando os caminhos
+// são recompilados. update() é um passo da simulação e guarda a posição de
+// antes e a de depois; interpolate() escreve no Transform o ponto entre as
+// duas que vai ser desenhado.
+class PathSystem
+{
+public:
+	// Amostras por segmento para medir o comprimento dos caminhos
+	static constexpr unsigned LENGTH_SAMPLES = 16;
+	// Caminhos por job (múltiplo de 4); abaixo disso não compensa dividir
+	static constexpr size_t PATHS_PER_JOB = 16384;
+
+	struct Stats
+	{
+		unsigned paths = 0;
+		unsigned segments = 0;
+		unsigned jobs = 0;
+		unsigned rebuilds = 0;
+		double updateMilliseconds = 0.0;
+	};
+
+	// Coeficientes de um segmento, 12 floats seguidos
+	struct Segment
+	{
+		glm::vec3 a, b, c, d;
+	};
+
+	// Avanço de um caminho em forma fechada (o fim do PathData do GpuPaths)
+	struct Timing
+	{
+		uint32_t startStep;    // passo em que o caminho estava em startDistance
+		float length;          // uma volta
+		float step;            // distância por passo
+		float stepsPerLap;
+		float startDistance;
+	};
+
+	static glm::vec3 catmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float t);
+	// Segmento k do caminho fechado (de waypoints[k] a waypoints[k + 1])
+	static Segment makeSegment(const std::vector<glm::vec3>& waypoints, size_t k);
+	// Comprimento acumulado até cada amostra t = 1/N, ..., 1; devolve o do segmento
+	static float sampleLengths(const Segment& segment, float lengths[LENGTH_SAMPLES]);
+	static Timing makeTiming(float length, float step, uint32_t startStep, float startDistance);
+	// Distância desde o início do caminho no passo step + offset (offset em [-1, 0])
+	static float distanceAt(const Timing& timing, uint32_t step, float offset);
+	// t para a distância local desde o início do segmento, pela tabela do
+	// sampleLengths, e o inverso
+	static float sampleT(const float lengths[LENGTH_SAMPLES], float local);
+	static float sampleDistance(const float lengths[LENGTH_SAMPLES], float t);
+
+	// Um passo fixo da simulação
+	void update(Scene& scene);
+	// Posição desenhada: alpha 0 é a do passo anterior, 1 a do último
+	void interpolate(Scene& scene, float alpha);
+	// Grava o segmento e o t vivos nos WaypointPath
+	void saveProgress(Scene& scene) const;
+	// Esquece o estado vivo: o próximo update recompila a partir dos WaypointPath
+	void reload();
+
+	// false roda tudo na thread que chama update()
+	void setUseJobs(bool useJobs) { m_useJobs = useJobs; }
+
+	// Catmull-Rom por objeto (como antes) x segmentos em lote, em count
+	// caminhos aleatórios (--benchmark-paths N)
+	static void benchmark(size_t count);
+
+	const Stats& getStats() const { return m_stats; }
+private:
+	// Caminhos avaliados juntos: as posições ficam num array na pilha
+	static constexpr size_t BLOCK = 64;
+
+	void build(Scene& scene);
+	void updateRange(size_t begin, size_t end);
+	Timing timingOf(size_t path) const;
+	// Segmento (índice absoluto em m_segments) e t de um caminho no passo
+	// atual por busca binária, sem o cursor
+	void locate(size_t path, uint32_t& segment, float& t) const;
+	// Posição de um caminho no passo atual pelo locate (referência do benchmark)
+	glm::vec3 advance(size_t path) const;
+	// Anda o cursor até o segmento e a amostra que contêm distance
+	void seek(size_t path, float distance);
+	// Posição escalar de um caminho no passo atual pelo cursor (sobras do lote)
+	glm::vec3 follow(size_t path);
+
+	// Um segmento a mais no fim: a leitura de 4 floats do último d passa dele
+	std::vector<Segment> m_segments;
+	std::vector<float> m_segmentStarts;         // distância do início do caminho ao do segmento
+	std::vector<float> m_segmentLengths;        // LENGTH_SAMPLES por segmento
+	// Por caminho, em SoA
+	std::vector<Entity> m_entities;
+	std::vector<uint32_t> m_firstSegments;
+	std::vector<uint32_t> m_segmentCounts;
+	// Timing de cada caminho, campo a campo
+	std::vector<uint32_t> m_startSteps;
+	std::vector<float> m_lapLengths;
+	std::vector<float> m_stepLengths;
+	std::vector<float> m_stepsPerLap;
+	std::vector<float> m_startDistances;
+	// Cursor: o segmento vale para distâncias em [start, end) e a amostra
+	// para distâncias locais em (low, high]; span é o comprimento da amostra
+	std::vector<uint32_t> m_cursorSegments;
+	std::vector<float> m_cursorSamples;
+	std::vector<float> m_cursorStarts, m_cursorEnds;
+	std::vector<float> m_cursorLows, m_cursorHighs, m_cursorSpans;
+	std::vector<glm::vec3> m_positions;
+	std::vector<glm::vec3> m_previousPositions;
+	uint32_t m_step = 0;
+	uint64_t m_builtVersion = 0;
+	bool m_useJobs = true;
+	Stats m_stats;
+};
@@ -0,0 +1,102 @@
+#include "RenderQueue.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+template <typename T>
+uint32_t RenderQueue::intern(std::unordered_map<T, uint32_t>& ids, T value, int bits)
+{
+	auto it = ids.find(value);
+	if (it != ids.end())
+	{
+		return it->second;
+	}
+	uint32_t id = std::min(static_cast<uint32_t>(ids.size()), (1u << bits) - 1);
+	ids.emplace(value, id);
+	return id;
+}
+
+uint32_t RenderQueue::quantizeDepth(float viewDepth)
+{
+	// Atrás da câmera (ou NaN) conta como 0; para floats positivos a ordem dos
+	// bits é a ordem dos valores, e os 24 bits altos guardam expoente + 15 de mantissa
+	float depth = viewDepth > 0.0f ? viewDepth : 0.0f;
+	uint32_t bits;
+	std::memcpy(&bits, &depth, sizeof(bits));
+	return bits >> (32 - DEPTH_BITS);
+}
+
+void RenderQueue::clear()
+{
+	m_keys.clear();
+	m_indices.clear();
+	// Malhas e texturas vêm e vão; os ids são refeitos antes de saturarem
+	if (m_meshIds.size() >= (1u << MESH_BITS) / 2)
+	{
+		m_meshIds.clear();
+	}
+	if (m_textureIds.size() >= (1u << TEXTURE_BITS) / 2)
+	{
+		m_textureIds.clear();
+	}
+}
+
+void RenderQueue::push(GLuint program, GLuint textureID, const GpuMesh* mesh, float viewDepth, uint32_t index)
+{
+	uint64_t key = static_cast<uint64_t>(intern(m_programIds, program, PROGRAM_BITS)) << (TEXTURE_BITS + MESH_BITS + DEPTH_BITS);
+	key |= static_cast<uint64_t>(intern(m_textureIds, textureID, TEXTURE_BITS)) << (MESH_BITS + DEPTH_BITS);
+	key |= static_cast<uint64_t>(intern(m_meshIds, mesh, MESH_BITS)) << DEPTH_BITS;
+	key |= quantizeDepth(viewDepth);
+	m_keys.push_back(key);
+	m_indices.push_back(index);
+}
+
+const std::vector<uint32_t>& RenderQueue::sort()
+{
+	auto start = std::chrono::steady_clock::now();
+	size_t count = m_keys.size();
+	m_stats.packets = static_cast<unsigned>(count);
+	m_stats.sortPasses = 0;
+
+	// Os 8 histogramas numa única varredura
+	uint32_t histograms[8][256] = {};
+	for (uint64_t key : m_keys)
+	{
+		for (int pass = 0; pass < 8; ++pass)
+		{
+			histograms[pass][(key >> (pass * 8)) & 0xFF]++;
+		}
+	}
+
+	m_keyScratch.resize(count);
+	m_indexScratch.resize(count);
+	for (int pass = 0; pass < 8; ++pass)
+	{
+		uint32_t* histogram = histograms[pass];
+		// Byte igual em todas as chaves: a passada não mudaria nada
+		if (count == 0 || histogram[(m_keys[0] >> (pass * 8)) & 0xFF] == count)
+		{
+			continue;
+		}
+
+		uint32_t offset = 0;
+		for (int digit = 0; digit < 256; ++digit)
+		{
+			uint32_t digitCount = histogram[digit];
+			histogram[digit] = offset;
+			offset += digitCount;
+		}
+		for (size_t i = 0; i < count; ++i)
+		{
+			uint32_t destination = histogram[(m_keys[i] >> (pass * 8)) & 0xFF]++;
+			m_keyScratch[destination] = m_keys[i];
+			m_indexScratch[destination] = m_indices[i];
+		}
+		m_keys.swap(m_keyScratch);
+		m_indices.swap(m_indexScratch);
+		m_stats.sortPasses++;
+	}
+
+	m_stats.sortMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return m_indices;
+}
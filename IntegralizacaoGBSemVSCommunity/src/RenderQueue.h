@@ -0,0 +1,62 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct GpuMesh;
+
+// Fila de pacotes de desenho do quadro. Cada pacote vira uma chave de 64 bits
+// com o estado mais caro de trocar nos bits mais altos:
+//
+//   63..56 programa | 55..40 textura | 39..24 malha (faixa no VAO) | 23..0 profundidade
+//
+// Programa, textura e malha são trocados por ids densos (na ordem em que
+// aparecem) para caberem nos campos. A profundidade é a de view space,
+// quantizada pelos bits do float (monotônicos para valores positivos), então
+// dentro do mesmo estado os pacotes saem da frente para trás. A ordenação é
+// um radix sort LSD de 8 bits por passada, que pula as passadas em que todas
+// as chaves têm o mesmo byte.
+//
+// O material não entra na chave: aqui ele é um índice por instância no SSBO
+// de materiais, não uma troca de estado.
+class RenderQueue
+{
+public:
+	static constexpr int PROGRAM_BITS = 8;
+	static constexpr int TEXTURE_BITS = 16;
+	static constexpr int MESH_BITS = 16;
+	static constexpr int DEPTH_BITS = 24;
+
+	struct Stats
+	{
+		unsigned packets = 0;
+		unsigned sortPasses = 0;
+		double sortMilliseconds = 0.0;
+	};
+
+	void clear();
+	// index é o do pacote no vetor de quem chama; sort() devolve esses índices
+	void push(GLuint program, GLuint textureID, const GpuMesh* mesh, float viewDepth, uint32_t index);
+	const std::vector<uint32_t>& sort();
+
+	size_t size() const { return m_keys.size(); }
+	const Stats& getStats() const { return m_stats; }
+private:
+	// Id denso de um recurso; quando o campo enche, os ids passam a colidir,
+	// o que só piora o agrupamento (quem desenha compara os recursos de fato)
+	template <typename T>
+	static uint32_t intern(std::unordered_map<T, uint32_t>& ids, T value, int bits);
+	static uint32_t quantizeDepth(float viewDepth);
+
+	std::unordered_map<GLuint, uint32_t> m_programIds;
+	std::unordered_map<GLuint, uint32_t> m_textureIds;
+	std::unordered_map<const GpuMesh*, uint32_t> m_meshIds;
+
+	std::vector<uint64_t> m_keys;
+	std::vector<uint32_t> m_indices;
+	std::vector<uint64_t> m_keyScratch;
+	std::vector<uint32_t> m_indexScratch;
+	Stats m_stats;
+};
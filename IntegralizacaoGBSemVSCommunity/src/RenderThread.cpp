@@ -0,0 +1,164 @@
+#include "RenderThread.h"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+	double millisecondsBetween(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+	{
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+}
+
+RenderThread::RenderThread()
+{
+	for (uint8_t slot = 0; slot < MAX_PIPELINE_DEPTH; ++slot)
+	{
+		m_free.push(slot);
+	}
+}
+
+void RenderThread::start(GLFWwindow* window, std::function<void(const RenderSnapshot&)> render)
+{
+	m_window = window;
+	m_render = std::move(render);
+	m_running.store(true, std::memory_order_release);
+	m_thread = std::thread(&RenderThread::run, this);
+}
+
+void RenderThread::stop()
+{
+	m_running.store(false, std::memory_order_release);
+	if (m_thread.joinable())
+	{
+		m_thread.join();
+	}
+}
+
+void RenderThread::setPipelineDepth(unsigned depth)
+{
+	m_depth = std::clamp(depth, 1u, MAX_PIPELINE_DEPTH);
+}
+
+bool RenderThread::canBegin() const
+{
+	return m_frame - m_presented.load(std::memory_order_acquire) < m_depth;
+}
+
+bool RenderThread::getFirstPresentTime(std::chrono::steady_clock::time_point& time) const
+{
+	if (m_presented.load(std::memory_order_acquire) == 0)
+	{
+		return false;
+	}
+	time = m_firstPresentTime;
+	return true;
+}
+
+RenderSnapshot& RenderThread::getSnapshot()
+{
+	if (m_writeSlot < 0)
+	{
+		// Com canBegin() verdadeiro sempre há um livre; ele pode só estar a
+		// caminho se o desenho acabou de soltá-lo
+		uint8_t slot;
+		while (!m_free.pop(slot))
+		{
+			std::this_thread::yield();
+		}
+		m_writeSlot = slot;
+	}
+	return m_snapshots[m_writeSlot];
+}
+
+void RenderThread::publish(const Scene& scene, const std::vector<uint32_t>& changed)
+{
+	m_frame++;
+	m_changeLog.push_back(changed);
+	if (m_changeLog.size() > CHANGE_LOG_FRAMES)
+	{
+		m_changeLog.pop_front();
+	}
+
+	// Quadros que faltam neste snapshot: se passam do que está no registro
+	// (ou as entidades ou as malhas mudaram), vai a cena inteira
+	RenderSnapshot& snapshot = getSnapshot();
+	uint64_t missing = m_frame - snapshot.frame;
+	m_publishStats.fullCopy = snapshot.frame == 0 || missing > m_changeLog.size() || snapshot.scene.size() != scene.size()
+		|| snapshot.scene.getRenderableVersion() != scene.getRenderableVersion();
+	m_publishStats.copiedModels = 0;
+	if (m_publishStats.fullCopy)
+	{
+		snapshot.scene = scene;
+		m_publishStats.copiedModels = static_cast<unsigned>(scene.size());
+	}
+	else
+	{
+		const std::vector<glm::mat4>& models = scene.getModels();
+		std::vector<glm::mat4>& target = snapshot.scene.getModels();
+		for (size_t k = m_changeLog.size() - static_cast<size_t>(missing); k < m_changeLog.size(); ++k)
+		{
+			for (uint32_t entity : m_changeLog[k])
+			{
+				target[entity] = models[entity];
+			}
+			m_publishStats.copiedModels += static_cast<unsigned>(m_changeLog[k].size());
+		}
+	}
+	snapshot.frame = m_frame;
+	snapshot.pipelineDepth = m_depth;
+	snapshot.publishTime = std::chrono::steady_clock::now();
+
+	m_published.push(static_cast<uint8_t>(m_writeSlot));
+	m_writeSlot = -1;
+	m_publishStats.published++;
+	m_publishStats.inFlight = static_cast<unsigned>(m_frame - m_presented.load(std::memory_order_acquire));
+}
+
+void RenderThread::run()
+{
+	glfwMakeContextCurrent(m_window);
+	auto idleStart = std::chrono::steady_clock::now();
+	while (m_running.load(std::memory_order_acquire))
+	{
+		uint8_t slot;
+		if (!m_published.pop(slot))
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+			continue;
+		}
+
+		const RenderSnapshot& snapshot = m_snapshots[slot];
+		auto start = std::chrono::steady_clock::now();
+		m_stats.idleMilliseconds = millisecondsBetween(idleStart, start);
+		m_render(snapshot);
+		glfwSwapBuffers(m_window);
+		idleStart = std::chrono::steady_clock::now();
+		m_stats.renderMilliseconds = millisecondsBetween(start, idleStart);
+		if (m_stats.rendered++ == 0)
+		{
+			m_firstPresentTime = idleStart;
+		}
+
+		// Latência do quadro em três partes, em média móvel desde que a
+		// profundidade mudou pela última vez
+		if (snapshot.pipelineDepth != m_stats.pipelineDepth)
+		{
+			m_stats.pipelineDepth = snapshot.pipelineDepth;
+			m_stats.measuredFrames = 0;
+		}
+		double n = static_cast<double>(++m_stats.measuredFrames);
+		auto average = [n](double& mean, double value) { mean += (value - mean) / n; };
+		average(m_stats.simulateMilliseconds, millisecondsBetween(snapshot.inputTime, snapshot.publishTime));
+		average(m_stats.queuedMilliseconds, millisecondsBetween(snapshot.publishTime, start));
+		average(m_stats.presentMilliseconds, m_stats.renderMilliseconds);
+		average(m_stats.latencyMilliseconds, millisecondsBetween(snapshot.inputTime, idleStart));
+
+		// Devolve o snapshot antes de contar o quadro: quem vê a contagem
+		// subir já encontra o índice na fila dos livres
+		m_free.push(slot);
+		m_presented.fetch_add(1, std::memory_order_release);
+	}
+	glfwMakeContextCurrent(nullptr);
+}
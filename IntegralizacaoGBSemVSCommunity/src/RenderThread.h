@@ -0,0 +1,147 @@
+#pragma once
+#include "Camera.h"
+#include "GpuPaths.h"
+#include "IndirectRenderer.h"
+#include "Light.h"
+#include "Scene.h"
+#include "SpscQueue.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+struct GLFWwindow;
+
+// Tudo o que o desenho de um quadro lê, montado pelo loop principal. Depois
+// de publicado ninguém escreve nele até o desenho trocá-lo por outro.
+struct RenderSnapshot
+{
+	uint64_t frame = 0;
+	// Renderable e matrizes model de cada entidade (o desenho não lê Transform
+	// nem caminhos). É copiada inteira só quando o número de entidades muda;
+	// fora isso recebe só as matrizes que mudaram desde que foi escrita
+	Scene scene;
+	Camera camera = Camera(glm::vec3(0.0f));
+	int width = 0;
+	int height = 0;
+	// Trocada (nunca editada) quando as luzes mudam
+	std::shared_ptr<const std::vector<Light>> lights;
+	IndirectRenderer::Mode renderMode = IndirectRenderer::Mode::MultiDrawIndirect;
+	// Entidades a desenhar, já passadas pelo culling da CPU; com gpuCulling
+	// fica vazia e o GpuCuller decide tudo
+	std::vector<uint32_t> visible;
+	bool gpuCulling = false;
+	// Caminhos avaliados na GPU (só com gpuCulling; nulo quando andam na CPU)
+	std::shared_ptr<const GpuPaths::Tables> pathTables;
+	uint64_t simulationStep = 0;
+	float alpha = 0.0f;
+	// Muda a cada P: o desenho imprime as estatísticas do lado dele
+	uint64_t statsRequest = 0;
+	// Quando os eventos deste quadro foram lidos e quando ele foi publicado;
+	// o desenho mede a partir deles a latência até a tela
+	std::chrono::steady_clock::time_point inputTime;
+	std::chrono::steady_clock::time_point publishTime;
+	unsigned pipelineDepth = 0;
+};
+
+// Thread dona do contexto GL depois do carregamento. O loop principal trata
+// os eventos do GLFW, roda a simulação e o culling da CPU e publica um
+// RenderSnapshot por quadro; esta thread desenha os publicados em ordem e
+// troca os buffers da janela. Os snapshots giram num anel: os publicados
+// vão por uma SpscQueue para o desenho e voltam por outra quando a troca de
+// buffers termina, sem trava dos dois lados.
+//
+// A profundidade do pipeline é quantos quadros podem estar em andamento ao
+// mesmo tempo, contando o que está sendo simulado. Com 1 o loop principal só
+// começa um quadro depois que o anterior chegou à tela; com 2 simula o
+// próximo enquanto o atual é desenhado; com 3 pode ter ainda um pronto
+// esperando. Cada quadro a mais esconde mais variação do desenho, ao custo
+// de um quadro a mais entre a leitura dos eventos e a tela.
+//
+// Os snapshots são reaproveitados: publish() lembra as entidades recompostas
+// nos últimos CHANGE_LOG_FRAMES quadros e copia para o snapshot livre só as
+// matrizes que mudaram desde a última vez que ele foi escrito. Se algum
+// Renderable mudou (as trocas do streaming), a cena vai inteira.
+class RenderThread
+{
+public:
+	static const size_t CHANGE_LOG_FRAMES = 8;
+	static const unsigned MAX_PIPELINE_DEPTH = 3;
+
+	// Lado do loop principal
+	struct PublishStats
+	{
+		uint64_t published = 0;
+		unsigned inFlight = 0;      // publicados e ainda não na tela, no último publish
+		unsigned copiedModels = 0;  // no último publish
+		bool fullCopy = false;
+	};
+
+	// Lado da thread de desenho
+	struct Stats
+	{
+		uint64_t rendered = 0;
+		double renderMilliseconds = 0.0;   // último quadro, com a troca de buffers
+		double idleMilliseconds = 0.0;     // esperando um snapshot novo antes dele
+		// Médias desde a última troca de profundidade do pipeline
+		unsigned pipelineDepth = 0;
+		uint64_t measuredFrames = 0;
+		double simulateMilliseconds = 0.0;  // eventos lidos até a publicação
+		double queuedMilliseconds = 0.0;    // publicado até começar a ser desenhado
+		double presentMilliseconds = 0.0;   // desenho e troca de buffers
+		double latencyMilliseconds = 0.0;   // eventos lidos até a troca terminar (a soma)
+	};
+
+	RenderThread();
+
+	// O contexto da janela precisa estar solto (glfwMakeContextCurrent(nullptr));
+	// render é chamada na thread de desenho, uma vez por snapshot novo
+	void start(GLFWwindow* window, std::function<void(const RenderSnapshot&)> render);
+	// Termina o quadro em andamento, solta o contexto e espera a thread
+	void stop();
+
+	// Entre 1 e MAX_PIPELINE_DEPTH; vale a partir do próximo quadro
+	void setPipelineDepth(unsigned depth);
+	unsigned getPipelineDepth() const { return m_depth; }
+	// true se cabe mais um quadro no pipeline; só então getSnapshot() pode ser chamado
+	bool canBegin() const;
+	// Quando a troca de buffers do primeiro quadro terminou; false enquanto
+	// nenhum chegou à tela
+	bool getFirstPresentTime(std::chrono::steady_clock::time_point& time) const;
+
+	// Snapshot livre para o loop principal preencher; publish() copia as
+	// matrizes model (changed: as entidades recompostas neste quadro) e o entrega
+	RenderSnapshot& getSnapshot();
+	void publish(const Scene& scene, const std::vector<uint32_t>& changed);
+
+	// Cada um só pode ser lido na thread que o escreve
+	const PublishStats& getPublishStats() const { return m_publishStats; }
+	const Stats& getStats() const { return m_stats; }
+private:
+	void run();
+
+	RenderSnapshot m_snapshots[MAX_PIPELINE_DEPTH];
+	// Índices dos snapshots: publicados (para o desenho) e livres (de volta)
+	SpscQueue<uint8_t, 4> m_published;
+	SpscQueue<uint8_t, 4> m_free;
+	int m_writeSlot = -1;
+	unsigned m_depth = 2;
+	// Quadros que já chegaram à tela (escrito pelo desenho)
+	std::atomic<uint64_t> m_presented{ 0 };
+	// Escrito pelo desenho antes de m_presented passar de 0
+	std::chrono::steady_clock::time_point m_firstPresentTime;
+
+	GLFWwindow* m_window = nullptr;
+	std::function<void(const RenderSnapshot&)> m_render;
+	std::thread m_thread;
+	std::atomic<bool> m_running{ false };
+
+	uint64_t m_frame = 0;
+	std::deque<std::vector<uint32_t>> m_changeLog;
+	PublishStats m_publishStats;
+	Stats m_stats;
+};
@@ -0,0 +1,219 @@
+#include "Scene.h"
+#include "IndirectRenderer.h"
+#include "PathSystem.h"
+#include "TransformSystem.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <iostream>
+#include <random>
+
+namespace
+{
+	double millisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// O Object de antes: transformação, caminho, malha e estado de input
+	// juntos, num array de objetos
+	struct LegacyObject
+	{
+		size_t currentWaypoint = 0;
+		float t = 0.0f;
+		float speed = 0.01f;
+		bool addWaypointKeyPressed = false;
+		glm::vec3 position = glm::vec3(0.0f);
+		glm::vec3 scale = glm::vec3(1.0f);
+		glm::vec3 rotateAngle = glm::vec3(0.0f);
+		glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+		glm::mat4 model = glm::mat4(1.0f);
+		bool dirty = true;
+		glm::vec3 velocity = glm::vec3(0.0f);
+		std::vector<glm::vec3> waypoints;
+		std::shared_ptr<GpuMesh> mesh;
+		GLuint materialIndex = 0;
+	};
+}
+
+void Transform::setRotateAngle(const glm::vec3& angle)
+{
+	rotateAngle = angle;
+	rotation = TransformSystem::eulerToQuat(angle);
+	dirty = true;
+}
+
+Entity Scene::createEntity()
+{
+	m_transforms.emplace_back();
+	m_models.emplace_back(1.0f);
+	m_renderables.emplace_back();
+	return static_cast<Entity>(m_transforms.size() - 1);
+}
+
+void Scene::addWaypoint(Entity entity, const glm::vec3& waypoint)
+{
+	WaypointPath* path = m_paths.find(entity);
+	if (!path)
+	{
+		path = &m_paths.add(entity);
+	}
+	path->waypoints.push_back(waypoint);
+	m_pathVersion++;
+}
+
+void Scene::clearWaypoints(Entity entity)
+{
+	if (m_paths.has(entity))
+	{
+		m_paths.remove(entity);
+		m_pathVersion++;
+	}
+}
+
+void Scene::setRenderable(Entity entity, const Renderable& renderable)
+{
+	m_renderables[entity] = renderable;
+	m_renderableVersion++;
+}
+
+void Scene::select(Entity entity)
+{
+	Entity previous = getSelected();
+	if (previous == entity)
+	{
+		return;
+	}
+	m_selection.remove(previous);
+	if (entity < size())
+	{
+		m_selection.add(entity);
+	}
+}
+
+void Scene::benchmark(size_t count)
+{
+	const size_t FRAMES = 20;
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f), angle(-3.14159f, 3.14159f);
+	std::vector<std::shared_ptr<GpuMesh>> meshes(8);
+	for (size_t i = 0; i < meshes.size(); ++i)
+	{
+		meshes[i] = std::make_shared<GpuMesh>();
+		meshes[i]->boundsCenter = glm::vec3(0.0f, float(i) * 0.1f, 0.0f);
+		meshes[i]->materialIndex = static_cast<GLuint>(i);
+	}
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 150.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	// Mesma cena nos dois lados: 1 em cada 10 entidades segue um caminho de 4 waypoints
+	std::vector<LegacyObject> objects(count);
+	Scene scene;
+	for (size_t i = 0; i < count; ++i)
+	{
+		glm::vec3 origin(position(random), position(random), position(random));
+		glm::vec3 rotateAngle(angle(random), angle(random), angle(random));
+		Entity entity = scene.createEntity();
+		Transform& transform = scene.getTransform(entity);
+		transform.setPosition(origin);
+		transform.setRotateAngle(rotateAngle);
+		scene.getRenderable(entity).mesh = meshes[i % meshes.size()];
+		scene.getRenderable(entity).materialIndex = meshes[i % meshes.size()]->materialIndex;
+
+		LegacyObject& object = objects[i];
+		object.position = origin;
+		object.rotateAngle = rotateAngle;
+		object.rotation = transform.rotation;
+		object.mesh = meshes[i % meshes.size()];
+		object.materialIndex = object.mesh->materialIndex;
+		if (i % 10 == 0)
+		{
+			for (int w = 0; w < 4; ++w)
+			{
+				glm::vec3 waypoint = origin + glm::vec3(float(w & 1), float(w >> 1), 0.0f) * 5.0f;
+				object.waypoints.push_back(waypoint);
+				scene.addWaypoint(entity, waypoint);
+			}
+		}
+	}
+	std::vector<InstanceData> instances(count);
+	std::vector<float> depths(count);
+
+	// Antes: cada quadro visita todos os objetos para atualizar, recompor e preparar o desenho
+	double legacyUpdate = 0.0, legacyPrepare = 0.0;
+	for (size_t frame = 0; frame < FRAMES; ++frame)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (LegacyObject& object : objects)
+		{
+			if (object.waypoints.empty())
+			{
+				continue;
+			}
+			object.t += object.speed;
+			if (object.t >= 1.0f)
+			{
+				object.t = 0.0f;
+				object.currentWaypoint = (object.currentWaypoint + 1) % object.waypoints.size();
+			}
+			size_t waypoints = object.waypoints.size();
+			object.position = PathSystem::catmullRom(
+				object.waypoints[(object.currentWaypoint - 1 + waypoints) % waypoints],
+				object.waypoints[object.currentWaypoint],
+				object.waypoints[(object.currentWaypoint + 1) % waypoints],
+				object.waypoints[(object.currentWaypoint + 2) % waypoints],
+				object.t);
+			object.dirty = true;
+		}
+		for (LegacyObject& object : objects)
+		{
+			if (object.dirty)
+			{
+				object.model = TransformSystem::compose(object.position, object.rotation, object.scale);
+				object.dirty = false;
+			}
+		}
+		legacyUpdate += millisecondsSince(start);
+
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < objects.size(); ++i)
+		{
+			const LegacyObject& object = objects[i];
+			glm::vec4 center = object.model * glm::vec4(object.mesh->boundsCenter, 1.0f);
+			depths[i] = -(view * center).z;
+			instances[i].model = object.model;
+			instances[i].materialIndex = object.materialIndex;
+		}
+		legacyPrepare += millisecondsSince(start);
+	}
+
+	// Agora: cada sistema percorre só os arrays densos que usa
+	PathSystem pathSystem;
+	TransformSystem transformSystem;
+	transformSystem.update(scene.getTransforms(), scene.getModels());
+	double sceneUpdate = 0.0, scenePrepare = 0.0;
+	for (size_t frame = 0; frame < FRAMES; ++frame)
+	{
+		auto start = std::chrono::steady_clock::now();
+		pathSystem.update(scene);
+		pathSystem.interpolate(scene, 1.0f);
+		transformSystem.update(scene.getTransforms(), scene.getModels());
+		sceneUpdate += millisecondsSince(start);
+
+		start = std::chrono::steady_clock::now();
+		const std::vector<glm::mat4>& models = scene.getModels();
+		const std::vector<Renderable>& renderables = scene.getRenderables();
+		for (size_t i = 0; i < models.size(); ++i)
+		{
+			glm::vec4 center = models[i] * glm::vec4(renderables[i].mesh->boundsCenter, 1.0f);
+			depths[i] = -(view * center).z;
+			instances[i].model = models[i];
+			instances[i].materialIndex = renderables[i].materialIndex;
+		}
+		scenePrepare += millisecondsSince(start);
+	}
+
+	std::cout << "Entities: " << count << " (" << scene.getPaths().size() << " moving), per frame over " << FRAMES << " frames" << std::endl;
+	std::cout << "Object array (" << sizeof(LegacyObject) << " bytes each): update " << legacyUpdate / FRAMES
+		<< " ms, draw prep " << legacyPrepare / FRAMES << " ms" << std::endl;
+	std::cout << "Components (" << sizeof(Transform) << " + " << sizeof(glm::mat4) << " + " << sizeof(Renderable) << " bytes): update " << sceneUpdate / FRAMES
+		<< " ms, draw prep " << scenePrepare / FRAMES << " ms" << std::endl;
+}
@@ -0,0 +1,161 @@
+#pragma once
+#include "AssetRegistry.h"
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Uma entidade é só um índice; os dados ficam em arrays densos por componente
+using Entity = uint32_t;
+const Entity NULL_ENTITY = UINT32_MAX;
+
+// Posição, escala e rotação locais. Os setters ligam dirty; o TransformSystem
+// recompõe a matriz model dos sujos uma vez por quadro, num array separado
+// (quem desenha só lê as matrizes)
+struct Transform
+{
+	glm::vec3 position = glm::vec3(0.0f);
+	glm::vec3 scale = glm::vec3(1.0f);
+	glm::vec3 rotateAngle = glm::vec3(0.0f);
+	glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+	bool dirty = true;
+
+	void setPosition(const glm::vec3& value) { position = value; dirty = true; }
+	void setScale(const glm::vec3& value) { scale = value; dirty = true; }
+	void setRotateAngle(const glm::vec3& angle);
+};
+
+// O material vem da malha, mas fica aqui para poder ser trocado sem afetar
+// as outras instâncias da mesma malha
+struct Renderable
+{
+	std::shared_ptr<GpuMesh> mesh;
+	GLuint materialIndex = 0;
+
+	GLuint getTextureID() const { return mesh && mesh->diffuseTexture ? mesh->diffuseTexture->id : 0; }
+};
+
+// Caminho Catmull-Rom por waypoints (só as entidades que se movem têm)
+struct WaypointPath
+{
+	std::vector<glm::vec3> waypoints;
+	uint32_t currentWaypoint = 0;
+	float t = 0.0f;           // Parâmetro de interpolação entre 0 e 1
+	// Segmentos por quadro, em média: a velocidade ao longo do caminho é
+	// constante, e uma volta leva o mesmo número de quadros de antes
+	float speed = 0.01f;
+};
+
+// Entidade que recebe o input do teclado (no máximo uma)
+struct Selection
+{
+	bool addWaypointKeyPressed = false;
+};
+
+// Componente esparso: array denso dos valores, a entidade dona de cada um e,
+// por entidade, a posição no array denso (-1 quando não tem). Remover troca
+// com o último, então a ordem do array denso não é estável.
+template <typename T>
+class ComponentArray
+{
+public:
+	T& add(Entity entity, const T& value = T())
+	{
+		if (entity >= m_indexOf.size())
+		{
+			m_indexOf.resize(entity + 1, -1);
+		}
+		if (m_indexOf[entity] >= 0)
+		{
+			return m_values[m_indexOf[entity]] = value;
+		}
+		m_indexOf[entity] = static_cast<int32_t>(m_values.size());
+		m_values.push_back(value);
+		m_entities.push_back(entity);
+		return m_values.back();
+	}
+
+	void remove(Entity entity)
+	{
+		if (!has(entity))
+		{
+			return;
+		}
+		int32_t index = m_indexOf[entity];
+		m_values[index] = std::move(m_values.back());
+		m_entities[index] = m_entities.back();
+		m_indexOf[m_entities[index]] = index;
+		m_values.pop_back();
+		m_entities.pop_back();
+		m_indexOf[entity] = -1;
+	}
+
+	bool has(Entity entity) const { return entity < m_indexOf.size() && m_indexOf[entity] >= 0; }
+	T* find(Entity entity) { return has(entity) ? &m_values[m_indexOf[entity]] : nullptr; }
+	const T* find(Entity entity) const { return has(entity) ? &m_values[m_indexOf[entity]] : nullptr; }
+
+	size_t size() const { return m_values.size(); }
+	std::vector<T>& getValues() { return m_values; }
+	const std::vector<T>& getValues() const { return m_values; }
+	const std::vector<Entity>& getEntities() const { return m_entities; }
+private:
+	std::vector<T> m_values;
+	std::vector<Entity> m_entities;
+	std::vector<int32_t> m_indexOf;
+};
+
+// Armazenamento das entidades da cena. Toda entidade tem Transform, matriz
+// model e Renderable (arrays densos indexados pela própria entidade); caminho
+// e seleção são esparsos. Os sistemas percorrem só os arrays de que precisam:
+// o TransformSystem os Transform e as matrizes, o PathSystem só os caminhos,
+// e a preparação do desenho só as matrizes + Renderable.
+class Scene
+{
+public:
+	Entity createEntity();
+	size_t size() const { return m_transforms.size(); }
+
+	Transform& getTransform(Entity entity) { return m_transforms[entity]; }
+	const Transform& getTransform(Entity entity) const { return m_transforms[entity]; }
+	const glm::mat4& getModelMatrix(Entity entity) const { return m_models[entity]; }
+	Renderable& getRenderable(Entity entity) { return m_renderables[entity]; }
+	const Renderable& getRenderable(Entity entity) const { return m_renderables[entity]; }
+	const GpuMesh* getMesh(Entity entity) const { return m_renderables[entity].mesh.get(); }
+
+	std::vector<Transform>& getTransforms() { return m_transforms; }
+	const std::vector<Transform>& getTransforms() const { return m_transforms; }
+	std::vector<glm::mat4>& getModels() { return m_models; }
+	const std::vector<glm::mat4>& getModels() const { return m_models; }
+	std::vector<Renderable>& getRenderables() { return m_renderables; }
+	const std::vector<Renderable>& getRenderables() const { return m_renderables; }
+	ComponentArray<WaypointPath>& getPaths() { return m_paths; }
+	const ComponentArray<WaypointPath>& getPaths() const { return m_paths; }
+
+	void addWaypoint(Entity entity, const glm::vec3& waypoint);
+	void clearWaypoints(Entity entity);
+	// Muda a cada waypoint adicionado ou caminho removido (o PathSystem recompila)
+	uint64_t getPathVersion() const { return m_pathVersion; }
+	// Troca a malha/material de uma entidade depois de criada (o RenderThread
+	// copia a cena inteira quando a versão muda)
+	void setRenderable(Entity entity, const Renderable& renderable);
+	uint64_t getRenderableVersion() const { return m_renderableVersion; }
+
+	// A seleção passa de uma entidade para a outra
+	void select(Entity entity);
+	Entity getSelected() const { return m_selection.size() > 0 ? m_selection.getEntities()[0] : NULL_ENTITY; }
+	Selection* getSelection() { return m_selection.size() > 0 ? &m_selection.getValues()[0] : nullptr; }
+
+	// Atualização + preparação do desenho com o Object antigo (quente e frio
+	// juntos num array de objetos) x os componentes (--benchmark-entities N)
+	static void benchmark(size_t count);
+private:
+	std::vector<Transform> m_transforms;
+	std::vector<glm::mat4> m_models;
+	std::vector<Renderable> m_renderables;
+	ComponentArray<WaypointPath> m_paths;
+	ComponentArray<Selection> m_selection;
+	uint64_t m_pathVersion = 1;
+	uint64_t m_renderableVersion = 1;
+};
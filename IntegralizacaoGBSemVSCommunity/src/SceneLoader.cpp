@@ -1,4 +1,6 @@
 #include "SceneLoader.h"
+#include "JobSystem.h"
+#include <algorithm>
 #include <string>
 #include <fstream>
 #include <iostream>
@@ -6,99 +8,146 @@
 #include <vector>
 #include <glm/glm.hpp>
 
-std::vector<Object>& SceneLoader::loadObjects(const std::string& filePath)
+namespace
+{
+    // Um objeto do arquivo de cena: o modelo, rot/trans/scale e os waypoints
+    struct ObjectEntry
+    {
+        std::string path;
+        Transform transform;
+        std::vector<glm::vec3> waypoints;
+        std::string error;
+    };
+
+    // Objetos por job no parsing das entradas
+    const size_t ENTRIES_PER_JOB = 64;
+
+    // Funo auxiliar para ler uma linha no formato: "prefix x, y, z"
+    glm::vec3 parseVec3Line(const std::string& line, const std::string& expectedPrefix)
+    {
+        std::istringstream iss(line);
+        std::string prefix;
+        float x, y, z;
+        char comma1, comma2;
+
+        iss >> prefix >> x >> comma1 >> y >> comma2 >> z;
+
+        if (prefix != expectedPrefix || comma1 != ',' || comma2 != ',')
+        {
+            throw std::runtime_error("Erro ao fazer parsing da linha: " + line);
+        }
+
+        return glm::vec3(x, y, z);
+    }
+}
+
+Scene& SceneLoader::loadObjects(const std::string& filePath)
 {
     std::ifstream file(filePath);
 
     if (!file.is_open())
     {
         std::cerr << "Erro ao abrir o arquivo: " << filePath << std::endl;
-        return m_objects;
+        return m_scene;
     }
 
+    // Separa o arquivo em objetos: o nome do modelo, at trs linhas de
+    // transformao e as linhas seguidas que comeam com "waypoint"
+    std::vector<std::string> lines;
     std::string line;
     while (std::getline(file, line))
     {
-        if (line.empty()) continue;
-
-        Object obj;
-
-        // Nome do modelo
-        std::string completePath = "../assets/Modelos3D/" + line;
-        obj.loadGeometry(completePath.c_str(), shaderID);
-
-        // Funo auxiliar para ler uma linha no formato: "prefix x, y, z"
-        auto parseVec3Line = [](const std::string& line, const std::string& expectedPrefix) -> glm::vec3
-            {
-                std::istringstream iss(line);
-                std::string prefix;
-                float x, y, z;
-                char comma1, comma2;
-
-                iss >> prefix >> x >> comma1 >> y >> comma2 >> z;
-
-                if (prefix != expectedPrefix || comma1 != ',' || comma2 != ',')
-                {
-                    throw std::runtime_error("Erro ao fazer parsing da linha: " + line);
-                }
-
-                return glm::vec3(x, y, z);
-            };
+        lines.push_back(line);
+    }
+    file.close();
 
-        try
+    std::vector<std::pair<size_t, size_t>> ranges;
+    for (size_t i = 0; i < lines.size();)
+    {
+        if (lines[i].empty())
         {
-            // Leitura das transformaes bsicas
-            if (std::getline(file, line))
-            {
-                glm::vec3 rot = parseVec3Line(line, "rot");
-                obj.setRotateAngle(rot);
-            }
-
-            if (std::getline(file, line))
-            {
-                glm::vec3 pos = parseVec3Line(line, "trans");
-                obj.setPosition(pos);
-            }
-
-            if (std::getline(file, line))
-            {
-                glm::vec3 scale = parseVec3Line(line, "scale");
-                obj.setScale(scale);
-            }
+            ++i;
+            continue;
+        }
+        size_t end = std::min(lines.size(), i + 4);
+        while (end < lines.size() && lines[end].rfind("waypoint", 0) == 0)
+        {
+            ++end;
+        }
+        ranges.emplace_back(i, end);
+        i = end;
+    }
 
-            // Leitura dos waypoints (linhas que comeam com "waypoint")
-            while (std::getline(file, line))
+    // O parsing de cada objeto no depende dos outros: vai em jobs
+    std::vector<ObjectEntry> entries(ranges.size());
+    JobSystem& jobs = JobSystem::get();
+    jobs.wait(jobs.parallelFor(ranges.size(), ENTRIES_PER_JOB, [&](size_t begin, size_t end)
+        {
+            for (size_t k = begin; k < end; ++k)
             {
-                if (line.rfind("waypoint", 0) == 0) // Verifica se comea com "waypoint"
+                ObjectEntry& entry = entries[k];
+                size_t first = ranges[k].first, last = ranges[k].second;
+                // Nome do modelo
+                entry.path = "../assets/Modelos3D/" + lines[first];
+                try
                 {
-                    glm::vec3 waypoint = parseVec3Line(line, "waypoint");
-                    obj.addWaypoint(waypoint);
+                    // Leitura das transformaes bsicas
+                    if (first + 1 < last) entry.transform.setRotateAngle(parseVec3Line(lines[first + 1], "rot"));
+                    if (first + 2 < last) entry.transform.setPosition(parseVec3Line(lines[first + 2], "trans"));
+                    if (first + 3 < last) entry.transform.setScale(parseVec3Line(lines[first + 3], "scale"));
+                    for (size_t i = first + 4; i < last; ++i)
+                    {
+                        entry.waypoints.push_back(parseVec3Line(lines[i], "waypoint"));
+                    }
                 }
-                else
+                catch (const std::exception& e)
                 {
-                    // Linha no  waypoint, ento  o incio de outro objeto ou fim
-                    break;
+                    entry.error = e.what();
                 }
             }
+        }));
 
-            // Se lemos uma linha que no era waypoint, ela j faz parte do prximo objeto
-            if (!line.empty())
-            {
-                // Reposiciona o cursor para a linha que foi lida mas no processada
-                file.seekg(-static_cast<int>(line.length()) - 1, std::ios_base::cur);
-            }
+    // Os modelos (OBJ, MTL e PNG) so decodificados em jobs; esta thread,
+    // que  a dona do contexto, envia cada um para a GPU quando fica pronto.
+    // Em streaming ela s recebe os placeholders
+    std::vector<std::string> paths;
+    for (const ObjectEntry& entry : entries)
+    {
+        if (entry.error.empty())
+        {
+            paths.push_back(entry.path);
         }
-        catch (const std::exception& e)
+    }
+    std::vector<std::shared_ptr<GpuMesh>> meshes = m_streaming ? m_assets.streamMeshes(paths) : m_assets.loadMeshes(paths);
+
+    size_t loaded = 0;
+    for (const ObjectEntry& entry : entries)
+    {
+        if (!entry.error.empty())
         {
-            std::cerr << "Erro ao processar objeto " << completePath << ": " << e.what() << std::endl;
+            std::cerr << "Erro ao processar objeto " << entry.path << ": " << entry.error << std::endl;
             continue; // Pula esse objeto e continua com o prximo
         }
 
-        m_objects.push_back(obj);
+        // A entidade s  criada depois que o objeto foi lido inteiro
+        std::shared_ptr<GpuMesh> mesh = meshes[loaded++];
+        Entity entity = m_scene.createEntity();
+        m_scene.getTransform(entity) = entry.transform;
+        Renderable& renderable = m_scene.getRenderable(entity);
+        renderable.mesh = mesh;
+        renderable.materialIndex = mesh ? mesh->materialIndex : 0;
+        for (const glm::vec3& waypoint : entry.waypoints)
+        {
+            m_scene.addWaypoint(entity, waypoint);
+        }
     }
 
-    file.close();
-    return m_objects;
+    if (!m_streaming)
+    {
+        m_assets.printStats();
+        m_assets.printLoadReport();
+    }
+    return m_scene;
 }
 
 std::vector<Light>& SceneLoader::loadLights(const std::string& filePath)
@@ -157,8 +206,22 @@ std::vector<Light>& SceneLoader::loadLights(const std::string& filePath)
                 color = glm::vec3(r, g, b);
             }
 
+            // Alcance opcional na linha seguinte; se no houver, a linha volta para o arquivo
+            float range = DEFAULT_LIGHT_RANGE;
+            std::streampos mark = file.tellg();
+            if (std::getline(file, line) && line.compare(0, 5, "range") == 0) {
+                std::istringstream iss(line.substr(5));
+                if (!(iss >> range) || range <= 0.0f) {
+                    throw std::runtime_error("Erro ao fazer parsing do alcance: " + line);
+                }
+            }
+            else {
+                file.clear();
+                file.seekg(mark);
+            }
+
             // Cria a luz e adiciona na lista
-            Light light(position, color, shaderID, lightNumber);
+            Light light(position, color, range);
             m_lights.push_back(light);
             lightNumber++;
 
@@ -229,7 +292,6 @@ Camera& SceneLoader::loadCamera(const std::string& filePath)
         }
 
         m_camera.setFrustum(fov, aspect, nearPlane, farPlane);
-        m_camera.initCamera(shaderID);
     }
     catch (const std::exception& e)
     {
@@ -1,7 +1,8 @@
 #pragma once
-#include "Object.h"
+#include "Scene.h"
 #include "Light.h"
 #include "Camera.h"
+#include "AssetRegistry.h"
 #include <vector>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
@@ -10,11 +11,17 @@ class SceneLoader
 {
 public:
 	SceneLoader(GLuint shaderID) : shaderID(shaderID), m_camera(glm::vec3(0.0f, 0.0f, 0.0f)) {}
-	std::vector<Object>& loadObjects(const std::string& filePath);
+	Scene& loadObjects(const std::string& filePath);
 	std::vector<Light>& loadLights(const std::string& filePath);
 	Camera& loadCamera(const std::string& filePath);
+	AssetRegistry& getAssets() { return m_assets; }
+	// Com streaming, loadObjects volta sem esperar os modelos: as entidades
+	// começam com caixas e a thread de desenho envia o resto (--stream)
+	void setStreaming(bool enabled) { m_streaming = enabled; }
 private:
-	std::vector<Object> m_objects;
+	AssetRegistry m_assets;
+	bool m_streaming = false;
+	Scene m_scene;
 	std::vector<Light> m_lights;
 	Camera m_camera;
 	GLuint shaderID;
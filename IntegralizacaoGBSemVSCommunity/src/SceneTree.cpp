@@ -0,0 +1,259 @@
+#include "SceneTree.h"
+#include "FrustumCuller.h"
+#include "JobSystem.h"
+#include "Scene.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+	// Objetos por job no cálculo das AABBs em sync()
+	const size_t BOUNDS_PER_JOB = 4096;
+
+	bool touchesFrustum(const Aabb& aabb, const glm::vec4 planes[6])
+	{
+		glm::vec3 center = aabb.getCenter();
+		glm::vec3 extent = aabb.getExtents();
+		for (int i = 0; i < 6; ++i)
+		{
+			float distance = glm::dot(glm::vec3(planes[i]), center) + planes[i].w;
+			if (distance + glm::dot(glm::abs(glm::vec3(planes[i])), extent) < 0.0f)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	double millisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+void SceneTree::sync(const Scene& scene)
+{
+	auto start = std::chrono::steady_clock::now();
+	m_stats.reinserted = 0;
+
+	// Objetos removidos do fim do vetor
+	while (m_proxies.size() > scene.size())
+	{
+		if (m_proxies.back() != DynamicTree::NULL_NODE)
+		{
+			m_tree.destroyProxy(m_proxies.back());
+		}
+		m_proxies.pop_back();
+	}
+	m_bounds.resize(scene.size());
+
+	// As AABBs no mundo saem em paralelo; a árvore só é mexida depois, aqui
+	m_newBounds.resize(scene.size());
+	JobSystem& jobs = JobSystem::get();
+	jobs.wait(jobs.parallelFor(scene.size(), BOUNDS_PER_JOB, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				if (const GpuMesh* mesh = scene.getMesh(static_cast<Entity>(i)))
+				{
+					m_newBounds[i] = Aabb::transform({ mesh->boundsMin, mesh->boundsMax }, scene.getModelMatrix(static_cast<Entity>(i)));
+				}
+			}
+		}));
+
+	for (size_t i = 0; i < scene.size(); ++i)
+	{
+		if (!scene.getMesh(static_cast<Entity>(i)))
+		{
+			continue;
+		}
+		const Aabb& bounds = m_newBounds[i];
+		if (i >= m_proxies.size())
+		{
+			m_proxies.resize(i + 1, DynamicTree::NULL_NODE);
+		}
+		if (m_proxies[i] == DynamicTree::NULL_NODE)
+		{
+			m_proxies[i] = m_tree.createProxy(bounds, static_cast<uint32_t>(i));
+			m_stats.reinserted++;
+		}
+		else if (m_tree.moveProxy(m_proxies[i], bounds, bounds.getCenter() - m_bounds[i].getCenter()))
+		{
+			m_stats.reinserted++;
+		}
+		m_bounds[i] = bounds;
+	}
+
+	m_stats.proxies = static_cast<unsigned>(m_tree.getProxyCount());
+	m_stats.height = m_tree.getHeight();
+	m_stats.syncMilliseconds = millisecondsSince(start);
+}
+
+const std::vector<uint32_t>& SceneTree::cull(const glm::mat4& viewProjection)
+{
+	auto start = std::chrono::steady_clock::now();
+	glm::vec4 planes[6];
+	FrustumCuller::extractPlanes(viewProjection, planes);
+
+	m_visible.clear();
+	m_tree.queryFrustum([&](int proxyId)
+		{
+			uint32_t index = m_tree.getUserData(proxyId);
+			if (touchesFrustum(m_bounds[index], planes))
+			{
+				m_visible.push_back(index);
+			}
+			return true;
+		}, planes);
+
+	m_stats.visible = static_cast<unsigned>(m_visible.size());
+	m_stats.cullMilliseconds = millisecondsSince(start);
+	return m_visible;
+}
+
+int SceneTree::pick(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const
+{
+	glm::vec3 inverseDirection = 1.0f / direction;
+	int closest = -1;
+	m_tree.rayCast([&](const RayCastInput& input, int proxyId)
+		{
+			uint32_t index = m_tree.getUserData(proxyId);
+			float distance = m_bounds[index].rayCast(input.origin, inverseDirection, input.maxDistance);
+			if (distance < 0.0f)
+			{
+				return -1.0f;
+			}
+			closest = static_cast<int>(index);
+			// Só o que estiver mais perto que este acerto ainda interessa
+			return std::max(distance, 1e-6f);
+		}, { origin, direction, maxDistance });
+	return closest;
+}
+
+void SceneTree::queryOverlaps(const Aabb& aabb, std::vector<uint32_t>& result) const
+{
+	m_tree.query([&](int proxyId)
+		{
+			uint32_t index = m_tree.getUserData(proxyId);
+			if (m_bounds[index].overlaps(aabb))
+			{
+				result.push_back(index);
+			}
+			return true;
+		}, aabb);
+}
+
+void SceneTree::benchmark(const glm::mat4& viewProjection, const glm::vec3& origin, const glm::vec3& direction) const
+{
+	if (m_tree.getProxyCount() == 0)
+	{
+		return;
+	}
+	glm::vec4 planes[6];
+	FrustumCuller::extractPlanes(viewProjection, planes);
+	glm::vec3 inverseDirection = 1.0f / direction;
+	const float maxDistance = 1e6f;
+	const int repeats = 10;
+
+	// Frustum
+	std::vector<uint32_t> result;
+	auto start = std::chrono::steady_clock::now();
+	for (int r = 0; r < repeats; ++r)
+	{
+		result.clear();
+		for (size_t i = 0; i < m_bounds.size(); ++i)
+		{
+			if (m_proxies[i] != DynamicTree::NULL_NODE && touchesFrustum(m_bounds[i], planes))
+			{
+				result.push_back(static_cast<uint32_t>(i));
+			}
+		}
+	}
+	double linearFrustum = millisecondsSince(start) / repeats;
+	size_t linearVisible = result.size();
+
+	start = std::chrono::steady_clock::now();
+	for (int r = 0; r < repeats; ++r)
+	{
+		result.clear();
+		m_tree.queryFrustum([&](int proxyId)
+			{
+				uint32_t index = m_tree.getUserData(proxyId);
+				if (touchesFrustum(m_bounds[index], planes))
+				{
+					result.push_back(index);
+				}
+				return true;
+			}, planes);
+	}
+	double treeFrustum = millisecondsSince(start) / repeats;
+	size_t treeVisible = result.size();
+
+	// Raio
+	int linearHit = -1;
+	start = std::chrono::steady_clock::now();
+	for (int r = 0; r < repeats; ++r)
+	{
+		float closest = maxDistance;
+		linearHit = -1;
+		for (size_t i = 0; i < m_bounds.size(); ++i)
+		{
+			if (m_proxies[i] == DynamicTree::NULL_NODE)
+			{
+				continue;
+			}
+			float distance = m_bounds[i].rayCast(origin, inverseDirection, closest);
+			if (distance >= 0.0f && (linearHit < 0 || distance < closest))
+			{
+				closest = distance;
+				linearHit = static_cast<int>(i);
+			}
+		}
+	}
+	double linearRay = millisecondsSince(start) / repeats;
+
+	int treeHit = -1;
+	start = std::chrono::steady_clock::now();
+	for (int r = 0; r < repeats; ++r)
+	{
+		treeHit = pick(origin, direction, maxDistance);
+	}
+	double treeRay = millisecondsSince(start) / repeats;
+
+	// Sobreposição: a caixa de cada objeto amostrado contra toda a cena
+	size_t samples = std::min<size_t>(100, m_bounds.size());
+	size_t stride = m_bounds.size() / samples;
+	size_t linearOverlaps = 0, treeOverlaps = 0;
+	start = std::chrono::steady_clock::now();
+	for (size_t s = 0; s < samples; ++s)
+	{
+		const Aabb& query = m_bounds[s * stride];
+		for (size_t i = 0; i < m_bounds.size(); ++i)
+		{
+			if (m_proxies[i] != DynamicTree::NULL_NODE && m_bounds[i].overlaps(query))
+			{
+				linearOverlaps++;
+			}
+		}
+	}
+	double linearOverlap = millisecondsSince(start) / samples;
+
+	start = std::chrono::steady_clock::now();
+	for (size_t s = 0; s < samples; ++s)
+	{
+		result.clear();
+		queryOverlaps(m_bounds[s * stride], result);
+		treeOverlaps += result.size();
+	}
+	double treeOverlap = millisecondsSince(start) / samples;
+
+	std::cout << "BVH benchmark over " << m_tree.getProxyCount() << " objects (height " << m_tree.getHeight()
+		<< ", area ratio " << m_tree.getAreaRatio() << ")" << std::endl;
+	std::cout << "  frustum: tree " << treeFrustum << " ms, linear " << linearFrustum << " ms ("
+		<< treeVisible << " / " << linearVisible << " visible)" << std::endl;
+	std::cout << "  ray: tree " << treeRay << " ms, linear " << linearRay << " ms (hit "
+		<< treeHit << " / " << linearHit << ")" << std::endl;
+	std::cout << "  overlap: tree " << treeOverlap << " ms, linear " << linearOverlap << " ms ("
+		<< treeOverlaps << " / " << linearOverlaps << " pairs over " << samples << " queries)" << std::endl;
+}
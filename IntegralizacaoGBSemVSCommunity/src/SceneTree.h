@@ -0,0 +1,51 @@
+#pragma once
+#include "DynamicTree.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+class Scene;
+
+// Índice espacial dos objetos da cena: um proxy do DynamicTree por objeto
+// com malha, identificado pela posição do objeto no vetor. A cada quadro
+// sync() recalcula as AABBs no mundo e só reinsere na árvore os objetos que
+// saíram da caixa gorda; as consultas confirmam os candidatos da árvore
+// contra a AABB justa.
+class SceneTree
+{
+public:
+	struct Stats
+	{
+		unsigned proxies = 0;
+		unsigned reinserted = 0;
+		unsigned visible = 0;
+		int height = 0;
+		double syncMilliseconds = 0.0;
+		double cullMilliseconds = 0.0;
+	};
+
+	// Cria, move ou remove proxies para acompanhar a lista de objetos
+	void sync(const Scene& scene);
+
+	// Índices dos objetos que tocam o frustum de viewProjection
+	const std::vector<uint32_t>& cull(const glm::mat4& viewProjection);
+	// Objeto mais próximo atravessado pelo raio, ou -1
+	int pick(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const;
+	// Índices dos objetos cuja AABB toca aabb
+	void queryOverlaps(const Aabb& aabb, std::vector<uint32_t>& result) const;
+
+	// Mede as três consultas contra varreduras lineares das mesmas AABBs e
+	// imprime os tempos
+	void benchmark(const glm::mat4& viewProjection, const glm::vec3& origin, const glm::vec3& direction) const;
+
+	const Aabb& getBounds(size_t index) const { return m_bounds[index]; }
+	const DynamicTree& getTree() const { return m_tree; }
+	const Stats& getStats() const { return m_stats; }
+private:
+	DynamicTree m_tree;
+	std::vector<int> m_proxies;   // DynamicTree::NULL_NODE para objetos sem malha
+	std::vector<Aabb> m_bounds;
+	std::vector<Aabb> m_newBounds;   // calculadas no sync em andamento
+	std::vector<uint32_t> m_visible;
+	Stats m_stats;
+};
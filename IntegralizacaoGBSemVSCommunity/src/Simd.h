@@ -0,0 +1,15 @@
+#pragma once
+
+// Seleção das extensões SIMD disponíveis na compilação. GB_USE_SSE vale para
+// qualquer x86-64 (SSE2 faz parte da arquitetura); GB_USE_AVX só quando o
+// compilador foi chamado com AVX habilitado (-mavx / /arch:AVX, a opção
+// GB_AVX do CMake).
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GB_USE_SSE 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX__)
+#define GB_USE_AVX 1
+#include <immintrin.h>
+#endif
@@ -0,0 +1,103 @@
+#include "SimulationClock.h"
+#include "PathSystem.h"
+#include "Scene.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+unsigned SimulationClock::advance(double now)
+{
+	if (m_last < 0.0)
+	{
+		m_last = now;
+	}
+	double elapsed = std::max(now - m_last, 0.0);
+	m_last = now;
+	m_accumulator += elapsed;
+
+	unsigned steps = 0;
+	while (m_accumulator >= STEP)
+	{
+		m_accumulator -= STEP;
+		if (steps < MAX_STEPS_PER_FRAME)
+		{
+			++steps;
+		}
+		else
+		{
+			m_stats.droppedSteps++;
+		}
+	}
+
+	m_stats.steps = steps;
+	m_stats.totalSteps += steps;
+	m_stats.alpha = getAlpha();
+	m_stats.frameMilliseconds = elapsed * 1000.0;
+	return steps;
+}
+
+void SimulationClock::benchmark(size_t paths)
+{
+	const double SECONDS = 10.0;
+	const double RATES[] = { 30.0, 60.0, 144.0, 1000.0 };
+	const size_t WAYPOINTS = 4;
+
+	// Posições dos caminhos depois de SECONDS segundos desenhados a rate
+	// quadros por segundo; fixedStep escolhe entre o relógio e um passo por quadro
+	auto simulate = [&](double rate, bool fixedStep, uint64_t& steps)
+		{
+			std::mt19937 random(42);
+			std::uniform_real_distribution<float> position(-100.0f, 100.0f), offset(-10.0f, 10.0f);
+			Scene scene;
+			for (size_t i = 0; i < paths; ++i)
+			{
+				Entity entity = scene.createEntity();
+				glm::vec3 origin(position(random), position(random), position(random));
+				for (size_t w = 0; w < WAYPOINTS; ++w)
+				{
+					scene.addWaypoint(entity, origin + glm::vec3(offset(random), offset(random), offset(random)) * float(w + 1));
+				}
+			}
+
+			PathSystem pathSystem;
+			SimulationClock clock;
+			steps = 0;
+			size_t frames = static_cast<size_t>(std::lround(SECONDS * rate));
+			for (size_t frame = 0; frame <= frames; ++frame)
+			{
+				unsigned frameSteps = fixedStep ? clock.advance(frame / rate) : (frame > 0 ? 1 : 0);
+				for (unsigned step = 0; step < frameSteps; ++step)
+				{
+					pathSystem.update(scene);
+				}
+				steps += frameSteps;
+			}
+			// O que seria desenhado no último quadro
+			pathSystem.interpolate(scene, fixedStep ? clock.getAlpha() : 1.0f);
+			std::vector<glm::vec3> positions;
+			for (const Transform& transform : scene.getTransforms())
+			{
+				positions.push_back(transform.position);
+			}
+			return positions;
+		};
+
+	uint64_t referenceSteps = 0;
+	std::vector<glm::vec3> reference = simulate(60.0, true, referenceSteps);
+	std::cout << "Paths: " << paths << ", " << SECONDS << " s simulated, distance from the 60 fps fixed step result:" << std::endl;
+	for (double rate : RATES)
+	{
+		for (bool fixedStep : { true, false })
+		{
+			uint64_t steps = 0;
+			std::vector<glm::vec3> positions = simulate(rate, fixedStep, steps);
+			float maxDistance = 0.0f;
+			for (size_t i = 0; i < positions.size(); ++i)
+			{
+				maxDistance = std::max(maxDistance, glm::length(positions[i] - reference[i]));
+			}
+			std::cout << "  " << rate << " fps, " << (fixedStep ? "fixed step" : "per frame") << ": " << steps << " steps, max distance " << maxDistance << std::endl;
+		}
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Relógio da simulação em passo fixo, separado do desenho. A cada quadro
+// advance() soma o tempo real desde o quadro anterior num acumulador e
+// devolve quantos passos de STEP segundos rodar; o que sobra (menos de um
+// passo) vira getAlpha(), a fração usada para interpolar entre o estado do
+// passo anterior e o do atual na hora de desenhar. Assim a câmera e os
+// caminhos andam o mesmo tanto por segundo a 30 ou a 1000 quadros por
+// segundo, e o resultado da simulação só depende do número de passos.
+//
+// Um quadro muito longo (depurador, janela arrastada) roda no máximo
+// MAX_STEPS_PER_FRAME passos; o resto do atraso é descartado.
+class SimulationClock
+{
+public:
+	static constexpr double STEP = 1.0 / 60.0;
+	static constexpr unsigned MAX_STEPS_PER_FRAME = 8;
+
+	struct Stats
+	{
+		unsigned steps = 0;          // passos no último quadro
+		uint64_t totalSteps = 0;
+		uint64_t droppedSteps = 0;
+		float alpha = 0.0f;
+		double frameMilliseconds = 0.0;
+	};
+
+	// now em segundos (glfwGetTime); o primeiro quadro só começa a contar
+	unsigned advance(double now);
+
+	float getAlpha() const { return static_cast<float>(m_accumulator / STEP); }
+	uint64_t getStep() const { return m_stats.totalSteps; }
+
+	// Os mesmos caminhos simulados por alguns segundos a várias taxas de
+	// quadros, em passo fixo e com o avanço por quadro de antes
+	// (--benchmark-timestep N caminhos)
+	static void benchmark(size_t paths);
+
+	const Stats& getStats() const { return m_stats; }
+private:
+	double m_last = -1.0;
+	double m_accumulator = 0.0;
+	Stats m_stats;
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+// Fila circular de tamanho fixo para um produtor e um consumidor, sem trava:
+// cada lado só escreve o seu índice (head no push, tail no pop) e lê o do
+// outro com acquire, então o item já está escrito quando o índice aparece.
+// Cheia, push() devolve false e quem produz decide o que perder.
+template <typename T, size_t CAPACITY>
+class SpscQueue
+{
+	static_assert((CAPACITY & (CAPACITY - 1)) == 0, "SpscQueue capacity must be a power of two");
+public:
+	bool push(const T& value)
+	{
+		size_t head = m_head.load(std::memory_order_relaxed);
+		if (head - m_tail.load(std::memory_order_acquire) == CAPACITY)
+		{
+			return false;
+		}
+		m_items[head & (CAPACITY - 1)] = value;
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool pop(T& value)
+	{
+		size_t tail = m_tail.load(std::memory_order_relaxed);
+		if (tail == m_head.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+		value = m_items[tail & (CAPACITY - 1)];
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+private:
+	T m_items[CAPACITY];
+	alignas(64) std::atomic<size_t> m_head{ 0 };
+	alignas(64) std::atomic<size_t> m_tail{ 0 };
+};
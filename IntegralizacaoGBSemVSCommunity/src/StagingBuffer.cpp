@@ -0,0 +1,100 @@
+#include "StagingBuffer.h"
+#include "GlState.h"
+
+void StagingBuffer::init(size_t capacity)
+{
+	if (m_buffer != 0)
+	{
+		return;
+	}
+
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	m_capacity = capacity;
+	glGenBuffers(1, &m_buffer);
+	GlState::get().bindBuffer(GL_COPY_READ_BUFFER, m_buffer);
+	glBufferStorage(GL_COPY_READ_BUFFER, m_capacity, nullptr, flags);
+	m_data = static_cast<char*>(glMapBufferRange(GL_COPY_READ_BUFFER, 0, m_capacity, flags));
+	GlState::get().bindBuffer(GL_COPY_READ_BUFFER, 0);
+}
+
+void StagingBuffer::destroy()
+{
+	for (Region& region : m_inFlight)
+	{
+		glDeleteSync(region.fence);
+	}
+	m_inFlight.clear();
+	if (m_buffer != 0)
+	{
+		GlState::get().bindBuffer(GL_COPY_READ_BUFFER, m_buffer);
+		glUnmapBuffer(GL_COPY_READ_BUFFER);
+		GlState::get().bindBuffer(GL_COPY_READ_BUFFER, 0);
+		GlState::get().deleteBuffers(1, &m_buffer);
+	}
+	m_buffer = 0;
+	m_data = nullptr;
+	m_capacity = m_head = m_used = m_unfenced = 0;
+}
+
+char* StagingBuffer::allocate(size_t bytes, size_t& offset)
+{
+	bytes = (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+	if (!m_data || bytes > m_capacity)
+	{
+		return nullptr;
+	}
+
+	// Não cabe no fim: o que sobrou lá conta como usado até o próximo
+	// fence liberar, e a escrita volta para o começo
+	if (m_head + bytes > m_capacity)
+	{
+		size_t tail = m_capacity - m_head;
+		if (m_used + tail + bytes > m_capacity)
+		{
+			return nullptr;
+		}
+		m_used += tail;
+		m_unfenced += tail;
+		m_head = 0;
+	}
+	if (m_used + bytes > m_capacity)
+	{
+		return nullptr;
+	}
+
+	offset = m_head;
+	m_head += bytes;
+	m_used += bytes;
+	m_unfenced += bytes;
+	return m_data + offset;
+}
+
+void StagingBuffer::fence()
+{
+	if (m_unfenced == 0)
+	{
+		return;
+	}
+	m_inFlight.push_back({ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), m_unfenced });
+	m_unfenced = 0;
+}
+
+void StagingBuffer::retire()
+{
+	while (!m_inFlight.empty())
+	{
+		GLenum status = glClientWaitSync(m_inFlight.front().fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+		{
+			break;
+		}
+		glDeleteSync(m_inFlight.front().fence);
+		m_used -= m_inFlight.front().bytes;
+		m_inFlight.pop_front();
+	}
+	// Vazio: recomeça do início, com o anel inteiro contíguo
+	if (m_used == 0)
+	{
+		m_head = 0;
+	}
+}
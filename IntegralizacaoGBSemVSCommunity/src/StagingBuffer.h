@@ -0,0 +1,47 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+#include <deque>
+
+// Buffer de upload mapeado de forma persistente (glBufferStorage com
+// MAP_PERSISTENT | MAP_COHERENT), usado como anel. Quem envia escreve direto
+// no ponteiro mapeado e pede a cópia para o destino (glCopyBufferSubData
+// para o GeometryPool, glTexSubImage2D com o anel como PIXEL_UNPACK para
+// texturas): a chamada só enfileira o trabalho na GPU, sem a cópia síncrona
+// do glBufferSubData nem a espera por um buffer que os desenhos em andamento
+// ainda leem.
+//
+// fence() fecha o que foi escrito desde a última chamada; o espaço volta
+// para o anel em retire(), depois que a GPU passou do fence.
+class StagingBuffer
+{
+public:
+	// Offsets alinhados para qualquer formato de pixel e para cópias de buffer
+	static constexpr size_t ALIGNMENT = 64;
+
+	void init(size_t capacity);
+	void destroy();
+
+	// bytes contíguos, ou nullptr se o anel está cheio até a GPU liberar algo
+	char* allocate(size_t bytes, size_t& offset);
+	void fence();
+	void retire();
+
+	GLuint getBuffer() const { return m_buffer; }
+	size_t getCapacity() const { return m_capacity; }
+	size_t getUsed() const { return m_used; }
+private:
+	struct Region
+	{
+		GLsync fence;
+		size_t bytes;
+	};
+
+	GLuint m_buffer = 0;
+	char* m_data = nullptr;
+	size_t m_capacity = 0;
+	size_t m_head = 0;       // próxima escrita
+	size_t m_used = 0;       // escrito e ainda não liberado (inclui o que sobrou no fim ao dar a volta)
+	size_t m_unfenced = 0;   // parte de m_used ainda sem fence
+	std::deque<Region> m_inFlight;
+};
@@ -0,0 +1,246 @@
+#include "TransformSystem.h"
+#include "JobSystem.h"
+#include "Simd.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+namespace
+{
+	const size_t LANES = 4;
+	// Transformações sujas por job (múltiplo de LANES)
+	const size_t TRANSFORMS_PER_JOB = 4096;
+
+	double millisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+void TransformSystem::Batch::resize(size_t count)
+{
+	size_t padded = (count + LANES - 1) / LANES * LANES;
+	std::vector<float>* identity0[] = { &positionX, &positionY, &positionZ, &rotationX, &rotationY, &rotationZ };
+	std::vector<float>* identity1[] = { &rotationW, &scaleX, &scaleY, &scaleZ };
+	for (std::vector<float>* values : identity0)
+	{
+		values->resize(padded);
+		std::fill(values->begin() + count, values->end(), 0.0f);
+	}
+	for (std::vector<float>* values : identity1)
+	{
+		values->resize(padded);
+		std::fill(values->begin() + count, values->end(), 1.0f);
+	}
+}
+
+void TransformSystem::Batch::set(size_t index, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+	positionX[index] = position.x;
+	positionY[index] = position.y;
+	positionZ[index] = position.z;
+	rotationX[index] = rotation.x;
+	rotationY[index] = rotation.y;
+	rotationZ[index] = rotation.z;
+	rotationW[index] = rotation.w;
+	scaleX[index] = scale.x;
+	scaleY[index] = scale.y;
+	scaleZ[index] = scale.z;
+}
+
+glm::quat TransformSystem::eulerToQuat(const glm::vec3& angles)
+{
+	return glm::angleAxis(angles.x, glm::vec3(1.0f, 0.0f, 0.0f))
+		* glm::angleAxis(angles.y, glm::vec3(0.0f, 1.0f, 0.0f))
+		* glm::angleAxis(angles.z, glm::vec3(0.0f, 0.0f, 1.0f));
+}
+
+glm::mat4 TransformSystem::compose(const glm::vec3& position, const glm::quat& q, const glm::vec3& scale)
+{
+	float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+	float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+	float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+	glm::mat4 model;
+	model[0] = glm::vec4(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f) * scale.x;
+	model[1] = glm::vec4(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f) * scale.y;
+	model[2] = glm::vec4(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f) * scale.z;
+	model[3] = glm::vec4(position, 1.0f);
+	return model;
+}
+
+void TransformSystem::composeBatch(const Batch& batch, size_t begin, size_t end, glm::mat4* out)
+{
+	size_t i = begin;
+#ifdef GB_USE_SSE
+	// 4 transformações por iteração; as colunas saem transpostas (um
+	// registrador por componente) e viram 4 matrizes com _MM_TRANSPOSE4_PS
+	const __m128 one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f), zero = _mm_setzero_ps();
+	for (; i + LANES <= end; i += LANES)
+	{
+		__m128 x = _mm_loadu_ps(&batch.rotationX[i]), y = _mm_loadu_ps(&batch.rotationY[i]);
+		__m128 z = _mm_loadu_ps(&batch.rotationZ[i]), w = _mm_loadu_ps(&batch.rotationW[i]);
+		__m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+		__m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+		__m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+		__m128 sx = _mm_loadu_ps(&batch.scaleX[i]), sy = _mm_loadu_ps(&batch.scaleY[i]), sz = _mm_loadu_ps(&batch.scaleZ[i]);
+
+		__m128 c0x = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+		__m128 c0y = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+		__m128 c0z = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+		__m128 c1x = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+		__m128 c1y = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+		__m128 c1z = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+		__m128 c2x = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+		__m128 c2y = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+		__m128 c2z = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+		__m128 c3x = _mm_loadu_ps(&batch.positionX[i]), c3y = _mm_loadu_ps(&batch.positionY[i]), c3z = _mm_loadu_ps(&batch.positionZ[i]);
+		__m128 c0w = zero, c1w = zero, c2w = zero, c3w = one;
+
+		_MM_TRANSPOSE4_PS(c0x, c0y, c0z, c0w);
+		_MM_TRANSPOSE4_PS(c1x, c1y, c1z, c1w);
+		_MM_TRANSPOSE4_PS(c2x, c2y, c2z, c2w);
+		_MM_TRANSPOSE4_PS(c3x, c3y, c3z, c3w);
+		__m128 columns[4][4] = {
+			{ c0x, c1x, c2x, c3x },
+			{ c0y, c1y, c2y, c3y },
+			{ c0z, c1z, c2z, c3z },
+			{ c0w, c1w, c2w, c3w } };
+		for (size_t lane = 0; lane < LANES; ++lane)
+		{
+			float* matrix = &out[i + lane][0][0];
+			for (int column = 0; column < 4; ++column)
+			{
+				_mm_storeu_ps(matrix + column * 4, columns[lane][column]);
+			}
+		}
+	}
+#endif
+	for (; i < end; ++i)
+	{
+		out[i] = compose(glm::vec3(batch.positionX[i], batch.positionY[i], batch.positionZ[i]),
+			glm::quat(batch.rotationW[i], batch.rotationX[i], batch.rotationY[i], batch.rotationZ[i]),
+			glm::vec3(batch.scaleX[i], batch.scaleY[i], batch.scaleZ[i]));
+	}
+}
+
+void TransformSystem::update(std::vector<Transform>& transforms, std::vector<glm::mat4>& models)
+{
+	auto start = std::chrono::steady_clock::now();
+	m_dirty.clear();
+	for (size_t i = 0; i < transforms.size(); ++i)
+	{
+		if (transforms[i].dirty)
+		{
+			m_dirty.push_back(static_cast<uint32_t>(i));
+		}
+	}
+
+	// Cada bloco junta, compõe e devolve só os seus; as entidades são distintas
+	m_batch.resize(m_dirty.size());
+	m_world.resize(m_dirty.size());
+	JobSystem& jobs = JobSystem::get();
+	jobs.wait(jobs.parallelFor(m_dirty.size(), TRANSFORMS_PER_JOB, [&](size_t begin, size_t end)
+		{
+			for (size_t k = begin; k < end; ++k)
+			{
+				const Transform& transform = transforms[m_dirty[k]];
+				m_batch.set(k, transform.position, transform.rotation, transform.scale);
+			}
+			composeBatch(m_batch, begin, end, m_world.data());
+			for (size_t k = begin; k < end; ++k)
+			{
+				models[m_dirty[k]] = m_world[k];
+				transforms[m_dirty[k]].dirty = false;
+			}
+		}));
+
+	m_stats.objects = static_cast<unsigned>(transforms.size());
+	m_stats.dirty = static_cast<unsigned>(m_dirty.size());
+	m_stats.composeMilliseconds = millisecondsSince(start);
+}
+
+void TransformSystem::benchmark(size_t count)
+{
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f), angle(-3.14159f, 3.14159f), scale(0.5f, 2.0f);
+	std::vector<glm::vec3> positions(count), angles(count), scales(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		positions[i] = glm::vec3(position(random), position(random), position(random));
+		angles[i] = glm::vec3(angle(random), angle(random), angle(random));
+		scales[i] = glm::vec3(scale(random), scale(random), scale(random));
+	}
+	std::vector<glm::mat4> chain(count), scalar(count), batched(count);
+
+	// O Object::getModelMatrix de antes
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < count; ++i)
+	{
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), positions[i]);
+		model = glm::rotate(model, angles[i].x, glm::vec3(1.0f, 0.0f, 0.0f));
+		model = glm::rotate(model, angles[i].y, glm::vec3(0.0f, 1.0f, 0.0f));
+		model = glm::rotate(model, angles[i].z, glm::vec3(0.0f, 0.0f, 1.0f));
+		chain[i] = glm::scale(model, scales[i]);
+	}
+	double chainMilliseconds = millisecondsSince(start);
+
+	// A rotação vira quaternion quando muda (setRotateAngle), fora do quadro
+	std::vector<glm::quat> rotations(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		rotations[i] = eulerToQuat(angles[i]);
+	}
+
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < count; ++i)
+	{
+		scalar[i] = compose(positions[i], rotations[i], scales[i]);
+	}
+	double scalarMilliseconds = millisecondsSince(start);
+
+	Batch batch;
+	batch.resize(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		batch.set(i, positions[i], rotations[i], scales[i]);
+	}
+	start = std::chrono::steady_clock::now();
+	composeBatch(batch, 0, count, batched.data());
+	double batchMilliseconds = millisecondsSince(start);
+
+	float maxError = 0.0f;
+	for (size_t i = 0; i < count; ++i)
+	{
+		for (int column = 0; column < 4; ++column)
+		{
+			glm::vec4 difference = glm::abs(chain[i][column] - batched[i][column]);
+			maxError = std::max(maxError, std::max(std::max(difference.x, difference.y), std::max(difference.z, difference.w)));
+		}
+	}
+
+	// Quadro típico: só uma parte se move, o resto não custa nada além da varredura
+	std::vector<Transform> transforms(count);
+	std::vector<glm::mat4> models(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		transforms[i].setPosition(positions[i]);
+		transforms[i].setRotateAngle(angles[i]);
+		transforms[i].setScale(scales[i]);
+	}
+	TransformSystem system;
+	system.update(transforms, models);
+	for (size_t i = 0; i < count; i += 10)
+	{
+		transforms[i].setPosition(positions[i] + glm::vec3(1.0f));
+	}
+	system.update(transforms, models);
+
+	std::cout << "Transforms: " << count << ", glm chain: " << chainMilliseconds << " ms"
+		<< ", quaternion: " << scalarMilliseconds << " ms"
+		<< ", SSE batch: " << batchMilliseconds << " ms"
+		<< ", 10% dirty update: " << system.getStats().composeMilliseconds << " ms"
+		<< ", max error vs chain: " << maxError << std::endl;
+}
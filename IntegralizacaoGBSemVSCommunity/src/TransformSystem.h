@@ -0,0 +1,59 @@
+#pragma once
+#include "Scene.h"
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cstdint>
+#include <vector>
+
+// Matrizes model em cache. Cada Transform guarda a sua e uma flag de sujo,
+// ligada por setPosition, setScale e setRotateAngle; as entidades paradas
+// nunca recalculam. Uma vez por quadro update() junta os sujos em SoA
+// (posição, quaternion, escala), compõe as matrizes 4 por vez com SSE num
+// array contíguo e devolve cada uma à sua entidade; os sujos são divididos
+// em blocos no JobSystem.
+//
+// A rotação é o quaternion de Rx * Ry * Rz, a mesma ordem dos três
+// glm::rotate de antes, então o resultado é o mesmo de translate * rotate * scale.
+class TransformSystem
+{
+public:
+	struct Stats
+	{
+		unsigned objects = 0;
+		unsigned dirty = 0;
+		double composeMilliseconds = 0.0;
+	};
+
+	// Transformações em SoA; o tamanho é arredondado para múltiplo de 4 e as
+	// sobras ficam com a identidade
+	struct Batch
+	{
+		std::vector<float> positionX, positionY, positionZ;
+		std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+		std::vector<float> scaleX, scaleY, scaleZ;
+
+		void resize(size_t count);
+		void set(size_t index, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+	};
+
+	static glm::quat eulerToQuat(const glm::vec3& angles);
+	static glm::mat4 compose(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+	// Compõe as transformações [begin, end) de batch em out (mesmo índice)
+	static void composeBatch(const Batch& batch, size_t begin, size_t end, glm::mat4* out);
+
+	// Recalcula em models (mesmo índice) as matrizes dos Transform sujos
+	void update(std::vector<Transform>& transforms, std::vector<glm::mat4>& models);
+	// Entidades recompostas no último update (o RenderThread só copia estas)
+	const std::vector<uint32_t>& getDirty() const { return m_dirty; }
+
+	// Cadeia glm antiga x quaternion escalar x lote SSE (todos ou 10% sujos)
+	// sobre count transformações aleatórias (--benchmark-transforms N)
+	static void benchmark(size_t count);
+
+	const Stats& getStats() const { return m_stats; }
+private:
+	std::vector<uint32_t> m_dirty;
+	Batch m_batch;
+	std::vector<glm::mat4> m_world;
+	Stats m_stats;
+};
@@ -0,0 +1,43 @@
+#include "UniformBuffers.h"
+#include "Camera.h"
+#include "GlState.h"
+
+void UniformBuffers::init()
+{
+	m_frame = FrameBlock();
+
+	glGenBuffers(1, &m_frameUBO);
+	GlState::get().bindBuffer(GL_UNIFORM_BUFFER, m_frameUBO);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameBlock), &m_frame, GL_DYNAMIC_DRAW);
+	GlState::get().bindBufferBase(GL_UNIFORM_BUFFER, FRAME_UBO_BINDING, m_frameUBO);
+	GlState::get().bindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	m_frameDirty = false;
+	m_uploads = 0;
+}
+
+void UniformBuffers::destroy()
+{
+	GlState::get().deleteBuffers(1, &m_frameUBO);
+	m_frameUBO = 0;
+}
+
+void UniformBuffers::setCamera(const Camera& camera)
+{
+	m_frame.view = camera.getViewMatrix();
+	m_frame.projection = camera.getProjectionMatrix();
+	m_frame.camPos = glm::vec4(camera.getPosition(), 1.0f);
+	m_frameDirty = true;
+}
+
+void UniformBuffers::upload()
+{
+	if (!m_frameDirty)
+	{
+		return;
+	}
+	GlState::get().bindBuffer(GL_UNIFORM_BUFFER, m_frameUBO);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameBlock), &m_frame);
+	m_frameDirty = false;
+	m_uploads++;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+class Camera;
+
+// Ponto de ligação do bloco FrameBlock nos shaders (layout(binding = N))
+const GLuint FRAME_UBO_BINDING = 0;
+
+// Espelho std140 do bloco FrameBlock do shader: vec3 ocupa 16 bytes, então
+// tudo é guardado como vec4
+struct FrameBlock
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::vec4 camPos;
+};
+
+// Dono do UBO por quadro compartilhado pelos shaders. As mudanças só marcam o
+// bloco como sujo; upload() faz no máximo um glBufferSubData por quadro.
+// As luzes ficam no LightClusters.
+class UniformBuffers
+{
+public:
+	void init();
+	void destroy();
+
+	void setCamera(const Camera& camera);
+	void upload();
+
+	unsigned getUploads() const { return m_uploads; }
+private:
+	GLuint m_frameUBO = 0;
+	FrameBlock m_frame;
+	bool m_frameDirty = false;
+	unsigned m_uploads = 0;
+};